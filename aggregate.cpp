@@ -0,0 +1,375 @@
+#include "aggregate.h"
+#include "containers.h"
+#include "sorts.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// pre-aggregation table of a hash path thread, spilled at half load so probes
+// stay short, a few hundred kilobytes with the group array so it lives in l2
+static const uint32_t aggregate_local_slots = 16384;
+static const uint32_t aggregate_local_groups = aggregate_local_slots / 2;
+using aggregatelocal_t = basic_hashtable_t<uint32_t, uint16_t, fixed_capacity_t<aggregate_local_slots>>;
+using aggregateseen_t = basic_hashtable_t<uint64_t, uint8_t, fixed_capacity_t<aggregate_local_slots>>;
+
+// the auto path sorts once the groups (or the (key, value) pairs for distinct)
+// overflow the pre-aggregation table, past that nearly every row is spilled and
+// merged again, which costs more than the sort (see bench_aggregate)
+static const size_t aggregate_sort_groups = aggregate_local_groups;
+
+aggregateresult_t::~aggregateresult_t()
+{
+	free(groups);
+}
+
+aggregategroup_t & aggregateresult_t::push(const aggregategroup_t & group)
+{
+	if(count == capacity)
+	{
+		capacity = capacity ? capacity * 2 : 1024;
+		groups = (aggregategroup_t*)realloc(groups, capacity * sizeof(aggregategroup_t));
+	}
+	groups[count] = group;
+	return groups[count++];
+}
+
+void aggregateresult_t::append(const aggregateresult_t & other)
+{
+	if(count + other.count > capacity)
+	{
+		capacity = count + other.count;
+		groups = (aggregategroup_t*)realloc(groups, capacity * sizeof(aggregategroup_t));
+	}
+	if(other.count)
+		memcpy(groups + count, other.groups, other.count * sizeof(aggregategroup_t));
+	count += other.count;
+}
+
+void aggregateresult_t::sort()
+{
+	if(count < 2)
+		return;
+	uint32_t * keys = (uint32_t*)malloc(count * sizeof(uint32_t));
+	uint32_t * order = (uint32_t*)malloc(count * sizeof(uint32_t));
+	aggregategroup_t * sorted = (aggregategroup_t*)malloc(capacity * sizeof(aggregategroup_t));
+	for(size_t i = 0; i < count; ++i)
+	{
+		keys[i] = groups[i].key;
+		order[i] = (uint32_t)i;
+	}
+	sorts_radixsort_pairs(keys, order, count);
+	for(size_t i = 0; i < count; ++i)
+		sorted[i] = groups[order[i]];
+	free(groups);
+	groups = sorted;
+	free(keys);
+	free(order);
+}
+
+static inline aggregategroup_t aggregate_group(uint32_t key)
+{
+	return {key, UINT32_MAX, 0, 0, 0, 0};
+}
+
+static inline void aggregate_add(aggregategroup_t & group, uint32_t value)
+{
+	++group.count;
+	group.sum += value;
+	group.min = value < group.min ? value : group.min;
+	group.max = value > group.max ? value : group.max;
+}
+
+static inline void aggregate_merge(aggregategroup_t & group, const aggregategroup_t & other)
+{
+	group.count += other.count;
+	group.sum += other.sum;
+	group.min = other.min < group.min ? other.min : group.min;
+	group.max = other.max > group.max ? other.max : group.max;
+}
+
+void aggregate_accumulate(aggregategroup_t & group, const uint32_t * values, size_t count)
+{
+	size_t i = 0;
+	uint64_t sum = 0;
+	uint32_t min = group.min, max = group.max;
+	#if defined(__AVX2__)
+	if(count >= 16)
+	{
+		// unsigned min / max in 8 lanes, the sum widened to 64 bits in two halves
+		__m256i vmin = _mm256_set1_epi32((int)min), vmax = _mm256_set1_epi32((int)max);
+		__m256i vsum_low = _mm256_setzero_si256(), vsum_high = _mm256_setzero_si256();
+		for(; i + 8 <= count; i += 8)
+		{
+			__m256i v = _mm256_loadu_si256((const __m256i*)(values + i));
+			vmin = _mm256_min_epu32(vmin, v);
+			vmax = _mm256_max_epu32(vmax, v);
+			vsum_low = _mm256_add_epi64(vsum_low, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+			vsum_high = _mm256_add_epi64(vsum_high, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+		}
+		uint32_t mins[8], maxs[8];
+		uint64_t sums[4];
+		_mm256_storeu_si256((__m256i*)mins, vmin);
+		_mm256_storeu_si256((__m256i*)maxs, vmax);
+		_mm256_storeu_si256((__m256i*)sums, _mm256_add_epi64(vsum_low, vsum_high));
+		for(uint32_t lane = 0; lane < 8; ++lane)
+		{
+			min = mins[lane] < min ? mins[lane] : min;
+			max = maxs[lane] > max ? maxs[lane] : max;
+		}
+		sum = sums[0] + sums[1] + sums[2] + sums[3];
+	}
+	#endif
+	for(; i < count; ++i)
+	{
+		sum += values[i];
+		min = values[i] < min ? values[i] : min;
+		max = values[i] > max ? values[i] : max;
+	}
+	group.count += count;
+	group.sum += sum;
+	group.min = min;
+	group.max = max;
+}
+
+size_t aggregate_cardinality(const uint32_t * keys, const uint32_t * values, size_t count, size_t sample)
+{
+	if(!count)
+		return 0;
+	sample = sample && sample < count ? sample : count;
+	size_t step = count / sample;
+	basic_hashtable_t<uint64_t, uint32_t, growable_capacity_t> seen;
+	seen.rehash(sample * 2);
+	for(size_t i = 0; i < sample; ++i)
+	{
+		bool inserted;
+		uint64_t key = values ? (uint64_t)keys[i * step] << 32 | values[i * step] : keys[i * step];
+		uint32_t * times = seen.upsert(key, 1, inserted);
+		if(!inserted)
+			++*times;
+	}
+	// chao1, the keys seen once against the keys seen twice tell how many were
+	// never seen, exact once the sample holds every key at least twice
+	size_t once = 0, twice = 0;
+	for(uint32_t i = 0; i < seen.capacity; ++i)
+	{
+		once += seen.taken(i) && seen.arr[i].value == 1;
+		twice += seen.taken(i) && seen.arr[i].value == 2;
+	}
+	double estimate = seen.size + (double)once * (once ? once - 1 : 0) / (2.0 * (twice + 1));
+	return estimate < count ? (size_t)estimate : count;
+}
+
+size_t aggregate(const uint32_t * keys, const uint32_t * values, size_t count, aggregateresult_t & result,
+				 bool distinct, aggregatepath_t path, uint32_t threads)
+{
+	if(path == aggregatepath_auto)
+	{
+		size_t groups = aggregate_cardinality(keys, distinct ? values : nullptr, count);
+		path = groups > aggregate_sort_groups ? aggregatepath_sort : aggregatepath_hash;
+	}
+	if(path == aggregatepath_sort)
+		return aggregate_sort(keys, values, count, result, distinct);
+	return aggregate_hash(keys, values, count, result, distinct, threads);
+}
+
+// distinct (key, value) pairs, the merge counts each once per key
+struct aggregatepairs_t
+{
+	uint64_t * pairs = nullptr;
+	size_t count = 0;
+	size_t capacity = 0;
+
+	~aggregatepairs_t() {free(pairs);}
+	void push(uint64_t pair)
+	{
+		if(count == capacity)
+		{
+			capacity = capacity ? capacity * 2 : 1024;
+			pairs = (uint64_t*)realloc(pairs, capacity * sizeof(uint64_t));
+		}
+		pairs[count++] = pair;
+	}
+};
+
+// what one thread spilled into one partition
+struct aggregatespill_t
+{
+	aggregateresult_t groups;
+	aggregatepairs_t pairs;
+};
+
+size_t aggregate_hash(const uint32_t * keys, const uint32_t * values, size_t count, aggregateresult_t & result,
+					  bool distinct, uint32_t threads)
+{
+	threads = count < (1 << 14) ? 1 : containers_threads(threads);
+	// partitions by the top hash bits, the tables below index by the low ones
+	uint32_t bits = 0;
+	while(threads > 1 && (1u << bits) < threads * 4 && bits < 8)
+		++bits;
+	uint32_t partitions = 1u << bits;
+	auto partition = [bits](uint32_t key) {return bits ? containers_hash(key) >> (32 - bits) : 0;};
+	aggregatespill_t * spills = new aggregatespill_t[threads * partitions];
+
+	// pre-aggregation, each thread folds its slice into a small table and
+	// spills partial groups (and first seen pairs for distinct) by partition
+	containers_parallel(threads, [&](uint32_t t)
+	{
+		size_t first = (size_t)((uint64_t)count * t / threads);
+		size_t last = (size_t)((uint64_t)count * (t + 1) / threads);
+		aggregatespill_t * spill = spills + t * partitions;
+		aggregatelocal_t * table = new aggregatelocal_t;
+		aggregateseen_t * seen = distinct ? new aggregateseen_t : nullptr;
+		aggregategroup_t * local = (aggregategroup_t*)malloc(aggregate_local_groups * sizeof(aggregategroup_t));
+		uint32_t used = 0;
+		auto flush = [&]()
+		{
+			for(uint32_t i = 0; i < used; ++i)
+				spill[partition(local[i].key)].groups.push(local[i]);
+			table->clear();
+			used = 0;
+			stats_add(stats_aggregate_spills);
+		};
+
+		for(size_t i = first; i < last;)
+		{
+			// equal neighbours are one batch, sorted or clustered keys take the vector loop
+			uint32_t key = keys[i];
+			size_t run = i + 1;
+			while(run < last && keys[run] == key)
+				++run;
+			bool inserted;
+			uint16_t * slot = table->upsert(key, (uint16_t)used, inserted);
+			if(inserted)
+			{
+				// only a new key spills, the table has room for it past the limit
+				if(used == aggregate_local_groups)
+				{
+					flush();
+					slot = table->upsert(key, 0, inserted);
+				}
+				local[used++] = aggregate_group(key);
+			}
+			aggregategroup_t & group = local[*slot];
+			if(run - i == 1)
+				aggregate_add(group, values[i]);
+			else
+				aggregate_accumulate(group, values + i, run - i);
+
+			if(distinct)
+			{
+				for(size_t j = i; j < run; ++j)
+				{
+					// forgetting pairs only spills some twice, the merge drops them
+					if(seen->size == aggregate_local_groups)
+						seen->clear();
+					uint64_t pair = (uint64_t)key << 32 | values[j];
+					bool fresh;
+					seen->upsert(pair, 1, fresh);
+					if(fresh)
+						spill[partition(key)].pairs.push(pair);
+				}
+			}
+			i = run;
+		}
+		if(used)
+			flush();
+		free(local);
+		delete seen;
+		delete table;
+	});
+
+	// merge, threads claim whole partitions so no key is touched by two of them
+	aggregateresult_t * merged = new aggregateresult_t[partitions];
+	std::atomic<uint32_t> next_partition(0);
+	containers_parallel(threads < partitions ? threads : partitions, [&](uint32_t)
+	{
+		basic_hashtable_t<uint32_t, uint32_t, growable_capacity_t> index;
+		basic_hashtable_t<uint64_t, uint8_t, growable_capacity_t> seen;
+		for(uint32_t p; (p = next_partition.fetch_add(1)) < partitions;)
+		{
+			aggregateresult_t & out = merged[p];
+			size_t spilled = 0;
+			for(uint32_t t = 0; t < threads; ++t)
+				spilled += spills[t * partitions + p].groups.count;
+			index.clear();
+			index.rehash(spilled * 4 / 3 + 1);
+			for(uint32_t t = 0; t < threads; ++t)
+			{
+				const aggregateresult_t & partial = spills[t * partitions + p].groups;
+				for(size_t i = 0; i < partial.count; ++i)
+				{
+					bool inserted;
+					uint32_t * at = index.upsert(partial.groups[i].key, (uint32_t)out.count, inserted);
+					if(inserted)
+						out.push(partial.groups[i]);
+					else
+						aggregate_merge(out.groups[*at], partial.groups[i]);
+				}
+			}
+			if(!distinct)
+				continue;
+			seen.clear();
+			for(uint32_t t = 0; t < threads; ++t)
+			{
+				const aggregatepairs_t & pairs = spills[t * partitions + p].pairs;
+				for(size_t i = 0; i < pairs.count; ++i)
+				{
+					bool fresh;
+					seen.upsert(pairs.pairs[i], 1, fresh);
+					if(fresh)
+						++out.groups[index.get((uint32_t)(pairs.pairs[i] >> 32))].distinct;
+				}
+			}
+		}
+	});
+
+	size_t before = result.count;
+	for(uint32_t p = 0; p < partitions; ++p)
+		result.append(merged[p]);
+	result.path = aggregatepath_hash;
+	delete[] merged;
+	delete[] spills;
+	return result.count - before;
+}
+
+size_t aggregate_sort(const uint32_t * keys, const uint32_t * values, size_t count, aggregateresult_t & result,
+					  bool distinct)
+{
+	size_t before = result.count;
+	result.path = aggregatepath_sort;
+	if(!count)
+		return 0;
+	uint32_t * sorted_keys = (uint32_t*)malloc(count * sizeof(uint32_t));
+	uint32_t * sorted_values = (uint32_t*)malloc(count * sizeof(uint32_t));
+	memcpy(sorted_keys, keys, count * sizeof(uint32_t));
+	memcpy(sorted_values, values, count * sizeof(uint32_t));
+	// by value first, the stable pass by key keeps values in order within a run
+	if(distinct)
+		sorts_radixsort_pairs(sorted_values, sorted_keys, count);
+	sorts_radixsort_pairs(sorted_keys, sorted_values, count);
+
+	for(size_t i = 0; i < count;)
+	{
+		size_t run = i + 1;
+		while(run < count && sorted_keys[run] == sorted_keys[i])
+			++run;
+		aggregategroup_t & group = result.push(aggregate_group(sorted_keys[i]));
+		aggregate_accumulate(group, sorted_values + i, run - i);
+		if(distinct)
+		{
+			group.distinct = 1;
+			for(size_t j = i + 1; j < run; ++j)
+				group.distinct += sorted_values[j] != sorted_values[j - 1];
+		}
+		i = run;
+	}
+
+	free(sorted_keys);
+	free(sorted_values);
+	return result.count - before;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// group by aggregation of (key, value) rows
+// count, sum, min and max always come together, distinct (number of different
+// values per key) costs a second table or sort and is asked for separately
+struct aggregategroup_t
+{
+	uint32_t key;
+	uint32_t min;
+	uint32_t max;
+	uint32_t distinct; // 0 unless asked for
+	uint64_t count;
+	uint64_t sum;
+};
+
+enum aggregatepath_t : uint32_t
+{
+	aggregatepath_auto, // picked from the cardinality seen in a sample
+	aggregatepath_hash, // per-thread pre-aggregation tables, spilled by partition and merged
+	aggregatepath_sort, // radix sort by key, one reduce pass over the runs
+};
+
+struct aggregateresult_t
+{
+	aggregategroup_t * groups = nullptr;
+	size_t count = 0;
+	size_t capacity = 0;
+	aggregatepath_t path = aggregatepath_auto; // the path that produced the groups
+
+	aggregateresult_t() = default;
+	~aggregateresult_t();
+	aggregateresult_t(const aggregateresult_t &) = delete;
+	aggregateresult_t & operator=(const aggregateresult_t &) = delete;
+
+	aggregategroup_t & push(const aggregategroup_t & group);
+	void append(const aggregateresult_t & other);
+	void clear() {count = 0;}
+	void sort(); // by key, the hash path leaves groups in partition order
+};
+
+// folds values into group, count / sum / min / max only, 8 lanes at a time with avx2
+void aggregate_accumulate(aggregategroup_t & group, const uint32_t * values, size_t count);
+// estimated number of distinct keys (or (key, value) pairs when values is given)
+// from a strided sample of at most sample rows
+size_t aggregate_cardinality(const uint32_t * keys, const uint32_t * values, size_t count, size_t sample = 1 << 14);
+
+// groups are appended to result, returns the number of groups
+size_t aggregate(const uint32_t * keys, const uint32_t * values, size_t count, aggregateresult_t & result,
+				 bool distinct = false, aggregatepath_t path = aggregatepath_auto, uint32_t threads = 0);
+size_t aggregate_hash(const uint32_t * keys, const uint32_t * values, size_t count, aggregateresult_t & result,
+					  bool distinct = false, uint32_t threads = 0);
+// single threaded, groups come out sorted by key
+size_t aggregate_sort(const uint32_t * keys, const uint32_t * values, size_t count, aggregateresult_t & result,
+					  bool distinct = false);
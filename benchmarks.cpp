@@ -0,0 +1,1352 @@
+#include "benchmarks.h"
+#include "filters.h"
+#include "containers.h"
+#include "radixtree.h"
+#include "spatial.h"
+#include "rtree.h"
+#include "graph.h"
+#include "join.h"
+#include "aggregate.h"
+#include "workload.h"
+#include "verify.h"
+#include "sorts.h"
+#include "search.h"
+#include "sets.h"
+#include "column.h"
+#include "tasks.h"
+#include "cache.h"
+#include "stringsort.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+double bench_seconds()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+uint64_t bench_ticks()
+{
+#if defined(__x86_64__)
+	// fences keep the measured op from drifting across the reads
+	_mm_lfence();
+	uint64_t ticks = __rdtsc();
+	_mm_lfence();
+	return ticks;
+#else
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+double bench_ticks_per_ns()
+{
+	static double ratio = 0.0;
+	if(ratio == 0.0)
+	{
+		double start = bench_seconds();
+		uint64_t ticks = bench_ticks();
+		while(bench_seconds() - start < 0.02)
+			;
+		ratio = (double)(bench_ticks() - ticks) / ((bench_seconds() - start) * 1e9);
+	}
+	return ratio;
+}
+
+void benchhistogram_t::clear()
+{
+	memset(buckets, 0, sizeof(buckets));
+	count = 0;
+	min = ~0ull;
+	max = 0;
+}
+
+uint32_t benchhistogram_t::bucket(uint64_t value)
+{
+	if(value < (1u << sub_bits))
+		return (uint32_t)value;
+	uint32_t shift = 63 - __builtin_clzll(value) - sub_bits;
+	return ((shift + 1) << sub_bits) + (uint32_t)((value >> shift) & ((1u << sub_bits) - 1));
+}
+
+uint64_t benchhistogram_t::lower(uint32_t bucket)
+{
+	if(bucket < (1u << sub_bits))
+		return bucket;
+	uint32_t shift = (bucket >> sub_bits) - 1;
+	return (uint64_t)((1u << sub_bits) + (bucket & ((1u << sub_bits) - 1))) << shift;
+}
+
+void benchhistogram_t::record(uint64_t value)
+{
+	++buckets[bucket(value)];
+	++count;
+	min = value < min ? value : min;
+	max = value > max ? value : max;
+}
+
+uint64_t benchhistogram_t::percentile(double p) const
+{
+	if(!count)
+		return 0;
+	uint64_t rank = (uint64_t)(p / 100.0 * (double)count + 0.5);
+	rank = rank ? rank : 1;
+	uint64_t seen = 0;
+	for(uint32_t i = 0; i < bucket_count; ++i)
+		if((seen += buckets[i]) >= rank)
+		{
+			uint64_t highest = i + 1 < bucket_count ? lower(i + 1) - 1 : ~0ull;
+			return highest < max ? highest : max;
+		}
+	return max;
+}
+
+static inline uint32_t bench_key(uint32_t i)
+{
+	// distinct keys spread over the whole range
+	return i * 0x9e3779b1u;
+}
+
+void bench_cuckoofilter(uint32_t capacity)
+{
+	printf("cuckoo filter, %u slots\n", capacity);
+	for(uint32_t bits = 8; bits <= 16; bits += 4)
+	{
+		cuckoofilter_t filter(capacity, bits);
+		uint32_t target = (uint32_t)((double)filter.bucket_count * filter.slots * 0.95);
+
+		double start = bench_seconds();
+		uint32_t inserted = 0;
+		while(inserted < target && filter.add(bench_key(inserted)))
+			++inserted;
+		double insert_time = bench_seconds() - start;
+
+		uint32_t hits = 0;
+		start = bench_seconds();
+		for(uint32_t i = 0; i < inserted; ++i)
+			hits += filter.may_contain(bench_key(i));
+		double hit_time = bench_seconds() - start;
+
+		uint32_t false_positives = 0;
+		start = bench_seconds();
+		for(uint32_t i = 0; i < inserted; ++i)
+			false_positives += filter.may_contain(bench_key(i + inserted));
+		double miss_time = bench_seconds() - start;
+
+		printf("  f=%2u  load %.3f  %.2f bits/key  insert %6.1f Mops  hit %6.1f Mops  miss %6.1f Mops  fpr %.5f%s\n",
+			   bits, filter.load_factor(), filter.bits_per_key(),
+			   inserted / insert_time * 1e-6, inserted / hit_time * 1e-6, inserted / miss_time * 1e-6,
+			   (double)false_positives / inserted, hits == inserted ? "" : "  FALSE NEGATIVES");
+	}
+}
+
+// sequential, random and clustered (runs of 64 around random bases) keys
+static void bench_keys(uint32_t * keys, uint32_t count, uint32_t distribution)
+{
+	xoshiro256_t rng;
+	auto next = [&rng]() {return rng.next32();};
+	for(uint32_t i = 0; i < count; ++i)
+		if(distribution == 0)
+			keys[i] = i;
+		else if(distribution == 1)
+			keys[i] = next();
+		else
+			keys[i] = (i % 64 == 0 ? next() & ~0xffffu : keys[i - 1] & ~0xffffu) + (i % 64) * 3;
+	// shuffle so insertion order is not the key order
+	for(uint32_t i = count; i > 1; --i)
+	{
+		uint32_t j = next() % i;
+		uint32_t t = keys[i - 1]; keys[i - 1] = keys[j]; keys[j] = t;
+	}
+}
+
+void bench_radixtree(uint32_t count)
+{
+	static const char * names[] = {"sequential", "random", "clustered"};
+	const uint32_t lookups = 1u << 22;
+
+	// rbtree_t holds at most rbtree_t::capacity keys, compare at that size
+	printf("radix tree vs rb tree, %u keys, ns per get\n", rbtree_t::capacity - 1);
+	for(uint32_t d = 0; d < 3; ++d)
+	{
+		uint32_t keys[rbtree_t::capacity - 1];
+		bench_keys(keys, rbtree_t::capacity - 1, d);
+		rbtree_t * rb = new rbtree_t;
+		radixtree_t art;
+		for(uint32_t i = 0; i < rbtree_t::capacity - 1; ++i)
+		{
+			rb->set(keys[i], i);
+			art.set(keys[i], i);
+		}
+		uint32_t sum = 0;
+		double start = bench_seconds();
+		for(uint32_t i = 0; i < lookups; ++i)
+			sum += rb->get(keys[i % (rbtree_t::capacity - 1)]);
+		double rb_time = bench_seconds() - start;
+		start = bench_seconds();
+		for(uint32_t i = 0; i < lookups; ++i)
+			sum -= art.get(keys[i % (rbtree_t::capacity - 1)]);
+		double art_time = bench_seconds() - start;
+		printf("  %-10s  rbtree %6.2f  radixtree %6.2f%s\n", names[d],
+			   rb_time / lookups * 1e9, art_time / lookups * 1e9, sum ? "  MISMATCH" : "");
+		delete rb;
+	}
+
+	printf("radix tree, %u keys\n", count);
+	uint32_t * keys = (uint32_t*)malloc(count * sizeof(uint32_t));
+	for(uint32_t d = 0; d < 3; ++d)
+	{
+		bench_keys(keys, count, d);
+		radixtree_t art;
+		double start = bench_seconds();
+		for(uint32_t i = 0; i < count; ++i)
+			art.set(keys[i], i);
+		double set_time = bench_seconds() - start;
+		uint32_t misses = 0;
+		start = bench_seconds();
+		for(uint32_t i = 0; i < count; ++i)
+			misses += art.get(keys[i]) == radixtree_t::invalid;
+		double get_time = bench_seconds() - start;
+		size_t scanned = 0;
+		start = bench_seconds();
+		art.scan(0, ~0ull, [](uint64_t, uint32_t, void * user) -> bool {++*(size_t*)user; return true;}, &scanned);
+		double scan_time = bench_seconds() - start;
+		printf("  %-10s  set %6.1f ns  get %6.1f ns  scan %5.2f ns/key  %5.1f bytes/key%s\n", names[d],
+			   set_time / count * 1e9, get_time / count * 1e9, scan_time / scanned * 1e9,
+			   (double)art.memory() / art.count, misses ? "  MISSES" : "");
+	}
+	free(keys);
+}
+
+template<typename tree_t>
+static void bench_spatial_tree(const char * name, const float * x, const float * y, uint32_t count,
+							   const float * qx, const float * qy, uint32_t queries)
+{
+	const uint32_t k = 8;
+	tree_t tree;
+	double start = bench_seconds();
+	tree.build(x, y, count);
+	double build_time = bench_seconds() - start;
+
+	uint32_t * ids = (uint32_t*)malloc((size_t)queries * k * sizeof(uint32_t));
+	float * dist = (float*)malloc((size_t)queries * k * sizeof(float));
+	start = bench_seconds();
+	for(uint32_t i = 0; i < queries; ++i)
+		tree.knn(qx[i], qy[i], k, ids + (size_t)i * k, dist + (size_t)i * k);
+	double knn_time = bench_seconds() - start;
+	start = bench_seconds();
+	tree.knn(qx, qy, queries, k, ids, dist);
+	double batch_time = bench_seconds() - start;
+
+	size_t found = 0;
+	start = bench_seconds();
+	for(uint32_t i = 0; i < queries; ++i)
+		found += tree.radius(qx[i], qy[i], 0.002f, ids, k * queries);
+	double radius_time = bench_seconds() - start;
+	start = bench_seconds();
+	for(uint32_t i = 0; i < queries; ++i)
+		found += tree.box(qx[i], qy[i], qx[i] + 0.004f, qy[i] + 0.004f, ids, k * queries);
+	double box_time = bench_seconds() - start;
+
+	printf("  %-8s build %6.1f ms  knn(%u) %6.2f us  batched %6.2f us  radius %6.2f us  box %6.2f us  (%zu found)\n",
+		   name, build_time * 1e3, k, knn_time / queries * 1e6, batch_time / queries * 1e6,
+		   radius_time / queries * 1e6, box_time / queries * 1e6, found);
+	free(ids);
+	free(dist);
+}
+
+void bench_spatial(uint32_t count, uint32_t queries)
+{
+	printf("spatial indexes, %u points in the unit square, %u queries\n", count, queries);
+	float * x = (float*)malloc(count * sizeof(float));
+	float * y = (float*)malloc(count * sizeof(float));
+	float * qx = (float*)malloc(queries * sizeof(float));
+	float * qy = (float*)malloc(queries * sizeof(float));
+	xoshiro256_t rng;
+	auto next = [&rng]() {return (float)(rng.next32() >> 8) / (float)(1u << 24);};
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		x[i] = next();
+		y[i] = next();
+	}
+	for(uint32_t i = 0; i < queries; ++i)
+	{
+		qx[i] = next();
+		qy[i] = next();
+	}
+	bench_spatial_tree<kdtree_t>("kd tree", x, y, count, qx, qy, queries);
+	bench_spatial_tree<quadtree_t>("quadtree", x, y, count, qx, qy, queries);
+	free(x);
+	free(y);
+	free(qx);
+	free(qy);
+}
+
+void bench_rtree(uint32_t count, uint32_t queries)
+{
+	printf("r-tree, %u boxes in the unit square, %u window queries\n", count, queries);
+	rtree_t::box_t * boxes = (rtree_t::box_t*)malloc(count * sizeof(rtree_t::box_t));
+	rtree_t::box_t * windows = (rtree_t::box_t*)malloc(queries * sizeof(rtree_t::box_t));
+	uint32_t * ids = (uint32_t*)malloc(count * sizeof(uint32_t));
+	xoshiro256_t rng;
+	auto next = [&rng]() {return (float)(rng.next32() >> 8) / (float)(1u << 24);};
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		float x = next(), y = next();
+		boxes[i] = {x, y, x + next() * 0.001f, y + next() * 0.001f};
+	}
+	for(uint32_t i = 0; i < queries; ++i)
+	{
+		float x = next(), y = next();
+		windows[i] = {x, y, x + 0.005f, y + 0.005f};
+	}
+
+	auto run = [&](const char * name, const rtree_t & tree, double build_time)
+	{
+		size_t found = 0;
+		double start = bench_seconds();
+		for(uint32_t i = 0; i < queries; ++i)
+			found += tree.query(windows[i], ids, count);
+		double query_time = bench_seconds() - start;
+		printf("  %-8s build %7.1f ms  height %u  %5.1f MB  query %6.2f us  (%zu found)\n", name, build_time * 1e3,
+			   tree.height(), (double)tree.serialized_size() / (1 << 20), query_time / queries * 1e6, found);
+	};
+
+	rtree_t packed;
+	double start = bench_seconds();
+	packed.build(boxes, count);
+	run("str", packed, bench_seconds() - start);
+
+	rtree_t dynamic;
+	start = bench_seconds();
+	for(uint32_t i = 0; i < count; ++i)
+		dynamic.insert(boxes[i], i);
+	run("r* insert", dynamic, bench_seconds() - start);
+
+	free(boxes);
+	free(windows);
+	free(ids);
+}
+
+void bench_graph(uint32_t width, uint32_t queries)
+{
+	// road like grid, unit spacing and weights of at least 10 per unit
+	// so 10 times the straight line distance is a consistent heuristic
+	uint32_t vertices = width * width;
+	uint32_t * sources = (uint32_t*)malloc((size_t)vertices * 4 * sizeof(uint32_t));
+	uint32_t * targets = (uint32_t*)malloc((size_t)vertices * 4 * sizeof(uint32_t));
+	uint32_t * weights = (uint32_t*)malloc((size_t)vertices * 4 * sizeof(uint32_t));
+	float * x = (float*)malloc(vertices * sizeof(float));
+	float * y = (float*)malloc(vertices * sizeof(float));
+	xoshiro256_t rng;
+	auto next = [&rng]() {return rng.next32();};
+	uint32_t edges = 0;
+	for(uint32_t v = 0; v < vertices; ++v)
+	{
+		uint32_t vx = v % width, vy = v / width;
+		x[v] = (float)vx;
+		y[v] = (float)vy;
+		const int32_t steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+		for(uint32_t s = 0; s < 4; ++s)
+		{
+			int32_t nx = (int32_t)vx + steps[s][0], ny = (int32_t)vy + steps[s][1];
+			if(nx < 0 || ny < 0 || nx >= (int32_t)width || ny >= (int32_t)width)
+				continue;
+			sources[edges] = v;
+			targets[edges] = (uint32_t)ny * width + (uint32_t)nx;
+			weights[edges++] = 10 + next() % 40;
+		}
+	}
+
+	graph_t graph;
+	double start = bench_seconds();
+	graph.build(vertices, sources, targets, weights, edges);
+	graph.set_coordinates(x, y);
+	printf("graph, %u vertices %u edges, csr build %.1f ms\n", vertices, edges, (bench_seconds() - start) * 1e3);
+
+	graphsearch_t search;
+	double dijkstra_time = 0.0, astar_time = 0.0;
+	uint32_t mismatches = 0;
+	for(uint32_t q = 0; q < queries; ++q)
+	{
+		uint32_t source = next() % vertices, target = next() % vertices;
+		start = bench_seconds();
+		uint32_t a = graph_dijkstra(graph, source, target, search);
+		dijkstra_time += bench_seconds() - start;
+		start = bench_seconds();
+		uint32_t b = graph_astar(graph, source, target, 10.0f, search);
+		astar_time += bench_seconds() - start;
+		mismatches += a != b;
+	}
+	printf("  point to point  dijkstra %7.2f ms  a* %7.2f ms%s\n", dijkstra_time / queries * 1e3,
+		   astar_time / queries * 1e3, mismatches ? "  MISMATCH" : "");
+
+	uint32_t * dist = (uint32_t*)malloc(vertices * sizeof(uint32_t));
+	start = bench_seconds();
+	graph_dijkstra(graph, 0, graph_t::invalid, search);
+	printf("  all targets     dijkstra %7.2f ms\n", (bench_seconds() - start) * 1e3);
+	for(uint32_t threads = 1; threads <= 8; threads *= 2)
+	{
+		start = bench_seconds();
+		graph_deltastepping(graph, 0, 50, dist, threads);
+		double time = bench_seconds() - start;
+		mismatches = 0;
+		for(uint32_t v = 0; v < vertices; ++v)
+			mismatches += dist[v] != search.distance(v);
+		printf("  all targets     delta stepping, %u threads %7.2f ms%s\n", threads, time * 1e3, mismatches ? "  MISMATCH" : "");
+	}
+
+	free(dist);
+	free(sources);
+	free(targets);
+	free(weights);
+	free(x);
+	free(y);
+}
+
+void bench_join(uint32_t build_count, uint32_t probe_count)
+{
+	xoshiro256_t rng;
+	auto next = [&rng]() {return rng.next32();};
+	uint32_t * build_keys = (uint32_t*)malloc(build_count * sizeof(uint32_t));
+	uint32_t * build_values = (uint32_t*)malloc(build_count * sizeof(uint32_t));
+	uint32_t * probe_keys = (uint32_t*)malloc(probe_count * sizeof(uint32_t));
+	uint32_t * probe_values = (uint32_t*)malloc(probe_count * sizeof(uint32_t));
+	uint32_t * found = (uint32_t*)malloc(probe_count * sizeof(uint32_t));
+	// unique build keys, probe keys hit about half the time
+	for(uint32_t i = 0; i < build_count; ++i)
+	{
+		build_keys[i] = bench_key(i);
+		build_values[i] = i;
+	}
+	for(uint32_t i = 0; i < probe_count; ++i)
+	{
+		probe_keys[i] = bench_key(next() % (build_count * 2));
+		probe_values[i] = i;
+	}
+
+	printf("hashtable bulk build, %u keys, probe %u keys\n", build_count, probe_count);
+	{
+		basic_hashtable_t<uint32_t, uint32_t, growable_capacity_t> table;
+		table.rehash((uint64_t)build_count * 4 / 3 + 1);
+		double start = bench_seconds();
+		for(uint32_t i = 0; i < build_count; ++i)
+			table.set(build_keys[i], build_values[i]);
+		printf("  set loop            %7.1f ms\n", (bench_seconds() - start) * 1e3);
+	}
+	for(uint32_t threads = 1; threads <= 8; threads *= 2)
+	{
+		basic_hashtable_t<uint32_t, uint32_t, growable_capacity_t> table;
+		table.rehash((uint64_t)build_count * 4 / 3 + 1);
+		double start = bench_seconds();
+		table.build(build_keys, build_values, build_count, threads);
+		double build_time = bench_seconds() - start;
+		start = bench_seconds();
+		size_t hits = table.probe(probe_keys, probe_count, found, threads);
+		double probe_time = bench_seconds() - start;
+		printf("  build, %u threads   %7.1f ms  probe %7.1f ms  %5.1f Mkeys/s  (%zu hits)\n", threads,
+			   build_time * 1e3, probe_time * 1e3, probe_count / probe_time * 1e-6, hits);
+	}
+
+	joinrelation_t build = {build_keys, build_values, build_count};
+	joinrelation_t probe = {probe_keys, probe_values, probe_count};
+	for(uint32_t threads = 1; threads <= 8; threads *= 2)
+	{
+		joinresult_t result;
+		double start = bench_seconds();
+		join_hash(build, probe, result, threads);
+		printf("  hash join, %u threads        %7.1f ms  (%zu matches)\n", threads, (bench_seconds() - start) * 1e3, result.count);
+	}
+	{
+		joinresult_t result;
+		double start = bench_seconds();
+		join_sortmerge(build, probe, result);
+		printf("  sort merge join, 1 thread   %7.1f ms  (%zu matches)\n", (bench_seconds() - start) * 1e3, result.count);
+	}
+
+	free(build_keys);
+	free(build_values);
+	free(probe_keys);
+	free(probe_values);
+	free(found);
+}
+
+void bench_aggregate(uint32_t count)
+{
+	uint32_t * keys = (uint32_t*)malloc(count * sizeof(uint32_t));
+	uint32_t * values = (uint32_t*)malloc(count * sizeof(uint32_t));
+	const uint32_t cardinalities[] = {64, 4096, 1u << 16, count};
+	static const char * path_names[] = {"auto", "hash", "sort"};
+
+	// 64 different values, so distinct has few pairs only for the fewest keys
+	printf("aggregate, %u rows, ms for count / sum / min / max, then with distinct\n", count);
+	for(uint32_t cardinality : cardinalities)
+	{
+		xoshiro256_t rng;
+		for(uint32_t i = 0; i < count; ++i)
+		{
+			uint32_t word = rng.next32();
+			keys[i] = bench_key(word % cardinality);
+			values[i] = (word >> 16) & 63;
+		}
+		printf("  %8u keys, estimated %8zu keys %8zu pairs\n", cardinality,
+			   aggregate_cardinality(keys, nullptr, count), aggregate_cardinality(keys, values, count));
+		auto run = [&](aggregatepath_t path, uint32_t threads)
+		{
+			double times[2];
+			size_t groups = 0;
+			aggregatepath_t taken[2];
+			for(uint32_t distinct = 0; distinct < 2; ++distinct)
+			{
+				aggregateresult_t result;
+				double start = bench_seconds();
+				groups = aggregate(keys, values, count, result, distinct, path, threads);
+				times[distinct] = bench_seconds() - start;
+				taken[distinct] = result.path;
+			}
+			printf("    %s %u threads  %8.1f %8.1f  %6.1f Mrows/s  %8zu groups", path_names[path], threads,
+				   times[0] * 1e3, times[1] * 1e3, count / times[0] * 1e-6, groups);
+			if(path == aggregatepath_auto)
+				printf(", took %s / %s", path_names[taken[0]], path_names[taken[1]]);
+			printf("\n");
+		};
+		run(aggregatepath_hash, 1);
+		run(aggregatepath_hash, 4);
+		run(aggregatepath_sort, 1);
+		run(aggregatepath_auto, 4);
+	}
+
+	free(keys);
+	free(values);
+}
+
+void bench_workload(size_t count)
+{
+	uint32_t * out = (uint32_t*)malloc(count * sizeof(uint32_t));
+	// one untimed fill first so the ones below measure generation, not page faults
+	workload_uniform(out, count, 0);
+	printf("workload, %zu items, Mitems/s\n", count);
+
+	size_t serial = count < ((size_t)1 << 24) ? count : (size_t)1 << 24;
+	double start = bench_seconds();
+	for(size_t i = 0; i < serial; ++i)
+		out[i] = (uint32_t)rand();
+	printf("  %-12s %8.1f  (%zu items)\n", "rand()", serial / (bench_seconds() - start) * 1e-6, serial);
+	xoshiro256_t rng;
+	start = bench_seconds();
+	for(size_t i = 0; i < serial; ++i)
+		out[i] = rng.next32();
+	printf("  %-12s %8.1f  (%zu items)\n", "xoshiro256", serial / (bench_seconds() - start) * 1e-6, serial);
+
+	static const char * names[] = {"uniform", "bounded", "zipf", "sorted 1%", "few unique", "clustered"};
+	for(uint32_t kind = 0; kind < 6; ++kind)
+	{
+		printf("  %-12s", names[kind]);
+		for(uint32_t threads = 1; threads <= 8; threads *= 2)
+		{
+			start = bench_seconds();
+			switch(kind)
+			{
+			case 0: workload_uniform(out, count, 1, 0, threads); break;
+			case 1: workload_uniform(out, count, 1, 1000000, threads); break;
+			case 2: workload_zipf(out, count, 1, 1u << 20, 1.0, threads); break;
+			case 3: workload_sorted(out, count, 1, 0.01, threads); break;
+			case 4: workload_few_unique(out, count, 1, 16, threads); break;
+			case 5: workload_clustered(out, count, 1, 1024, 4096, threads); break;
+			}
+			printf(" %8.1f (%u threads)", count / (bench_seconds() - start) * 1e-6, threads);
+		}
+		printf("\n");
+	}
+	free(out);
+}
+
+void bench_verify(size_t count)
+{
+	uint32_t * items = (uint32_t*)malloc(count * sizeof(uint32_t));
+	workload_sorted(items, count, 1);
+	printf("verify, %zu sorted items, ms\n", count);
+
+	// the old dataset_t::validate loop, branch per item
+	double start = bench_seconds();
+	uint32_t last = 0;
+	bool valid = true;
+	for(size_t i = 0; i < count; ++i)
+		if(last <= items[i])
+			last = items[i];
+		else
+		{
+			valid = false;
+			break;
+		}
+	printf("  %-12s %8.1f  %s\n", "scalar", (bench_seconds() - start) * 1e3, valid ? "sorted" : "unsorted");
+
+	for(uint32_t threads = 1; threads <= 8; threads *= 2)
+	{
+		start = bench_seconds();
+		valid = verify_sorted(items, count, threads);
+		double sorted_time = bench_seconds() - start;
+		start = bench_seconds();
+		verifyfingerprint_t fingerprint = verify_fingerprint(items, count, 1, threads);
+		double fingerprint_time = bench_seconds() - start;
+		printf("  %u threads    %8.1f  %s, fingerprint %8.1f  %016llx\n", threads, sorted_time * 1e3,
+			   valid ? "sorted" : "unsorted", fingerprint_time * 1e3, (unsigned long long)fingerprint.mixed);
+	}
+
+	// what a checked sort costs on top
+	size_t sorted_count = count < ((size_t)1 << 24) ? count : (size_t)1 << 24;
+	uint32_t * values = (uint32_t*)malloc(sorted_count * sizeof(uint32_t));
+	workload_uniform(items, sorted_count, 2);
+	verifier_t verifier(3);
+	start = bench_seconds();
+	verifier.expect(items, sorted_count);
+	double expect_time = bench_seconds() - start;
+	start = bench_seconds();
+	sorts_radixsort_pairs(items, values, sorted_count);
+	double sort_time = bench_seconds() - start;
+	start = bench_seconds();
+	valid = verifier.check(items, sorted_count);
+	printf("  radix sort of %zu %8.1f, expect %6.1f, check %6.1f  %s\n", sorted_count, sort_time * 1e3,
+		   expect_time * 1e3, (bench_seconds() - start) * 1e3, valid ? "ok" : "failed");
+	free(values);
+	free(items);
+}
+
+void bench_percentile(uint32_t window, uint32_t updates)
+{
+	uint32_t * stream = (uint32_t*)malloc((size_t)(window + updates) * sizeof(uint32_t));
+	workload_zipf(stream, (size_t)window + updates, 1, 1u << 20, 0.8);
+	printf("sliding window p50 / p99, window %u, ns per update\n", window);
+
+	// counted tree: drop the oldest, add the newest, two selects
+	basic_rbtree_t<uint32_t, uint32_t, growable_capacity_t, true> tree;
+	for(uint32_t i = 0; i < window; ++i)
+		tree.set(stream[i], i, true);
+	uint64_t sum = 0;
+	double start = bench_seconds();
+	for(uint32_t i = window; i < window + updates; ++i)
+	{
+		tree.remove(stream[i - window]);
+		tree.set(stream[i], i, true);
+		sum += tree.arr[tree.percentile(50)].key + tree.arr[tree.percentile(99)].key;
+	}
+	double tree_time = bench_seconds() - start;
+
+	// sorting a copy of the window every update, timed on fewer updates
+	uint32_t resorts = updates < 256 ? updates : 256;
+	uint32_t * sorted = (uint32_t*)malloc(window * sizeof(uint32_t));
+	uint32_t * scratch = (uint32_t*)malloc(window * sizeof(uint32_t));
+	uint64_t check = 0;
+	start = bench_seconds();
+	for(uint32_t i = window; i < window + resorts; ++i)
+	{
+		memcpy(sorted, stream + i + 1 - window, window * sizeof(uint32_t));
+		sorts_radixsort_pairs(sorted, scratch, window);
+		check += sorted[(window + 1) / 2 - 1] + sorted[(uint32_t)(window * 0.99 + 0.999) - 1];
+	}
+	double sort_time = bench_seconds() - start;
+	printf("  counted rbtree %10.1f  (%llu)\n", tree_time / updates * 1e9, (unsigned long long)sum);
+	printf("  resort window  %10.1f  (%llu over %u updates)\n", sort_time / resorts * 1e9, (unsigned long long)check, resorts);
+	free(sorted);
+	free(scratch);
+	free(stream);
+}
+
+void bench_search(size_t max_count, uint32_t queries)
+{
+	uint32_t * items = (uint32_t*)malloc(max_count * sizeof(uint32_t));
+	uint32_t * scratch = (uint32_t*)malloc(max_count * sizeof(uint32_t));
+	uint32_t * keys = (uint32_t*)malloc(queries * sizeof(uint32_t));
+	size_t * positions = (size_t*)malloc(queries * sizeof(size_t));
+	workload_uniform(keys, queries, 2);
+	printf("lower_bound, %u random queries, ns per query\n", queries);
+	printf("  %10s %10s %10s %10s %10s %10s\n", "count", "binary", "eytzinger", "batched", "b+ tree", "batched");
+
+	for(size_t count = 1 << 10; count <= max_count; count *= 4)
+	{
+		workload_uniform(items, count, 1);
+		sorts_radixsort_pairs(items, scratch, count);
+		eytzinger_t eytzinger;
+		statictree_t tree;
+		eytzinger.build(items, count);
+		tree.build(items, count);
+
+		// the sums keep the searches alive and must agree
+		size_t sums[5] = {0};
+		double times[5];
+		double start = bench_seconds();
+		for(uint32_t i = 0; i < queries; ++i)
+			sums[0] += std::lower_bound(items, items + count, keys[i]) - items;
+		times[0] = bench_seconds() - start;
+		start = bench_seconds();
+		for(uint32_t i = 0; i < queries; ++i)
+			sums[1] += eytzinger.lower_bound(keys[i]);
+		times[1] = bench_seconds() - start;
+		start = bench_seconds();
+		eytzinger.lower_bound(keys, queries, positions);
+		times[2] = bench_seconds() - start;
+		for(uint32_t i = 0; i < queries; ++i)
+			sums[2] += positions[i];
+		start = bench_seconds();
+		for(uint32_t i = 0; i < queries; ++i)
+			sums[3] += tree.lower_bound(keys[i]);
+		times[3] = bench_seconds() - start;
+		start = bench_seconds();
+		tree.lower_bound(keys, queries, positions);
+		times[4] = bench_seconds() - start;
+		for(uint32_t i = 0; i < queries; ++i)
+			sums[4] += positions[i];
+
+		printf("  %10zu", count);
+		for(uint32_t i = 0; i < 5; ++i)
+			printf(" %10.1f", times[i] / queries * 1e9);
+		bool agree = sums[1] == sums[0] && sums[2] == sums[0] && sums[3] == sums[0] && sums[4] == sums[0];
+		printf("%s\n", agree ? "" : "  mismatch");
+	}
+	free(items);
+	free(scratch);
+	free(keys);
+	free(positions);
+}
+
+// sorted duplicate free draws below bound, returns how many are left
+static size_t bench_set(uint32_t * items, uint32_t * scratch, size_t count, uint64_t seed, uint32_t bound)
+{
+	workload_uniform(items, count, seed, bound);
+	sorts_radixsort_pairs(items, scratch, count);
+	return sets_unique(items, count, items);
+}
+
+void bench_sets(uint32_t count)
+{
+	uint32_t * large = (uint32_t*)malloc(count * sizeof(uint32_t));
+	uint32_t * small = (uint32_t*)malloc(count * sizeof(uint32_t));
+	uint32_t * out = (uint32_t*)malloc((size_t)count * 2 * sizeof(uint32_t));
+	uint32_t bound = count * 4;
+	size_t large_count = bench_set(large, out, count, 1, bound);
+	printf("intersection, %zu items against 1/ratio as many, M input items/s\n", large_count);
+	printf("  %6s %10s %10s %10s %10s %10s\n", "ratio", "matches", "merge", "simd", "gallop", "auto");
+
+	typedef size_t (*intersect_t)(const uint32_t *, size_t, const uint32_t *, size_t, uint32_t *);
+	const intersect_t intersects[] = {sets_intersect_merge, sets_intersect_simd, sets_intersect_gallop, sets_intersect};
+	for(uint32_t ratio = 1; ratio <= 4096; ratio *= 4)
+	{
+		size_t small_count = bench_set(small, out, count / ratio, ratio + 1, bound);
+		// enough repeats that the small ratios are not timer noise
+		uint32_t repeats = ratio < 64 ? 4 : 64;
+		printf("  %6u", ratio);
+		for(uint32_t f = 0; f < 4; ++f)
+		{
+			size_t matches = 0;
+			double start = bench_seconds();
+			for(uint32_t r = 0; r < repeats; ++r)
+				matches += intersects[f](small, small_count, large, large_count, out);
+			double seconds = bench_seconds() - start;
+			if(!f)
+				printf(" %10zu", matches / repeats);
+			printf(" %10.1f", (double)(small_count + large_count) * repeats / seconds * 1e-6);
+		}
+		printf("\n");
+	}
+
+	// repeats of every item, a branchy compaction loop against sets_unique
+	workload_uniform(small, count, 3, count / 4);
+	sorts_radixsort_pairs(small, out, count);
+	double start = bench_seconds();
+	size_t unique = 1;
+	out[0] = small[0];
+	for(uint32_t i = 1; i < count; ++i)
+		if(small[i] != out[unique - 1])
+			out[unique++] = small[i];
+	double loop_time = bench_seconds() - start;
+	start = bench_seconds();
+	size_t vector_unique = sets_unique(small, count, out);
+	printf("unique, %u items, %zu left, M items/s: loop %8.1f  sets_unique %8.1f\n", count, unique, count / loop_time * 1e-6,
+		   count / (bench_seconds() - start) * 1e-6);
+	if(vector_unique != unique)
+		printf("  mismatch %zu\n", vector_unique);
+
+	// k lists splitting count items between them, heap merge against folding pairwise unions
+	printf("union of k lists, %u items in all, M items/s\n", count);
+	uint32_t * folded = (uint32_t*)malloc((size_t)count * 2 * sizeof(uint32_t));
+	for(uint32_t k = 4; k <= 256; k *= 4)
+	{
+		setslist_t * lists = new setslist_t[k];
+		size_t per_list = count / k;
+		for(uint32_t list = 0; list < k; ++list)
+			lists[list] = {large + list * per_list, bench_set(large + list * per_list, out, per_list, list + 10, bound)};
+		start = bench_seconds();
+		size_t merged = sets_union_k(lists, k, out);
+		double heap_time = bench_seconds() - start;
+		start = bench_seconds();
+		size_t total = 0;
+		for(uint32_t list = 0; list < k; ++list)
+		{
+			total = sets_union(out + count, total, lists[list].items, lists[list].count, folded);
+			memcpy(out + count, folded, total * sizeof(uint32_t));
+		}
+		double fold_time = bench_seconds() - start;
+		printf("  k %4u  heap %8.1f  pairwise %8.1f%s\n", k, count / heap_time * 1e-6, count / fold_time * 1e-6,
+			   merged == total ? "" : "  mismatch");
+		delete[] lists;
+	}
+	free(folded);
+	free(large);
+	free(small);
+	free(out);
+}
+
+void bench_column(size_t count, uint32_t queries)
+{
+	uint32_t * items = (uint32_t*)malloc(count * sizeof(uint32_t));
+	uint32_t * keys = (uint32_t*)malloc(queries * sizeof(uint32_t));
+	printf("column, sorted values, scans in M values/s, searches in ns\n");
+	printf("  %8s %10s %8s %10s %10s %10s %10s %10s\n", "max gap", "values", "ratio", "plain sum", "block sum", "decode", "plain find", "find");
+
+	const uint32_t gaps[] = {2, 8, 32, 1024, 65536};
+	size_t max_count = count;
+	for(uint32_t gap : gaps)
+	{
+		// random gaps below gap, as many as fit without wrapping, a scan of the
+		// plain array runs at memory speed until they fit in cache
+		count = max_count < UINT32_MAX / gap ? max_count : UINT32_MAX / gap;
+		workload_uniform(items, count, gap, gap);
+		uint32_t sum = 0;
+		for(size_t i = 0; i < count; ++i)
+		{
+			sum += items[i];
+			items[i] = sum;
+		}
+		column_t column;
+		column.build(items, count);
+
+		double start = bench_seconds();
+		uint64_t plain_sum = 0;
+		for(size_t i = 0; i < count; ++i)
+			plain_sum += items[i];
+		double plain_time = bench_seconds() - start;
+
+		// decoded a block at a time into a buffer that stays in l1
+		start = bench_seconds();
+		uint64_t block_sum = 0;
+		uint32_t values[column_t::block_size];
+		for(size_t block = 0; block < column.block_count; ++block)
+		{
+			uint32_t size = column.decode_block(block, values);
+			for(uint32_t i = 0; i < size; ++i)
+				block_sum += values[i];
+		}
+		double block_time = bench_seconds() - start;
+		start = bench_seconds();
+		column.decode(items);
+		double decode_time = bench_seconds() - start;
+
+		workload_uniform(keys, queries, 1, sum);
+		start = bench_seconds();
+		size_t positions = 0;
+		for(uint32_t i = 0; i < queries; ++i)
+			positions += std::lower_bound(items, items + count, keys[i]) - items;
+		double plain_find = bench_seconds() - start;
+		start = bench_seconds();
+		size_t found = 0;
+		for(uint32_t i = 0; i < queries; ++i)
+			found += column.lower_bound(keys[i]);
+		double find = bench_seconds() - start;
+
+		printf("  %8u %10zu %8.2f %10.1f %10.1f %10.1f %10.1f %10.1f%s\n", gap, count, (double)count * sizeof(uint32_t) / column.bytes(),
+			   count / plain_time * 1e-6, count / block_time * 1e-6, count / decode_time * 1e-6,
+			   plain_find / queries * 1e9, find / queries * 1e9, plain_sum == block_sum && positions == found ? "" : "  mismatch");
+	}
+	free(items);
+	free(keys);
+}
+
+void bench_tasks(size_t count, uint32_t max_threads)
+{
+	uint32_t * inputs[2] = {(uint32_t*)malloc(count * sizeof(uint32_t)), (uint32_t*)malloc(count * sizeof(uint32_t))};
+	uint32_t * expected = (uint32_t*)malloc(count * sizeof(uint32_t));
+	uint32_t * items = (uint32_t*)malloc(count * sizeof(uint32_t));
+	// duplicate heavy input too, equal runs are where a two way quicksort partition goes quadratic
+	workload_uniform(inputs[0], count, 1);
+	workload_few_unique(inputs[1], count, 1, 4);
+	const char * input_names[2] = {"uniform", "4 unique"};
+	printf("work stealing sorts, %u hardware threads, ms (speedup over 1 thread)\n", std::thread::hardware_concurrency());
+
+	typedef void (*sort_t)(uint32_t *, size_t, taskpool_t &, size_t);
+	const struct {const char * name; sort_t sort; size_t count;} sorts[] =
+	{
+		{"quicksort", sorts_quicksort, count},
+		{"mergesort", sorts_mergesort, count},
+		// n log^2 n, a quarter of the items keeps it in the same time range
+		{"bitonicsort", sorts_bitonicsort, count / 4},
+	};
+	for(uint32_t input = 0; input < 2; ++input)
+	{
+		for(const auto & sort : sorts)
+		{
+			printf("  %-12s %zu items, %s\n", sort.name, sort.count, input_names[input]);
+			double single = 0;
+			for(uint32_t threads = 1; threads <= max_threads; threads *= 2)
+			{
+				taskpool_t pool(threads);
+				memcpy(items, inputs[input], sort.count * sizeof(uint32_t));
+				double start = bench_seconds();
+				sort.sort(items, sort.count, pool, 1 << 14);
+				double seconds = bench_seconds() - start;
+				// one thread is the reference every other count has to match
+				if(threads == 1)
+				{
+					single = seconds;
+					memcpy(expected, items, sort.count * sizeof(uint32_t));
+				}
+				bool same = !memcmp(items, expected, sort.count * sizeof(uint32_t));
+				printf("    %2u threads %10.1f  (%5.2fx)%s\n", threads, seconds * 1e3, single / seconds, same ? "" : "  mismatch");
+			}
+		}
+	}
+	free(inputs[0]);
+	free(inputs[1]);
+	free(expected);
+	free(items);
+}
+
+void bench_cache(uint32_t requests, uint32_t universe, uint32_t max_threads)
+{
+	uint32_t * trace = (uint32_t*)malloc(requests * sizeof(uint32_t));
+	printf("cache trace replay, %u requests over %u keys, get then put on a miss, hit %% and M requests/s\n", requests, universe);
+
+	enum {trace_zipf, trace_scans, trace_loop};
+	const struct {const char * name; uint32_t kind; double skew;} traces[] =
+	{
+		{"zipf 0.8", trace_zipf, 0.8},
+		{"zipf 1.0", trace_zipf, 1.0},
+		{"zipf 1.2", trace_zipf, 1.2},
+		// every 4th block of 1 << 16 requests is a one pass scan of keys never seen again
+		{"zipf+scans", trace_scans, 1.0},
+		// a cycle a bit larger than the small cache, lru misses every time
+		{"loop", trace_loop, 0.0},
+	};
+	const struct {const char * name; cachepolicy_t policy;} policies[] =
+	{
+		{"lru", cachepolicy_lru},
+		{"clock", cachepolicy_clock},
+		{"sieve", cachepolicy_sieve},
+	};
+	const uint32_t sizes[] = {universe / 100, universe / 10};
+	printf("  %-12s %8s", "trace", "size");
+	for(const auto & policy : policies)
+		printf(" %8s %8s", policy.name, "Mops");
+	printf("\n");
+
+	for(const auto & t : traces)
+	{
+		// ranks scattered over the key space so popular keys do not share table slots
+		workload_zipf(trace, requests, 1, universe, t.skew > 0 ? t.skew : 1.0);
+		for(uint32_t i = 0; i < requests; ++i)
+		{
+			if(t.kind == trace_scans && (i >> 16) % 4 == 3)
+				trace[i] = universe + i;
+			else if(t.kind == trace_loop)
+				trace[i] = i % (universe / 100 + universe / 200);
+			trace[i] *= 0x9e3779b1u;
+		}
+		for(uint32_t size : sizes)
+		{
+			printf("  %-12s %8u", t.name, size);
+			for(const auto & policy : policies)
+			{
+				cache_t cache(size, policy.policy);
+				uint32_t value = 0;
+				double start = bench_seconds();
+				for(uint32_t i = 0; i < requests; ++i)
+					if(!cache.get(trace[i], value))
+						cache.put(trace[i], trace[i]);
+				double seconds = bench_seconds() - start;
+				printf(" %7.2f%% %8.1f", cache.counters.hit_rate() * 100, requests / seconds * 1e-6);
+			}
+			printf("\n");
+		}
+	}
+
+	// sharded sieve on the zipf 1.0 trace, each thread replays all of it from its own offset
+	workload_zipf(trace, requests, 1, universe, 1.0);
+	for(uint32_t i = 0; i < requests; ++i)
+		trace[i] *= 0x9e3779b1u;
+	printf("  sharded sieve, zipf 1.0, size %u, 64 shards, %u hardware threads\n", universe / 10, std::thread::hardware_concurrency());
+	for(uint32_t threads = 1; threads <= max_threads; threads *= 2)
+	{
+		shardedcache_t cache(universe / 10, cachepolicy_sieve, 64);
+		uint32_t per_thread = requests / threads;
+		double start = bench_seconds();
+		containers_parallel(threads, [&](uint32_t t)
+		{
+			uint32_t value = 0;
+			for(uint32_t i = 0, j = t * per_thread; i < per_thread; ++i, j = j + 1 < requests ? j + 1 : 0)
+				if(!cache.get(trace[j], value))
+					cache.put(trace[j], trace[j]);
+		});
+		double seconds = bench_seconds() - start;
+		cachecounters_t counters = cache.counters();
+		printf("    %2u threads %7.2f%% %8.1f Mops\n", threads, counters.hit_rate() * 100, (double)per_thread * threads / seconds * 1e-6);
+	}
+	free(trace);
+}
+
+// made up words with letters drawn by english frequency, so the alphabet is skewed
+// and the word frequencies zipf, then urls or sentences out of them into chars
+static size_t bench_corpus(bool urls, stringkey_t * keys, size_t count, char * chars)
+{
+	static const char letters[] = "etaoinshrdlcumwfgypbvkjxqz";
+	const uint32_t word_count = 4096;
+	char words[word_count][10];
+	uint32_t lengths[word_count];
+	xoshiro256_t & rng = workload_local();
+	workload_seed(urls);
+	workloadzipf_t letter(26, 1.0), word(word_count, 1.0), host(512, 1.0);
+	for(uint32_t w = 0; w < word_count; ++w)
+	{
+		lengths[w] = 2 + rng.below(8);
+		for(uint32_t i = 0; i < lengths[w]; ++i)
+			words[w][i] = letters[letter(rng)];
+	}
+	size_t used = 0;
+	for(size_t k = 0; k < count; ++k)
+	{
+		char * out = chars + used;
+		uint32_t length = 0;
+		auto append = [&](const char * text, uint32_t size) {memcpy(out + length, text, size); length += size;};
+		if(urls)
+		{
+			uint32_t h = host(rng);
+			append("https://www.", 12);
+			append(words[h], lengths[h]);
+			append(h & 1 ? ".org" : ".com", 4);
+			for(uint32_t segments = 1 + rng.below(4); segments; --segments)
+			{
+				uint32_t w = word(rng);
+				append("/", 1);
+				append(words[w], lengths[w]);
+			}
+			if(rng.below(2))
+				length += sprintf(out + length, "?id=%u", rng.below(1000000));
+		}
+		else
+		{
+			for(uint32_t i = 0, n = 4 + rng.below(13); i < n; ++i)
+			{
+				uint32_t w = word(rng);
+				if(i)
+					append(" ", 1);
+				append(words[w], lengths[w]);
+			}
+		}
+		keys[k] = {out, length};
+		used += length;
+	}
+	return used;
+}
+
+void bench_stringsort(size_t count, uint32_t max_threads)
+{
+	// urls stay below 100 bytes, sentences below 180
+	char * chars = (char*)malloc(count * 192);
+	stringkey_t * keys = (stringkey_t*)malloc(count * sizeof(stringkey_t));
+	stringkey_t * expected = (stringkey_t*)malloc(count * sizeof(stringkey_t));
+	stringkey_t * items = (stringkey_t*)malloc(count * sizeof(stringkey_t));
+	printf("string sorts, ms (M keys/s), %u hardware threads\n", std::thread::hardware_concurrency());
+
+	for(bool urls : {true, false})
+	{
+		size_t bytes = bench_corpus(urls, keys, count, chars);
+		printf("  %s, %zu keys, %.1f bytes each\n", urls ? "urls" : "sentences", count, (double)bytes / count);
+
+		memcpy(expected, keys, count * sizeof(stringkey_t));
+		double start = bench_seconds();
+		std::sort(expected, expected + count, [](const stringkey_t & a, const stringkey_t & b) {return stringsort_compare(a, b) < 0;});
+		double seconds = bench_seconds() - start;
+		printf("    %-20s %10.1f (%6.2f)\n", "std::sort", seconds * 1e3, count / seconds * 1e-6);
+
+		auto run = [&](const char * name, auto sort)
+		{
+			memcpy(items, keys, count * sizeof(stringkey_t));
+			double start = bench_seconds();
+			sort();
+			double seconds = bench_seconds() - start;
+			bool same = true;
+			for(size_t i = 0; same && i < count; ++i)
+				same = !stringsort_compare(items[i], expected[i]);
+			printf("    %-20s %10.1f (%6.2f)%s\n", name, seconds * 1e3, count / seconds * 1e-6, same ? "" : "  mismatch");
+		};
+		run("multikey quicksort", [&]() {stringsort_multikey(items, count);});
+		run("msd radix", [&]() {stringsort_radix(items, count);});
+		for(uint32_t threads = 1; threads <= max_threads; threads *= 2)
+		{
+			taskpool_t pool(threads);
+			char name[32];
+			snprintf(name, sizeof(name), "msd radix %u threads", threads);
+			run(name, [&]() {stringsort_radix(items, count, pool);});
+		}
+	}
+	free(chars);
+	free(keys);
+	free(expected);
+	free(items);
+}
+
+static void bench_flush(const void * data, size_t size)
+{
+#if defined(__x86_64__)
+	const char * bytes = (const char*)data;
+	for(size_t i = 0; i < size; i += 64)
+		_mm_clflush(bytes + i);
+	_mm_mfence();
+#endif
+}
+
+// adapters for the op mix harness, insert returns a handle that erase and
+// scan get back (list nodes), keyed containers just return the key
+static const uint32_t bench_scan_length = 100;
+
+struct benchhashtable_t
+{
+	static constexpr const char * name = "hashtable";
+	static constexpr bool keyed = true, ordered = false;
+	basic_hashtable_t<uint32_t, uint32_t, growable_capacity_t> table;
+
+	uint32_t insert(uint32_t key) {table.set(key, key); return key;}
+	bool find(uint32_t key) const {return table.contains(key);}
+	void erase(uint32_t key, uint32_t) {table.remove(key);}
+	uint32_t scan(uint32_t, uint32_t) {return 0;}
+	size_t footprint() const {return (size_t)table.capacity * sizeof(table.arr[0]);}
+	void flush() const {bench_flush(table.arr, footprint());}
+};
+
+struct benchrbtree_t
+{
+	static constexpr const char * name = "rbtree";
+	static constexpr bool keyed = true, ordered = true;
+	basic_rbtree_t<uint32_t, uint32_t, growable_capacity_t> tree;
+	uint32_t keys[bench_scan_length], values[bench_scan_length];
+
+	uint32_t insert(uint32_t key) {tree.set(key, key); return key;}
+	bool find(uint32_t key) const {return tree.find_index(key) != tree.invalid;}
+	void erase(uint32_t key, uint32_t) {tree.remove(key);}
+	uint32_t scan(uint32_t key, uint32_t) {return tree.range(key, ~0u, keys, values, bench_scan_length);}
+	size_t footprint() const {return (size_t)tree.capacity * sizeof(tree.arr[0]);}
+	void flush() const {bench_flush(tree.arr, footprint());}
+};
+
+struct benchradixtree_t
+{
+	static constexpr const char * name = "radixtree";
+	static constexpr bool keyed = true, ordered = true;
+	radixtree_t tree;
+	uint64_t keys[bench_scan_length];
+	uint32_t values[bench_scan_length];
+
+	uint32_t insert(uint32_t key) {tree.set(key, key); return key;}
+	bool find(uint32_t key) const {return tree.contains(key);}
+	void erase(uint32_t key, uint32_t) {tree.remove(key);}
+	uint32_t scan(uint32_t key, uint32_t) {return (uint32_t)tree.range(key, ~0ull, keys, values, bench_scan_length);}
+	size_t footprint() const {return tree.memory();}
+	void flush() const
+	{
+		bench_flush(tree.leaves.arr, tree.leaves.capacity * sizeof(radixtree_t::leaf_t));
+		bench_flush(tree.nodes4.arr, tree.nodes4.capacity * sizeof(radixtree_t::node4_t));
+		bench_flush(tree.nodes16.arr, tree.nodes16.capacity * sizeof(radixtree_t::node16_t));
+		bench_flush(tree.nodes48.arr, tree.nodes48.capacity * sizeof(radixtree_t::node48_t));
+		bench_flush(tree.nodes256.arr, tree.nodes256.capacity * sizeof(radixtree_t::node256_t));
+	}
+};
+
+struct benchlinkedlist_t
+{
+	static constexpr const char * name = "linkedlist";
+	static constexpr bool keyed = false, ordered = true; // scan walks the links
+	basic_linkedlist_t<uint32_t, growable_capacity_t> list;
+
+	uint32_t insert(uint32_t key) {return list.insert(key);}
+	bool find(uint32_t) const {return false;}
+	void erase(uint32_t, uint32_t handle) {list.remove(handle);}
+	uint32_t scan(uint32_t, uint32_t handle)
+	{
+		uint32_t sum = 0;
+		for(uint32_t i = 0; i < bench_scan_length; ++i, handle = list.next(handle))
+			sum += list.value(handle);
+		return sum;
+	}
+	size_t footprint() const {return (size_t)list.capacity * sizeof(list.arr[0]);}
+	void flush() const {bench_flush(list.arr, footprint());}
+};
+
+struct benchbinaryheap_t
+{
+	static constexpr const char * name = "binaryheap";
+	static constexpr bool keyed = false, ordered = false; // churn pops the top
+	basic_binaryheap_t<uint32_t, growable_capacity_t> heap;
+
+	uint32_t insert(uint32_t key) {heap.insert(key); return key;}
+	bool find(uint32_t) const {return false;}
+	void erase(uint32_t, uint32_t) {heap.remove();}
+	uint32_t scan(uint32_t, uint32_t) {return 0;}
+	size_t footprint() const {return (size_t)heap.capacity * sizeof(heap.arr[0]);}
+	void flush() const {bench_flush(heap.arr, footprint());}
+};
+
+enum benchop_t {bench_insert, bench_hit, bench_miss, bench_churn, bench_scan, bench_op_count};
+
+// replays each op type on a container loaded with size keys: untimed for
+// throughput, then timed per op into histograms, with the container flushed
+// from every cache level before each op in the cold pass (skipped once it
+// no longer fits in cache anyway)
+template<typename adapter_t>
+static void bench_container(uint32_t size, uint32_t samples, uint32_t cold_samples, uint64_t overhead)
+{
+	static const char * names[bench_op_count] = {"insert", "lookup-hit", "lookup-miss", "delete-churn", "range-scan"};
+	const size_t cold_limit = 8u << 20;
+	xoshiro256_t rng;
+	auto next = [&rng]() {return rng.next32();};
+
+	uint32_t * keys = (uint32_t*)malloc(size * sizeof(uint32_t));
+	uint32_t * handles = (uint32_t*)malloc(size * sizeof(uint32_t));
+	uint32_t * inserted_keys = (uint32_t*)malloc((size / 8 + 1) * sizeof(uint32_t));
+	uint32_t * inserted = (uint32_t*)malloc((size / 8 + 1) * sizeof(uint32_t));
+	uint32_t fresh = size;
+	adapter_t * loaded = new adapter_t;
+	for(uint32_t i = 0; i < size; ++i)
+		handles[i] = loaded->insert(keys[i] = bench_key(i));
+
+	uint64_t sink = 0;
+	for(uint32_t op = 0; op < bench_op_count; ++op)
+	{
+		if((op == bench_hit || op == bench_miss) && !adapter_t::keyed)
+			continue;
+		if(op == bench_scan && !adapter_t::ordered)
+			continue;
+
+		benchhistogram_t * histograms = new benchhistogram_t[2];
+		double seconds = 0.0;
+		bool cold_run = false;
+		for(uint32_t pass = 0; pass < 3; ++pass)
+		{
+			benchhistogram_t * histogram = pass ? &histograms[pass - 1] : nullptr;
+			bool cold = pass == 2;
+			uint32_t count = cold ? cold_samples : samples;
+			if(cold && loaded->footprint() > cold_limit)
+				break;
+			cold_run = cold;
+
+			adapter_t * a = loaded;
+			auto run = [&](auto && body)
+			{
+				if(!histogram)
+				{
+					body();
+					return;
+				}
+				if(cold)
+					a->flush();
+				uint64_t start = bench_ticks();
+				body();
+				uint64_t ticks = bench_ticks() - start;
+				histogram->record(ticks > overhead ? ticks - overhead : 0);
+			};
+
+			double start = bench_seconds(), untimed = 0.0;
+			if(op == bench_insert)
+			{
+				// batches of new keys into the loaded container, taken out again
+				// untimed so every insert lands in a container of about size keys
+				uint32_t batch = size / 8 ? size / 8 : 1;
+				for(uint32_t done = 0; done < count;)
+				{
+					uint32_t n = count - done < batch ? count - done : batch;
+					for(uint32_t i = 0; i < n; ++i)
+					{
+						uint32_t key = bench_key(fresh++);
+						run([&]() {inserted[i] = a->insert(inserted_keys[i] = key);});
+					}
+					double erase_start = bench_seconds();
+					for(uint32_t i = 0; i < n; ++i)
+						a->erase(inserted_keys[i], inserted[i]);
+					untimed += bench_seconds() - erase_start;
+					done += n;
+				}
+			}
+			else
+				for(uint32_t i = 0; i < count; ++i)
+				{
+					uint32_t slot = next() % size;
+					if(op == bench_hit)
+						run([&]() {sink += a->find(keys[slot]);});
+					else if(op == bench_miss)
+					{
+						uint32_t key = bench_key(size + 0x40000000u + (next() & 0x3fffffffu));
+						run([&]() {sink += a->find(key);});
+					}
+					else if(op == bench_churn)
+					{
+						uint32_t key = bench_key(fresh++);
+						run([&]()
+						{
+							a->erase(keys[slot], handles[slot]);
+							handles[slot] = a->insert(keys[slot] = key);
+						});
+					}
+					else
+						run([&]() {sink += a->scan(keys[slot], handles[slot]);});
+				}
+			if(!pass)
+				seconds = bench_seconds() - start - untimed;
+		}
+
+		double ns = 1.0 / bench_ticks_per_ns();
+		const benchhistogram_t & warm = histograms[0], & cold = histograms[1];
+		printf("  %-10s %8u  %-12s %7.2f Mops  warm %7.0f %7.0f %7.0f", adapter_t::name, size, names[op],
+			   samples / seconds * 1e-6,
+			   warm.percentile(50) * ns, warm.percentile(99) * ns, warm.percentile(99.9) * ns);
+		if(cold_run)
+			printf("  cold %7.0f %7.0f %7.0f\n", cold.percentile(50) * ns, cold.percentile(99) * ns, cold.percentile(99.9) * ns);
+		else
+			printf("  cold       -       -       -\n");
+		delete[] histograms;
+	}
+
+	if(sink == 42)
+		printf("\n");
+	delete loaded;
+	free(keys);
+	free(handles);
+	free(inserted_keys);
+	free(inserted);
+}
+
+void bench_containers(uint32_t max_size, uint32_t samples, uint32_t cold_samples)
+{
+	// cost of the two tick reads themselves, taken off every sample
+	uint64_t overhead = ~0ull;
+	for(uint32_t i = 0; i < 1000; ++i)
+	{
+		uint64_t start = bench_ticks();
+		uint64_t ticks = bench_ticks() - start;
+		overhead = ticks < overhead ? ticks : overhead;
+	}
+
+	printf("containers, %u timed ops (%u cold), latency in ns p50 / p99 / p99.9\n", samples, cold_samples);
+	for(uint32_t size = 1u << 10; size <= max_size; size <<= 4)
+	{
+		bench_container<benchhashtable_t>(size, samples, cold_samples, overhead);
+		bench_container<benchrbtree_t>(size, samples, cold_samples, overhead);
+		bench_container<benchradixtree_t>(size, samples, cold_samples, overhead);
+		bench_container<benchlinkedlist_t>(size, samples, cold_samples, overhead);
+		bench_container<benchbinaryheap_t>(size, samples, cold_samples, overhead);
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// run with "letslearn bench [name]", numbers go to stdout
+double bench_seconds();
+// fenced cycle counter where there is one, nanoseconds elsewhere
+uint64_t bench_ticks();
+double bench_ticks_per_ns();
+
+// log linear latency histogram in the spirit of hdr histogram:
+// 32 linear steps per power of two keep every value within ~3%
+struct benchhistogram_t
+{
+	static const uint32_t sub_bits = 5;
+	static const uint32_t bucket_count = (64 - sub_bits + 1) << sub_bits;
+
+	uint64_t buckets[bucket_count];
+	uint64_t count;
+	uint64_t min;
+	uint64_t max;
+
+	benchhistogram_t() {clear();}
+	void clear();
+	void record(uint64_t value);
+	// highest value of the bucket holding the p-th percentile, p in [0, 100]
+	uint64_t percentile(double p) const;
+
+	static uint32_t bucket(uint64_t value);
+	static uint64_t lower(uint32_t bucket);
+};
+
+void bench_cuckoofilter(uint32_t capacity = 1u << 22);
+void bench_radixtree(uint32_t count = 1u << 20);
+void bench_spatial(uint32_t count = 1u << 20, uint32_t queries = 1u << 16);
+void bench_rtree(uint32_t count = 1u << 20, uint32_t queries = 1u << 16);
+void bench_graph(uint32_t width = 1000, uint32_t queries = 100);
+// bulk build and probe of hashtable_t, partitioned hash join vs sort merge join
+void bench_join(uint32_t build_count = 1u << 22, uint32_t probe_count = 1u << 23);
+// group by on low, medium and high cardinality keys, hash vs sort path and the auto pick
+void bench_aggregate(uint32_t count = 1u << 24);
+// bulk input generation per distribution and thread count, against rand() and a scalar generator
+void bench_workload(size_t count = (size_t)1 << 28);
+// sortedness check and multiset fingerprint against the scalar validate loop
+void bench_verify(size_t count = (size_t)1 << 28);
+// sliding window percentiles, counted rbtree against sorting a copy of the window
+void bench_percentile(uint32_t window = 1u << 16, uint32_t updates = 1u << 20);
+// lower_bound over a size sweep, binary search against the eytzinger and static b+ tree layouts
+// 1e9 keys needs about 12 GB for all three copies, pass max_count to go past the default
+void bench_search(size_t max_count = (size_t)1 << 27, uint32_t queries = 1u << 20);
+// sorted set intersection over size ratios merge vs simd vs gallop, unique and k way union
+void bench_sets(uint32_t count = 1u << 22);
+// compressed column size, block decode against scanning the plain array, search on both
+void bench_column(size_t count = (size_t)1 << 27, uint32_t queries = 1u << 20);
+// forked quick, merge and bitonic sort from 1 to max_threads workers, checked against one
+void bench_tasks(size_t count = (size_t)1 << 24, uint32_t max_threads = 64);
+// trace replay of zipf, scan polluted and looping requests, hit ratio and throughput of lru, clock and sieve, sharded scaling
+void bench_cache(uint32_t requests = 1u << 24, uint32_t universe = 1u << 20, uint32_t max_threads = 16);
+// url and sentence corpora generated from zipf words, std::sort against multikey quicksort and msd radix, parallel radix over threads
+void bench_stringsort(size_t count = (size_t)1 << 21, uint32_t max_threads = 16);
+// op mixes against every container over a size sweep, warm and cold caches
+void bench_containers(uint32_t max_size = 1u << 22, uint32_t samples = 1u << 17, uint32_t cold_samples = 1u << 10);
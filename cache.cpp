@@ -0,0 +1,4 @@
+#include "cache.h"
+
+template struct basic_cache_t<>;
+template struct basic_shardedcache_t<>;
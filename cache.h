@@ -0,0 +1,232 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mutex>
+#include "containers.h"
+
+// bounded key -> value cache: a hashtable_t from key to a linkedlist_t node
+// that holds the key, values and visited bits live in arrays beside the nodes
+// both are sized once for capacity entries, so get, put and evict are O(1)
+// and the memory never changes after construction
+
+enum cachepolicy_t
+{
+	cachepolicy_lru,   // hits move to the back, evicts the front
+	cachepolicy_clock, // hits set a bit, the hand clears bits until an unset one, new entries go behind the hand
+	cachepolicy_sieve, // like clock but new entries go to the back, so the hand only sweeps old ones
+};
+
+struct cachecounters_t
+{
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+
+	double hit_rate() const {return hits + misses ? (double)hits / (double)(hits + misses) : 0.0;}
+	void add(const cachecounters_t & other)
+	{
+		hits += other.hits;
+		misses += other.misses;
+		evictions += other.evictions;
+	}
+};
+
+template<typename key_t = uint32_t, typename value_t = uint32_t>
+struct basic_cache_t
+{
+	using list_t = basic_linkedlist_t<key_t, growable_capacity_t>;
+	using table_t = basic_hashtable_t<key_t, uint32_t, growable_capacity_t>;
+	static constexpr uint32_t invalid = list_t::invalid;
+
+	list_t list; // front (next of last) is the oldest entry
+	table_t table;
+	value_t * values = nullptr;
+	uint8_t * visited = nullptr;
+	uint32_t capacity = 0;
+	uint32_t count = 0;
+	uint32_t hand = invalid;
+	cachepolicy_t policy = cachepolicy_lru;
+	cachecounters_t counters;
+
+	basic_cache_t(uint32_t capacity = 1024, cachepolicy_t policy = cachepolicy_lru) : capacity(capacity ? capacity : 1), policy(policy)
+	{
+		// every node up front, the table at half load so it never grows either
+		list.reserve(this->capacity);
+		list.link_free(0, list.capacity);
+		table.reserve((uint64_t)this->capacity * 2);
+		values = new value_t[list.capacity]();
+		visited = new uint8_t[list.capacity]();
+	}
+	~basic_cache_t()
+	{
+		delete[] values;
+		delete[] visited;
+	}
+	basic_cache_t(const basic_cache_t &) = delete;
+	basic_cache_t & operator=(const basic_cache_t &) = delete;
+
+	// public
+	bool get(key_t key, value_t & value)
+	{
+		const uint32_t * node = table.find(key);
+		if(!node)
+		{
+			++counters.misses;
+			return false;
+		}
+		++counters.hits;
+		touch(*node);
+		value = values[*node];
+		return true;
+	}
+	// a present key is updated and counts as used, the oldest entry makes room when full
+	bool put(key_t key, value_t value)
+	{
+		const uint32_t * found = table.find(key);
+		if(found)
+		{
+			touch(*found);
+			values[*found] = value;
+			return true;
+		}
+		if(count == capacity)
+			evict();
+		uint32_t node = policy == cachepolicy_clock && hand != invalid ? list.insert_before(key, hand) : list.insert(key);
+		if(!table.set(key, node))
+		{
+			remove_node(node);
+			return false;
+		}
+		values[node] = value;
+		visited[node] = 0;
+		++count;
+		return true;
+	}
+	bool contains(key_t key) const {return table.contains(key);}
+	void remove(key_t key)
+	{
+		const uint32_t * node = table.find(key);
+		if(!node)
+			return;
+		uint32_t index = *node;
+		table.remove(key);
+		remove_node(index);
+		--count;
+	}
+	void clear()
+	{
+		while(count)
+			remove(list.value(list.last()));
+		counters = cachecounters_t();
+	}
+
+	// private
+	void touch(uint32_t node)
+	{
+		if(policy == cachepolicy_lru)
+			list.move_after(node, list.last());
+		else
+			visited[node] = 1;
+	}
+	void evict()
+	{
+		uint32_t victim = list.next(list.last());
+		if(policy != cachepolicy_lru)
+		{
+			// second chances from the hand on, it wraps from the back to the front
+			hand = hand != invalid ? hand : victim;
+			while(visited[hand])
+			{
+				visited[hand] = 0;
+				hand = list.next(hand);
+			}
+			victim = hand;
+		}
+		table.remove(list.value(victim));
+		remove_node(victim);
+		--count;
+		++counters.evictions;
+	}
+	void remove_node(uint32_t node)
+	{
+		if(hand == node)
+			hand = list.next(node) != node ? list.next(node) : invalid;
+		list.remove(node);
+	}
+};
+
+// shards of basic_cache_t behind a mutex each, keys spread by a hash of their own
+// so a shard's table still sees all bits; capacity is split evenly
+template<typename key_t = uint32_t, typename value_t = uint32_t>
+struct basic_shardedcache_t
+{
+	struct alignas(64) shard_t
+	{
+		std::mutex mutex;
+		basic_cache_t<key_t, value_t> * cache = nullptr;
+	};
+
+	shard_t * shards = nullptr;
+	uint32_t shard_bits = 0;
+
+	// shards rounds up to a power of two
+	basic_shardedcache_t(uint32_t capacity, cachepolicy_t policy = cachepolicy_lru, uint32_t shards = 16)
+	{
+		while((1u << shard_bits) < shards)
+			++shard_bits;
+		uint32_t count = 1u << shard_bits;
+		this->shards = new shard_t[count];
+		for(uint32_t i = 0; i < count; ++i)
+			this->shards[i].cache = new basic_cache_t<key_t, value_t>((capacity + count - 1) / count, policy);
+	}
+	~basic_shardedcache_t()
+	{
+		for(uint32_t i = 0; i < (1u << shard_bits); ++i)
+			delete shards[i].cache;
+		delete[] shards;
+	}
+	basic_shardedcache_t(const basic_shardedcache_t &) = delete;
+	basic_shardedcache_t & operator=(const basic_shardedcache_t &) = delete;
+
+	shard_t & shard(key_t key)
+	{
+		uint32_t hash = containers_fold(key) * 0x9e3779b1u;
+		return shards[shard_bits ? hash >> (32 - shard_bits) : 0];
+	}
+	bool get(key_t key, value_t & value)
+	{
+		shard_t & s = shard(key);
+		std::lock_guard<std::mutex> lock(s.mutex);
+		return s.cache->get(key, value);
+	}
+	bool put(key_t key, value_t value)
+	{
+		shard_t & s = shard(key);
+		std::lock_guard<std::mutex> lock(s.mutex);
+		return s.cache->put(key, value);
+	}
+	void remove(key_t key)
+	{
+		shard_t & s = shard(key);
+		std::lock_guard<std::mutex> lock(s.mutex);
+		s.cache->remove(key);
+	}
+	// summed over shards, each read under its lock
+	cachecounters_t counters()
+	{
+		cachecounters_t total;
+		for(uint32_t i = 0; i < (1u << shard_bits); ++i)
+		{
+			std::lock_guard<std::mutex> lock(shards[i].mutex);
+			total.add(shards[i].cache->counters);
+		}
+		return total;
+	}
+};
+
+using cache_t = basic_cache_t<>;
+using shardedcache_t = basic_shardedcache_t<>;
+
+extern template struct basic_cache_t<>;
+extern template struct basic_shardedcache_t<>;
@@ -0,0 +1,190 @@
+#include "column.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// a lane packs 32 values
+static const uint32_t column_lane_values = column_t::block_size / 4;
+
+column_t::~column_t()
+{
+	free(blocks);
+	free(words);
+}
+
+bool column_t::build(const uint32_t * sorted, size_t count)
+{
+	free(blocks);
+	free(words);
+	block_count = (count + block_size - 1) / block_size;
+	// the worst case is every block at 32 bits, shrunk once packed
+	blocks = (columnblock_t*)malloc((block_count ? block_count : 1) * sizeof(columnblock_t));
+	words = (uint32_t*)malloc((block_count ? block_count : 1) * block_size * sizeof(uint32_t));
+	word_count = 0;
+	if(!blocks || !words)
+	{
+		this->count = block_count = 0;
+		return false;
+	}
+	this->count = count;
+
+	for(size_t block = 0; block < block_count; ++block)
+	{
+		// a short last block repeats its last value, gaps of 0 cost nothing
+		const uint32_t * values = sorted + block * block_size;
+		size_t size = count - block * block_size < block_size ? count - block * block_size : block_size;
+		uint32_t gaps[block_size];
+		uint32_t used = 0;
+		gaps[0] = 0;
+		for(size_t i = 1; i < block_size; ++i)
+		{
+			gaps[i] = i < size ? values[i] - values[i - 1] : 0;
+			used |= gaps[i];
+		}
+		uint32_t bits = used ? 32 - __builtin_clz(used) : 0;
+		blocks[block] = {values[0], bits, word_count};
+
+		uint32_t * packed = words + word_count;
+		memset(packed, 0, 4 * bits * sizeof(uint32_t));
+		for(uint32_t i = 0; bits && i < column_lane_values; ++i)
+		{
+			uint32_t shift = i * bits % 32, word = i * bits / 32;
+			for(uint32_t lane = 0; lane < 4; ++lane)
+			{
+				uint32_t gap = gaps[i * 4 + lane];
+				packed[word * 4 + lane] |= gap << shift;
+				if(shift + bits > 32)
+					packed[(word + 1) * 4 + lane] |= gap >> (32 - shift);
+			}
+		}
+		word_count += 4 * bits;
+	}
+	if(word_count)
+	{
+		uint32_t * shrunk = (uint32_t*)realloc(words, word_count * sizeof(uint32_t));
+		words = shrunk ? shrunk : words;
+	}
+	return true;
+}
+
+#if defined(__AVX2__)
+// every shift and word index is a constant once the loop is unrolled for a width
+template<uint32_t bits>
+static void column_unpack(const uint32_t * packed, uint32_t first, uint32_t * out)
+{
+	const __m128i * in = (const __m128i*)packed;
+	const __m128i mask = _mm_set1_epi32((int)(uint32_t)(((uint64_t)1 << bits) - 1));
+	__m128i carry = _mm_set1_epi32((int)first);
+	#pragma GCC unroll 32
+	for(uint32_t i = 0; i < column_lane_values; ++i)
+	{
+		__m128i gaps = _mm_setzero_si128();
+		if constexpr(bits > 0)
+		{
+			const uint32_t shift = i * bits % 32, word = i * bits / 32;
+			gaps = _mm_srli_epi32(_mm_loadu_si128(in + word), shift);
+			if(shift + bits > 32)
+				gaps = _mm_or_si128(gaps, _mm_slli_epi32(_mm_loadu_si128(in + word + 1), 32 - shift));
+			if(bits < 32)
+				gaps = _mm_and_si128(gaps, mask);
+		}
+		// prefix sum over the 4 lanes, then on top of the last value so far
+		gaps = _mm_add_epi32(gaps, _mm_slli_si128(gaps, 4));
+		gaps = _mm_add_epi32(gaps, _mm_slli_si128(gaps, 8));
+		__m128i values = _mm_add_epi32(gaps, carry);
+		_mm_storeu_si128((__m128i*)(out + i * 4), values);
+		carry = _mm_shuffle_epi32(values, 0xff);
+	}
+}
+
+template<uint32_t... widths>
+struct columnunpackers_t
+{
+	static constexpr void (*table[])(const uint32_t *, uint32_t, uint32_t *) = {column_unpack<widths>...};
+};
+
+static void (* const * column_unpackers())(const uint32_t *, uint32_t, uint32_t *)
+{
+	return columnunpackers_t<0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+							 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32>::table;
+}
+#endif
+
+uint32_t column_t::decode_block(size_t block, uint32_t * out) const
+{
+	const columnblock_t & header = blocks[block];
+	const uint32_t * packed = words + header.offset;
+	#if defined(__AVX2__)
+	column_unpackers()[header.bits](packed, header.first, out);
+	#else
+	uint32_t bits = header.bits, value = header.first;
+	uint32_t mask = (uint32_t)(((uint64_t)1 << bits) - 1);
+	for(uint32_t i = 0; i < column_lane_values; ++i)
+	{
+		uint32_t shift = i * bits % 32, word = i * bits / 32;
+		for(uint32_t lane = 0; lane < 4; ++lane)
+		{
+			uint64_t pair = 0;
+			if(bits)
+				pair = packed[word * 4 + lane] | (shift + bits > 32 ? (uint64_t)packed[(word + 1) * 4 + lane] << 32 : 0);
+			value += (uint32_t)(pair >> shift) & mask;
+			out[i * 4 + lane] = value;
+		}
+	}
+	#endif
+	size_t first = block * block_size;
+	return count - first < block_size ? (uint32_t)(count - first) : block_size;
+}
+
+void column_t::decode(uint32_t * out) const
+{
+	// whole blocks straight into out, the last one through a buffer
+	size_t full = count / block_size;
+	for(size_t block = 0; block < full; ++block)
+		decode_block(block, out + block * block_size);
+	if(full < block_count)
+	{
+		uint32_t values[block_size];
+		uint32_t size = decode_block(full, values);
+		memcpy(out + full * block_size, values, size * sizeof(uint32_t));
+	}
+}
+
+uint32_t column_t::at(size_t index) const
+{
+	uint32_t values[block_size];
+	decode_block(index / block_size, values);
+	return values[index % block_size];
+}
+
+size_t column_t::lower_bound(uint32_t key) const
+{
+	// blocks starting below key on the skip index, the answer is in the last of them
+	size_t low = 0, high = block_count;
+	while(low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+		if(blocks[middle].first < key)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	if(!low)
+		return 0;
+	uint32_t values[block_size];
+	uint32_t size = decode_block(low - 1, values);
+	// counted without a branch, the padding repeats the last value so size caps it
+	uint32_t below = 0;
+	for(uint32_t i = 0; i < block_size; ++i)
+		below += values[i] < key;
+	return (low - 1) * block_size + (below < size ? below : size);
+}
+
+bool column_t::contains(uint32_t key) const
+{
+	size_t position = lower_bound(key);
+	return position < count && at(position) == key;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dataset.h"
+
+// compressed sorted uint32 column: blocks of 128 values stored as the gaps
+// between neighbours, bit packed at the width of the largest gap of the block
+// in the simd-bp128 vertical layout (value 4i + lane is the i-th packed value
+// of lane), so 4 lanes unpack with one shift and mask each and a 4 wide
+// prefix sum from the block's first value turns them back into values
+struct columnblock_t
+{
+	uint32_t first;  // the skip index, searched before any block is decoded
+	uint32_t bits;   // of every gap in the block, 0 when its values are all equal
+	uint64_t offset; // in words, a block takes 4 * bits of them
+};
+
+struct column_t
+{
+	static const uint32_t block_size = 128;
+
+	columnblock_t * blocks = nullptr;
+	uint32_t * words = nullptr;
+	size_t block_count = 0;
+	size_t word_count = 0;
+	size_t count = 0;
+
+	column_t() = default;
+	~column_t();
+	column_t(const column_t &) = delete;
+	column_t & operator=(const column_t &) = delete;
+
+	bool build(const uint32_t * sorted, size_t count);
+	bool build(const dataset_t & data) {return build(data.items, data.count);}
+	// packed words and the skip index
+	size_t bytes() const {return word_count * sizeof(uint32_t) + block_count * sizeof(columnblock_t);}
+
+	// out holds block_size, returns how many values the block has
+	uint32_t decode_block(size_t block, uint32_t * out) const;
+	// out holds count
+	void decode(uint32_t * out) const;
+	uint32_t at(size_t index) const;
+	// first position with a value >= key, count if there is none
+	size_t lower_bound(uint32_t key) const;
+	bool contains(uint32_t key) const;
+};
@@ -1,197 +1,1669 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <type_traits>
+#include <utility>
+#include <thread>
+#include "filters.h"
+#include "stats.h"
 
 uint32_t hash_fnv1(uint32_t key);
+uint32_t hash_fnv1(uint64_t key);
 
-struct linkedlist_t
+// containers are templates over key / value types, capacity policy and index width
+// the old fixed uint32_t containers are the default arguments, see the aliases at the bottom
+
+// capacity policies
+// fixed keeps N nodes inline so a container is one flat block (snapshots map it as is)
+template<uint32_t N>
+struct fixed_capacity_t
+{
+	static constexpr bool growable = false;
+	static constexpr uint32_t size = N;
+};
+
+// growable keeps nodes on the heap and doubles them when full
+struct growable_capacity_t
+{
+	static constexpr bool growable = true;
+	static constexpr uint32_t size = 16; // first allocation
+};
+
+// narrowest index that addresses every node and still spares invalid
+template<typename capacity_t>
+using containerindex_t = typename std::conditional<!capacity_t::growable && capacity_t::size < 0xffffu, uint16_t, uint32_t>::type;
+
+// how a free hashtable slot is told apart from a taken one
+struct sentinel_slots_t {}; // key with all bits set marks free, that key can not be stored
+struct flagged_slots_t {};  // separate taken flag, every key can be stored
+
+// all bits set for integers, returned by lookups that miss
+template<typename value_t>
+constexpr value_t containers_none()
+{
+	if constexpr (std::is_integral<value_t>::value)
+		return (value_t)~(value_t)0;
+	else
+		return value_t();
+}
+
+template<typename key_t>
+inline uint32_t containers_hash(key_t key)
+{
+	if constexpr (sizeof(key_t) > sizeof(uint32_t))
+		return hash_fnv1((uint64_t)key);
+	else
+		return hash_fnv1((uint32_t)key);
+}
+
+// bloom filters take 32 bit keys, folding only adds false positives
+template<typename key_t>
+inline uint32_t containers_fold(key_t key)
 {
-	static const uint32_t invalid = 0xffffffffu;
+	if constexpr (sizeof(key_t) > sizeof(uint32_t))
+		return (uint32_t)((uint64_t)key ^ (uint64_t)key >> 32);
+	else
+		return (uint32_t)key;
+}
 
-	struct node_t
+// runs function(t) for t in [0, threads) on threads of its own, inline for one
+template<typename function_t>
+void containers_parallel(uint32_t threads, function_t function)
+{
+	if(threads <= 1)
 	{
-		uint32_t value = invalid;
-		uint32_t prev = invalid;
-		uint32_t next = invalid;
-		inline void free() {value = invalid;}
-		inline bool taken() const {return value != invalid;}
-	};
+		function(0);
+		return;
+	}
+	std::thread * workers = new std::thread[threads];
+	for(uint32_t t = 0; t < threads; ++t)
+		workers[t] = std::thread([=]() {function(t);});
+	for(uint32_t t = 0; t < threads; ++t)
+		workers[t].join();
+	delete[] workers;
+}
 
-	// to simplify memory management let's say
-	// linked list can only contain up to N elements
-	static const uint32_t count = 7;
-	node_t arr[count];
-	uint32_t last_index = invalid;
-	uint32_t next_free = 0;
-
-	linkedlist_t();
-	uint32_t allocate();
-	void deallocate(uint32_t index);
-	uint32_t last() const {return last_index;}
-	uint32_t next(uint32_t index) const {return index != invalid ? arr[index].next : invalid;}
-	uint32_t prev(uint32_t index) const {return index != invalid ? arr[index].prev: invalid;}
-	uint32_t value(uint32_t index) const {return index != invalid ? arr[index].value: invalid;}
-	uint32_t insert(uint32_t value) {return insert_after(value, last());}
-	uint32_t insert_after(uint32_t value, uint32_t index);
-	uint32_t insert_before(uint32_t value, uint32_t index);
-	void remove(uint32_t index);
-	void print() const;
+inline uint32_t containers_threads(uint32_t threads)
+{
+	threads = threads ? threads : std::thread::hardware_concurrency();
+	return threads ? threads : 1;
+}
+
+template<typename node_t, typename index_t, typename capacity_t>
+struct containerstorage_t
+{
+	static_assert(capacity_t::size < (index_t)~(index_t)0, "index type too narrow for capacity");
+
+	static constexpr index_t capacity = capacity_t::size;
+	node_t arr[capacity_t::size];
 };
 
-struct hashtable_t
+template<typename node_t, typename index_t>
+struct containerstorage_t<node_t, index_t, growable_capacity_t>
 {
-	static const uint32_t invalid = 0xffffffffu;
+	node_t * arr = nullptr;
+	index_t capacity = 0;
 
-	struct entry_t
+	containerstorage_t() = default;
+	containerstorage_t(const containerstorage_t & other) {*this = other;}
+	~containerstorage_t() {delete[] arr;}
+	containerstorage_t & operator=(const containerstorage_t & other)
 	{
-		uint32_t key = invalid;
-		uint32_t value = invalid;
+		if(this != &other)
+		{
+			delete[] arr;
+			arr = other.capacity ? new node_t[other.capacity] : nullptr;
+			capacity = other.capacity;
+			for(index_t i = 0; i < capacity; ++i)
+				arr[i] = other.arr[i];
+		}
+		return *this;
+	}
 
-		inline void free() {key = invalid; value = invalid;}
-		inline bool taken() const {return key != invalid || value != invalid;}
-	};
+	// at least size nodes, new ones are default (free)
+	// false once the index type can not address more
+	bool reserve(uint64_t size)
+	{
+		if(size <= capacity)
+			return true;
+		uint64_t grown = capacity ? capacity : growable_capacity_t::size;
+		while(grown < size)
+			grown *= 2;
+		if(grown >= (index_t)~(index_t)0)
+			return false;
+		node_t * nodes = new node_t[grown];
+		for(index_t i = 0; i < capacity; ++i)
+			nodes[i] = arr[i];
+		delete[] arr;
+		arr = nodes;
+		capacity = (index_t)grown;
+		return true;
+	}
+	void swap(containerstorage_t & other)
+	{
+		std::swap(arr, other.arr);
+		std::swap(capacity, other.capacity);
+	}
+};
 
-	// to simplify memory management let's say
-	// hashtable can only contain up to N elements
-	static const uint32_t count = 256;
-	entry_t arr[count];
+template<typename value_t, typename index_t>
+struct linkedlistnode_t
+{
+	static constexpr index_t invalid = (index_t)~(index_t)0;
 
-	uint32_t index(uint32_t key, bool next_free = false) const;
-	bool contains(uint32_t key) const {return index(key) != invalid;}
-	bool set(uint32_t key, uint32_t value);
-	uint32_t get(uint32_t key) const;
-	void remove(uint32_t key);
+	value_t value = containers_none<value_t>();
+	index_t prev = invalid;
+	index_t next = invalid;
+	inline void free() {value = containers_none<value_t>();}
+};
 
+template<typename value_t = uint32_t, typename capacity_t = fixed_capacity_t<7>, typename index_t = containerindex_t<capacity_t>>
+struct basic_linkedlist_t : containerstorage_t<linkedlistnode_t<value_t, index_t>, index_t, capacity_t>
+{
+	using node_t = linkedlistnode_t<value_t, index_t>;
+	using storage_t = containerstorage_t<node_t, index_t, capacity_t>;
+	using storage_t::arr;
+	using storage_t::capacity;
+	static constexpr index_t invalid = node_t::invalid;
+	static constexpr value_t none = containers_none<value_t>();
+
+	index_t last_index = invalid;
+	index_t next_free = invalid;
+
+	basic_linkedlist_t() {link_free(0, capacity);}
+	index_t allocate();
+	void deallocate(index_t index);
+	index_t last() const {return last_index;}
+	index_t next(index_t index) const {return index != invalid ? arr[index].next : invalid;}
+	index_t prev(index_t index) const {return index != invalid ? arr[index].prev: invalid;}
+	value_t value(index_t index) const {return index != invalid ? arr[index].value: none;}
+	index_t insert(value_t value) {return insert_after(value, last());}
+	index_t insert_after(value_t value, index_t index);
+	index_t insert_before(value_t value, index_t index);
+	// relinks index after target (last when invalid), no reallocation
+	// index becomes last only when target was last, last moves back a node when index was it
+	void move_after(index_t index, index_t target);
+	void remove(index_t index);
 	void print() const;
+
+	// private
+	void link_free(index_t first, index_t last);
+	bool grow();
 };
 
-struct rbtree_t
+// open addressing with linear probing, entries are inline key / value pairs
+template<typename key_t, typename value_t, bool flagged>
+struct hashtableentry_t
 {
-	static const uint32_t invalid = 0xffffffffu;
+	static constexpr key_t sentinel = containers_none<key_t>();
 
-	struct node_t
+	key_t key = sentinel;
+	value_t value = containers_none<value_t>();
+};
+
+template<typename key_t, typename value_t>
+struct hashtableentry_t<key_t, value_t, true>
+{
+	key_t key = key_t();
+	value_t value = containers_none<value_t>();
+	bool used = false;
+};
+
+template<typename key_t = uint32_t, typename value_t = uint32_t, typename capacity_t = fixed_capacity_t<256>,
+		 typename slots_t = flagged_slots_t, typename index_t = containerindex_t<capacity_t>>
+struct basic_hashtable_t : containerstorage_t<hashtableentry_t<key_t, value_t, std::is_same<slots_t, flagged_slots_t>::value>, index_t, capacity_t>
+{
+	static constexpr bool flagged = std::is_same<slots_t, flagged_slots_t>::value;
+	using entry_t = hashtableentry_t<key_t, value_t, flagged>;
+	using storage_t = containerstorage_t<entry_t, index_t, capacity_t>;
+	using storage_t::arr;
+	using storage_t::capacity;
+	static constexpr index_t invalid = (index_t)~(index_t)0;
+	static constexpr value_t none = containers_none<value_t>();
+
+	index_t size = 0;
+
+	// optional front filter, most misses stop there instead of probing
+	bloomfilter_t * filter = nullptr;
+
+	void set_filter(bloomfilter_t * new_filter);
+	index_t index(key_t key, bool next_free = false) const;
+	bool contains(key_t key) const {return index(key) != invalid;}
+	bool set(key_t key, value_t value);
+	value_t get(key_t key) const;
+	const value_t * find(key_t key) const; // null on miss, unlike get a stored none is told apart
+	// value under key, value is stored first when key is missing (inserted tells which)
+	// one probe for find or set, null when the table is full
+	value_t * upsert(key_t key, value_t value, bool & inserted);
+	void remove(key_t key);
+	void clear();
+	// every value stored under key, set keeps duplicates
+	template<typename visit_t>
+	void find_all(key_t key, visit_t visit) const
 	{
-		uint32_t key = invalid;
-		uint32_t value = invalid;
-		uint32_t left = invalid;
-		uint32_t right = invalid;
-		uint32_t parent = invalid;
-		bool color = false; // 0 black, 1 red
+		index_t j = capacity ? home(key) : 0;
+		for(index_t i = 0; i < capacity && taken(j); ++i, j = following(j))
+			if(arr[j].key == key)
+				visit(arr[j].value);
+	}
+	void prefetch(key_t key) const {if(capacity) __builtin_prefetch(&arr[home(key)]);}
 
-		inline void free()
-		{
-			key = invalid;
-			value = invalid;
-			left = invalid;
-			right = invalid;
-			parent = invalid;
-			color = false;
-		}
-		inline bool taken() const {return key != invalid;}
-	};
+	// same as set for every pair, but the input is radix partitioned by home
+	// slot first so each thread fills its own cache sized slice of the table
+	bool build(const key_t * keys, const value_t * values, size_t count, uint32_t threads = 0);
+	// get for a batch, homes are hashed a few keys ahead and prefetched
+	// values gets none for misses, returns the number of hits
+	size_t probe(const key_t * keys, size_t count, value_t * values, uint32_t threads = 0) const;
+	// growable only, at least slots slots (a power of two), entries are kept
+	bool rehash(uint64_t slots);
 
-	// to simplify memory management let's say
-	// rb tree can only contain up to N elements
-	static const uint32_t count = 256;
-	node_t arr[count];
-	uint32_t root = invalid;
+	void print() const;
+
+	// private
+	static bool taken(const entry_t & entry)
+	{
+		if constexpr (flagged)
+			return entry.used;
+		else
+			return entry.key != entry_t::sentinel;
+	}
+	bool taken(index_t i) const {return taken(arr[i]);}
+	void release(index_t i)
+	{
+		arr[i] = entry_t();
+	}
+	index_t home(key_t key) const
+	{
+		if constexpr (capacity_t::growable)
+			return containers_hash(key) & (capacity - 1); // always a power of two
+		else
+			return containers_hash(key) % capacity;
+	}
+	index_t following(index_t i) const {return i + 1 == capacity ? 0 : i + 1;}
+	index_t index_from(key_t key, index_t start, bool next_free) const;
+	bool place(key_t key, value_t value);
+	bool grow() {return rehash(capacity ? (uint64_t)capacity * 2 : capacity_t::size);}
+	size_t probe_range(const key_t * keys, size_t first, size_t last, value_t * values) const;
+};
+
+// nodes of a counted tree also keep the size of their subtree (order statistics)
+template<typename index_t, bool counted>
+struct rbtreecount_t {};
+
+template<typename index_t>
+struct rbtreecount_t<index_t, true>
+{
+	index_t size = 0;
+};
+
+template<typename key_t, typename value_t, typename index_t, bool counted = false>
+struct rbtreenode_t : rbtreecount_t<index_t, counted>
+{
+	static constexpr index_t invalid = (index_t)~(index_t)0;
+	static constexpr uint8_t unused = 2; // third color marks free nodes, no key is reserved
+
+	key_t key = key_t();
+	value_t value = containers_none<value_t>();
+	index_t left = invalid;
+	index_t right = invalid;
+	index_t parent = invalid;
+	uint8_t color = unused; // 0 black, 1 red
+
+	inline void free() {*this = rbtreenode_t();}
+	inline bool taken() const {return color != unused;}
+};
+
+// counted trees pay a subtree size per node and its upkeep on every change for
+// rank, select and count_range in O(log n) instead of an in order walk
+template<typename key_t = uint32_t, typename value_t = uint32_t, typename capacity_t = fixed_capacity_t<256>, bool counted = false, typename index_t = containerindex_t<capacity_t>>
+struct basic_rbtree_t : containerstorage_t<rbtreenode_t<key_t, value_t, index_t, counted>, index_t, capacity_t>
+{
+	using node_t = rbtreenode_t<key_t, value_t, index_t, counted>;
+	using storage_t = containerstorage_t<node_t, index_t, capacity_t>;
+	using storage_t::arr;
+	using storage_t::capacity;
+	static constexpr index_t invalid = node_t::invalid;
+	static constexpr value_t none = containers_none<value_t>();
+
+	index_t root = invalid;
+	index_t free_list = invalid; // released nodes, linked through right
+	index_t top = 0;             // nodes from top on were never used
+
+	// validate() walks the whole tree, only small fixed trees check it on every change
+	static constexpr bool validated = !capacity_t::growable && capacity_t::size <= 4096;
 
 	// public
-	uint32_t get(uint32_t key) const;
-	void set(uint32_t key, uint32_t value, bool force_insert = false);
-	void remove(uint32_t key);
+	value_t get(key_t key) const;
+	const value_t * find(key_t key) const;
+	bool set(key_t key, value_t value, bool force_insert = false);
+	void remove(key_t key);
+	// in order walk: first node with key >= given key, then successors
+	index_t lower_bound(key_t key) const;
+	index_t successor(index_t index) const;
+	// lo <= key <= hi in order, returns how many were written (up to max)
+	uint32_t range(key_t lo, key_t hi, key_t * keys, value_t * values, uint32_t max) const;
+
+	// counted trees only, calls on an uncounted tree do not compile
+	template<bool c = counted, typename = std::enable_if_t<c>>
+	index_t count() const {return subtree_size(root);}
+	// keys below key, or up to and including it
+	template<bool c = counted, typename = std::enable_if_t<c>>
+	index_t rank(key_t key, bool inclusive = false) const;
+	// node of the k-th smallest key (from 0), invalid past the end
+	template<bool c = counted, typename = std::enable_if_t<c>>
+	index_t select(index_t k) const;
+	// keys with lo <= key <= hi
+	template<bool c = counted, typename = std::enable_if_t<c>>
+	index_t count_range(key_t lo, key_t hi) const;
+	// nearest rank p-th percentile, p in [0, 100], invalid when empty
+	template<bool c = counted, typename = std::enable_if_t<c>>
+	index_t percentile(double p) const;
 
 	// private
-	uint32_t allocate();
-	uint32_t parent(uint32_t index) const {return index != invalid ? arr[index].parent : invalid;}
-	uint32_t left(uint32_t index) const {return index != invalid ? arr[index].left : invalid;}
-	uint32_t right(uint32_t index) const {return index != invalid ? arr[index].right : invalid;}
-	uint32_t grandparent(uint32_t index) const {return parent(parent(index));}
-	uint32_t sibling(uint32_t index) const {return left(parent(index)) == index ? right(parent(index)) : left(parent(index));}
-	uint32_t uncle(uint32_t index) const {return sibling(parent(index));}
-	bool color(uint32_t index) const {return index != invalid ? arr[index].color : false;}
-	void set_color(uint32_t index, bool color);
+	index_t allocate();
+	void deallocate(index_t index);
+	index_t parent(index_t index) const {return index != invalid ? arr[index].parent : invalid;}
+	index_t left(index_t index) const {return index != invalid ? arr[index].left : invalid;}
+	index_t right(index_t index) const {return index != invalid ? arr[index].right : invalid;}
+	index_t grandparent(index_t index) const {return parent(parent(index));}
+	index_t sibling(index_t index) const {return left(parent(index)) == index ? right(parent(index)) : left(parent(index));}
+	index_t uncle(index_t index) const {return sibling(parent(index));}
+	bool color(index_t index) const {return index != invalid ? arr[index].color == 1 : false;}
+	void set_color(index_t index, bool color);
+	index_t subtree_size(index_t index) const
+	{
+		if constexpr (counted)
+			return index != invalid ? arr[index].size : 0;
+		else
+			return 0;
+	}
+	void update_size(index_t index)
+	{
+		if constexpr (counted)
+			arr[index].size = 1 + subtree_size(left(index)) + subtree_size(right(index));
+	}
 	bool validate() const;
 
-	uint32_t find_index(uint32_t key) const;
-	void swap(uint32_t old_node, uint32_t new_node);
-	void rotate_left(uint32_t index);
-	void rotate_right(uint32_t index);
+	index_t find_index(key_t key) const;
+	void swap(index_t old_node, index_t new_node);
+	void rotate_left(index_t index);
+	void rotate_right(index_t index);
 
-	void balance(uint32_t index);
-	void rebalance(uint32_t index);
+	void balance(index_t index);
+	void rebalance(index_t index);
 	void print(uint32_t height = 0) const;
 };
 
-struct binaryheap_t
+template<typename value_t = uint32_t, typename capacity_t = fixed_capacity_t<1024>, bool max_heap = true, typename index_t = containerindex_t<capacity_t>>
+struct basic_binaryheap_t : containerstorage_t<value_t, index_t, capacity_t>
 {
-	static const uint32_t invalid = 0xffffffffu;
+	using storage_t = containerstorage_t<value_t, index_t, capacity_t>;
+	using storage_t::arr;
+	using storage_t::capacity;
+	static constexpr index_t invalid = (index_t)~(index_t)0;
+	static constexpr value_t none = containers_none<value_t>();
 
-	// to simplify memory management let's say
-	// binary heap can only contain up to N elements
-	static const uint32_t count_max = 1024;
-	uint32_t arr[count_max] = {0};
-	uint32_t count = 0;
+	index_t count = 0;
 
 	// public
-	void insert(uint32_t value)
+	bool insert(value_t value)
 	{
-		if(count >= count_max)
-			return;
+		if(count >= capacity && !grow(count + 1))
+			return false;
 		++count;
-		uint32_t index = count - 1;
-		while(index && value > arr[parent(index)])
+		index_t index = count - 1;
+		uint32_t levels = 0;
+		while(index && before(value, arr[parent(index)]))
 		{
 			arr[index] = arr[parent(index)];
 			index = parent(index);
+			++levels;
 		}
 		arr[index] = value;
+		stats_add(stats_binaryheap_sifts);
+		stats_add(stats_binaryheap_sift_levels, levels);
+		return true;
 	}
-	void build(uint32_t * values, uint32_t size)
+	void build(const value_t * values, index_t size)
 	{
-		if(size >= count_max)
+		if(size >= capacity && !grow(size + 1))
 			return;
 		count = size;
-		for(uint32_t i = 0; i < count; ++i)
+		for(index_t i = 0; i < count; ++i)
 			arr[i] = values[i];
 		if(count)
-			for(uint32_t i = parent(count) + 1; i > 0; --i)
+			for(index_t i = parent(count) + 1; i > 0; --i)
 				heapify(i - 1);
 	}
-	uint32_t remove()
+	value_t remove()
 	{
 		if(!count)
-			return invalid;
-		uint32_t result = arr[0];
+			return none;
+		value_t result = arr[0];
 		arr[0] = arr[--count];
 		heapify(0);
 		return result;
 	}
+	// remove then insert with a single sift, none and a plain insert when empty
+	value_t replace(value_t value)
+	{
+		if(!count)
+		{
+			insert(value);
+			return none;
+		}
+		value_t result = arr[0];
+		arr[0] = value;
+		heapify(0);
+		return result;
+	}
+	void clear() {count = 0;}
 
 	// private
-	uint32_t parent(uint32_t index) const {return index ? (index - 1) / 2 : invalid;}
-	uint32_t left(uint32_t index) const {return 2 * index + 1;}
-	uint32_t right(uint32_t index) const {return 2 * index + 2;}
-	void heapify(uint32_t root_index)
-	{
-		auto largest = [this](uint32_t test)
-		{
-			uint32_t new_index = test;
-			if(left(test) < count && arr[left(test)] > arr[new_index])
-				new_index = left(test);
-			if(right(test) < count && arr[right(test)] > arr[new_index])
-				new_index = right(test);
-			return new_index;
-		};
-		uint32_t index = root_index, largest_index = root_index;
-		while(index != (largest_index = largest(index)))
+	static bool before(value_t a, value_t b)
+	{
+		if constexpr (max_heap)
+			return a > b;
+		else
+			return a < b;
+	}
+	bool grow(uint64_t size)
+	{
+		if constexpr (capacity_t::growable)
+			return this->reserve(size);
+		else
+			return false;
+	}
+	index_t parent(index_t index) const {return index ? (index - 1) / 2 : invalid;}
+	index_t left(index_t index) const {return 2 * index + 1;}
+	index_t right(index_t index) const {return 2 * index + 2;}
+	void heapify(index_t root_index)
+	{
+		// sift the root value down through a hole instead of swapping at every level
+		index_t index = root_index;
+		value_t value = arr[index];
+		uint32_t levels = 0;
+		while(left(index) < count)
 		{
-			auto t = arr[index];
-			arr[index] = arr[largest_index];
-			arr[largest_index] = t;
-			index = largest_index;
+			index_t first = left(index);
+			if(right(index) < count && before(arr[right(index)], arr[first]))
+				first = right(index);
+			if(!before(arr[first], value))
+				break;
+			arr[index] = arr[first];
+			index = first;
+			++levels;
 		}
+		arr[index] = value;
+		stats_add(stats_binaryheap_sifts);
+		stats_add(stats_binaryheap_sift_levels, levels);
 	}
 
 	void print() const;
 };
+
+// linked list
+
+template<typename value_t, typename capacity_t, typename index_t>
+void basic_linkedlist_t<value_t, capacity_t, index_t>::link_free(index_t first, index_t last)
+{
+	// [first, last) becomes the circular free list
+	if(first == last)
+		return;
+	for(index_t i = first; i < last; ++i)
+	{
+		arr[i].prev = i == first ? last - 1 : i - 1;
+		arr[i].next = i == last - 1 ? first : i + 1;
+	}
+	next_free = first;
+}
+
+template<typename value_t, typename capacity_t, typename index_t>
+bool basic_linkedlist_t<value_t, capacity_t, index_t>::grow()
+{
+	if constexpr (capacity_t::growable)
+	{
+		index_t first = capacity;
+		if(!this->reserve((uint64_t)capacity + 1))
+			return false;
+		link_free(first, capacity);
+		return true;
+	}
+	else
+		return false;
+}
+
+template<typename value_t, typename capacity_t, typename index_t>
+index_t basic_linkedlist_t<value_t, capacity_t, index_t>::allocate()
+{
+	if(next_free == invalid && !grow())
+		return invalid;
+	index_t result = next_free;
+	next_free = arr[result].next == result ? invalid : arr[result].next;
+	arr[arr[result].prev].next = arr[result].next;
+	arr[arr[result].next].prev = arr[result].prev;
+	return result;
+}
+
+template<typename value_t, typename capacity_t, typename index_t>
+void basic_linkedlist_t<value_t, capacity_t, index_t>::deallocate(index_t index)
+{
+	arr[index].free();
+
+	if(next_free != invalid)
+	{
+		arr[index].prev = next_free;
+		arr[index].next = arr[next_free].next;
+		arr[arr[next_free].next].prev = index;
+		arr[next_free].next = index;
+	}
+	else
+	{
+		arr[index].next = index;
+		arr[index].prev = index;
+		next_free = index;
+	}
+}
+
+template<typename value_t, typename capacity_t, typename index_t>
+index_t basic_linkedlist_t<value_t, capacity_t, index_t>::insert_after(value_t value, index_t index)
+{
+	index = index == invalid ? last_index : index;
+	index_t new_index = allocate();
+	if(new_index == invalid)
+		return invalid;
+
+	if(index != invalid)
+	{
+		arr[new_index].prev = index;
+		arr[new_index].next = arr[index].next;
+		arr[arr[index].next].prev = new_index;
+		arr[index].next = new_index;
+	}
+	else
+	{
+		arr[new_index].prev = new_index;
+		arr[new_index].next = new_index;
+	}
+
+	arr[new_index].value = value;
+	last_index = new_index;
+	return new_index;
+}
+
+template<typename value_t, typename capacity_t, typename index_t>
+index_t basic_linkedlist_t<value_t, capacity_t, index_t>::insert_before(value_t value, index_t index)
+{
+	index = index == invalid ? last_index : index;
+	index_t new_index = allocate();
+	if(new_index == invalid)
+		return invalid;
+
+	if(index != invalid)
+	{
+		arr[new_index].next = index;
+		arr[new_index].prev = arr[index].prev;
+		arr[arr[index].prev].next = new_index;
+		arr[index].prev = new_index;
+	}
+	else
+	{
+		arr[new_index].prev = new_index;
+		arr[new_index].next = new_index;
+	}
+
+	arr[new_index].value = value;
+	last_index = new_index;
+	return new_index;
+}
+
+template<typename value_t, typename capacity_t, typename index_t>
+void basic_linkedlist_t<value_t, capacity_t, index_t>::move_after(index_t index, index_t target)
+{
+	target = target == invalid ? last_index : target;
+	if(index == invalid || index == target)
+		return;
+	bool to_last = target == last_index;
+	// a node never is its own neighbour here, the list has at least index and target
+	if(index == last_index)
+		last_index = arr[index].prev;
+	arr[arr[index].prev].next = arr[index].next;
+	arr[arr[index].next].prev = arr[index].prev;
+	arr[index].prev = target;
+	arr[index].next = arr[target].next;
+	arr[arr[target].next].prev = index;
+	arr[target].next = index;
+	if(to_last)
+		last_index = index;
+}
+
+template<typename value_t, typename capacity_t, typename index_t>
+void basic_linkedlist_t<value_t, capacity_t, index_t>::remove(index_t index)
+{
+	if(index != invalid)
+	{
+		if(last_index == index)
+			last_index = arr[index].prev != index ? arr[index].prev : invalid;
+		arr[arr[index].prev].next = arr[index].next;
+		arr[arr[index].next].prev = arr[index].prev;
+		deallocate(index);
+	}
+}
+
+template<typename value_t, typename capacity_t, typename index_t>
+void basic_linkedlist_t<value_t, capacity_t, index_t>::print() const
+{
+	for(index_t i = 0; i < capacity; ++i)
+		printf("%u : (%llu %u %u)\n", (uint32_t)i, (unsigned long long)arr[i].value, (uint32_t)arr[i].prev, (uint32_t)arr[i].next);
+	printf("next free %u\n", (uint32_t)next_free);
+}
+
+// hashtable
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+void basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::set_filter(bloomfilter_t * new_filter)
+{
+	filter = new_filter;
+	if(filter)
+		for(index_t i = 0; i < capacity; ++i)
+			if(taken(i))
+				filter->add(containers_fold(arr[i].key));
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+index_t basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::index(key_t key, bool next_free) const
+{
+	if(!capacity)
+		return invalid;
+	if(!next_free && filter && !filter->may_contain(containers_fold(key)))
+	{
+		stats_add(stats_hashtable_filtered);
+		return invalid;
+	}
+
+	return index_from(key, home(key), next_free);
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+index_t basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::index_from(key_t key, index_t start, bool next_free) const
+{
+	// linear probing, remove shifts entries back so the first free slot ends a probe
+	index_t i = 0, j = start;
+	for(; i < capacity; ++i, j = following(j)) // wrapping once
+		if(!taken(j) || (!next_free && arr[j].key == key))
+			break;
+	stats_add(stats_hashtable_lookups);
+	stats_add(stats_hashtable_probes, i < capacity ? i + 1 : i);
+	if(i == capacity)
+		return invalid;
+	return taken(j) || next_free ? j : invalid;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+bool basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::place(key_t key, value_t value)
+{
+	index_t i = index(key, true);
+	if(i == invalid)
+		return false;
+	arr[i].key = key;
+	arr[i].value = value;
+	if constexpr (flagged)
+		arr[i].used = true;
+	++size;
+	return true;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+bool basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::rehash(uint64_t slots)
+{
+	if constexpr (capacity_t::growable)
+	{
+		storage_t old;
+		if(!old.reserve(slots))
+			return false;
+		this->swap(old); // old now holds the entries, this an empty larger table
+		size = 0;
+		for(index_t i = 0; i < old.capacity; ++i)
+			if(taken(old.arr[i]))
+				place(old.arr[i].key, old.arr[i].value);
+		return true;
+	}
+	else
+		return false;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+bool basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::build(const key_t * keys, const value_t * values, size_t count, uint32_t threads)
+{
+	if constexpr (capacity_t::growable)
+	{
+		uint64_t needed = ((uint64_t)size + count) * 4 / 3 + 1;
+		if(needed > capacity && !rehash(needed))
+			return false;
+	}
+	if(!count)
+		return true;
+	if(count < 4096 || !capacity)
+	{
+		// not worth partitioning
+		bool ok = true;
+		for(size_t i = 0; i < count; ++i)
+			ok = set(keys[i], values[i]) && ok;
+		return ok;
+	}
+	threads = containers_threads(threads);
+
+	// slot ranges of about l2 size, several per thread to even out the load
+	uint32_t partitions = 1;
+	while(partitions < (1u << 16) && (uint64_t)capacity * sizeof(entry_t) / partitions > (256u << 10))
+		partitions *= 2;
+	while(partitions < threads * 4 && partitions * 2u <= capacity)
+		partitions *= 2;
+	auto part = [this, partitions](index_t h) {return (uint32_t)((uint64_t)h * partitions / capacity);};
+	auto first_slot = [this, partitions](uint32_t p) {return (index_t)(((uint64_t)p * capacity + partitions - 1) / partitions);};
+
+	struct item_t
+	{
+		key_t key;
+		value_t value;
+		index_t home;
+	};
+	item_t * items = (item_t*)malloc(count * sizeof(item_t));
+	size_t * offsets = (size_t*)calloc((size_t)threads * partitions, sizeof(size_t));
+	auto chunk = [count, threads](uint32_t t) {return (size_t)((uint64_t)count * t / threads);};
+
+	// histogram of each thread's chunk, then exclusive prefix sums in partition
+	// major order, so every partition is contiguous and threads scatter apart
+	containers_parallel(threads, [&](uint32_t t)
+	{
+		size_t * counts = offsets + (size_t)t * partitions;
+		for(size_t i = chunk(t); i < chunk(t + 1); ++i)
+			++counts[part(home(keys[i]))];
+	});
+	size_t sum = 0;
+	for(uint32_t p = 0; p < partitions; ++p)
+		for(uint32_t t = 0; t < threads; ++t)
+		{
+			size_t c = offsets[(size_t)t * partitions + p];
+			offsets[(size_t)t * partitions + p] = sum;
+			sum += c;
+		}
+	containers_parallel(threads, [&](uint32_t t)
+	{
+		size_t * next = offsets + (size_t)t * partitions;
+		for(size_t i = chunk(t); i < chunk(t + 1); ++i)
+		{
+			index_t h = home(keys[i]);
+			items[next[part(h)]++] = item_t{keys[i], values[i], h};
+		}
+	});
+	// the last thread's cursors now sit at the end of every partition
+	const size_t * ends = offsets + (size_t)(threads - 1) * partitions;
+
+	// each partition is filled by one thread, a probe that would run past its
+	// slice is kept aside and placed afterwards with the ordinary probe
+	size_t * deferred_counts = (size_t*)calloc(threads, sizeof(size_t));
+	size_t * placed = (size_t*)calloc(threads, sizeof(size_t));
+	item_t ** deferred = (item_t**)calloc(threads, sizeof(item_t*));
+	uint32_t next_partition = 0;
+	bool rejected = false;
+	containers_parallel(threads, [&](uint32_t t)
+	{
+		size_t deferred_capacity = 0;
+		for(;;)
+		{
+			uint32_t p = __atomic_fetch_add(&next_partition, 1, __ATOMIC_RELAXED);
+			if(p >= partitions)
+				break;
+			index_t end_slot = p + 1 < partitions ? first_slot(p + 1) : capacity;
+			for(size_t k = p ? ends[p - 1] : 0; k < ends[p]; ++k)
+			{
+				const item_t & item = items[k];
+				if constexpr (!flagged)
+				{
+					if(item.key == entry_t::sentinel)
+					{
+						__atomic_store_n(&rejected, true, __ATOMIC_RELAXED);
+						continue;
+					}
+				}
+				index_t j = item.home;
+				while(j < end_slot && taken(j))
+					++j;
+				if(j == end_slot)
+				{
+					if(deferred_counts[t] == deferred_capacity)
+					{
+						deferred_capacity = deferred_capacity ? deferred_capacity * 2 : 64;
+						deferred[t] = (item_t*)realloc((void*)deferred[t], deferred_capacity * sizeof(item_t));
+					}
+					deferred[t][deferred_counts[t]++] = item;
+					continue;
+				}
+				arr[j].key = item.key;
+				arr[j].value = item.value;
+				if constexpr (flagged)
+					arr[j].used = true;
+				++placed[t];
+			}
+		}
+	});
+
+	bool ok = !rejected;
+	for(uint32_t t = 0; t < threads; ++t)
+	{
+		size += placed[t];
+		for(size_t i = 0; i < deferred_counts[t]; ++i)
+			ok = place(deferred[t][i].key, deferred[t][i].value) && ok;
+		free(deferred[t]);
+	}
+	if(filter)
+		for(size_t i = 0; i < count; ++i)
+			filter->add(containers_fold(keys[i]));
+	free(deferred);
+	free(deferred_counts);
+	free(placed);
+	free(offsets);
+	free(items);
+	return ok;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+size_t basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::probe_range(const key_t * keys, size_t first, size_t last, value_t * values) const
+{
+	// ring of homes hashed ahead, the slot is on its way while earlier keys probe
+	const size_t ahead = 8;
+	index_t homes[ahead];
+	for(size_t i = first; i < last && i < first + ahead; ++i)
+	{
+		homes[i % ahead] = home(keys[i]);
+		__builtin_prefetch(&arr[homes[i % ahead]]);
+	}
+	size_t hits = 0;
+	for(size_t i = first; i < last; ++i)
+	{
+		index_t start = homes[i % ahead];
+		if(i + ahead < last)
+		{
+			homes[i % ahead] = home(keys[i + ahead]);
+			__builtin_prefetch(&arr[homes[i % ahead]]);
+		}
+		index_t j = filter && !filter->may_contain(containers_fold(keys[i])) ? invalid : index_from(keys[i], start, false);
+		values[i] = j != invalid ? arr[j].value : none;
+		hits += j != invalid;
+	}
+	return hits;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+size_t basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::probe(const key_t * keys, size_t count, value_t * values, uint32_t threads) const
+{
+	if(!capacity)
+	{
+		for(size_t i = 0; i < count; ++i)
+			values[i] = none;
+		return 0;
+	}
+	threads = count < 4096 ? 1 : containers_threads(threads);
+	size_t * hits = (size_t*)calloc(threads, sizeof(size_t));
+	containers_parallel(threads, [&](uint32_t t)
+	{
+		hits[t] = probe_range(keys, (size_t)((uint64_t)count * t / threads), (size_t)((uint64_t)count * (t + 1) / threads), values);
+	});
+	size_t total = 0;
+	for(uint32_t t = 0; t < threads; ++t)
+		total += hits[t];
+	free(hits);
+	return total;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+bool basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::set(key_t key, value_t value)
+{
+	statsscope_t scope(stats_timer_hashtable_set);
+	if constexpr (!flagged)
+	{
+		if(key == entry_t::sentinel)
+			return false;
+	}
+	if constexpr (capacity_t::growable)
+	{
+		// keep probes short, a failed grow still fills what is left
+		if(((uint64_t)size + 1) * 4 > (uint64_t)capacity * 3)
+			grow();
+	}
+	if(!place(key, value))
+		return false;
+	if(filter)
+		filter->add(containers_fold(key));
+	return true;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+value_t basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::get(key_t key) const
+{
+	index_t i = index(key);
+	return (i != invalid) ? arr[i].value : none;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+const value_t * basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::find(key_t key) const
+{
+	index_t i = index(key);
+	return (i != invalid) ? &arr[i].value : nullptr;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+value_t * basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::upsert(key_t key, value_t value, bool & inserted)
+{
+	inserted = false;
+	if constexpr (!flagged)
+	{
+		if(key == entry_t::sentinel)
+			return nullptr;
+	}
+	if constexpr (capacity_t::growable)
+	{
+		if(((uint64_t)size + 1) * 4 > (uint64_t)capacity * 3)
+			grow();
+	}
+	if(!capacity)
+		return nullptr;
+	// the first free slot ends the probe, so a miss lands where set would place
+	index_t i = 0, j = home(key);
+	for(; i < capacity && taken(j); ++i, j = following(j))
+		if(arr[j].key == key)
+			break;
+	stats_add(stats_hashtable_lookups);
+	stats_add(stats_hashtable_probes, i < capacity ? i + 1 : i);
+	if(i == capacity)
+		return nullptr;
+	if(!taken(j))
+	{
+		arr[j].key = key;
+		arr[j].value = value;
+		if constexpr (flagged)
+			arr[j].used = true;
+		++size;
+		if(filter)
+			filter->add(containers_fold(key));
+		inserted = true;
+	}
+	return &arr[j].value;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+void basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::clear()
+{
+	// the filter can not drop keys, it stays as is and only costs false positives
+	for(index_t i = 0; i < capacity; ++i)
+		release(i);
+	size = 0;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+void basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::remove(key_t key)
+{
+	index_t i = index(key);
+	if(i == invalid)
+		return;
+	release(i);
+	--size;
+
+	// backward shift instead of tombstones: pull later entries of the run into
+	// the hole unless that would move them in front of their home slot
+	for(index_t j = following(i); taken(j); j = following(j))
+	{
+		index_t h = home(arr[j].key);
+		bool stays = i <= j ? (i < h && h <= j) : (i < h || h <= j);
+		if(!stays)
+		{
+			arr[i] = arr[j];
+			release(j);
+			i = j;
+		}
+	}
+}
+
+template<typename key_t, typename value_t, typename capacity_t, typename slots_t, typename index_t>
+void basic_hashtable_t<key_t, value_t, capacity_t, slots_t, index_t>::print() const
+{
+	for(index_t i = 0; i < capacity; ++i)
+	{
+		if(taken(i))
+			printf("%03u -> (%llu %llu)\n", (uint32_t)i, (unsigned long long)arr[i].key, (unsigned long long)arr[i].value);
+		else
+			printf("%03u -> free\n", (uint32_t)i);
+	}
+	printf("load factor : %.3f\n", capacity ? (float)size / (float)capacity : 0.0f);
+}
+
+// red black tree
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+value_t basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::get(key_t key) const
+{
+	index_t index = find_index(key);
+	return index != invalid ? arr[index].value : none;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+const value_t * basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::find(key_t key) const
+{
+	index_t index = find_index(key);
+	return index != invalid ? &arr[index].value : nullptr;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+bool basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::set(key_t key, value_t value, bool force_insert)
+{
+	statsscope_t scope(stats_timer_rbtree_set);
+	if(root == invalid)
+	{
+		if((root = allocate()) == invalid)
+			return false;
+		arr[root].key = key;
+		arr[root].value = value;
+		balance(root);
+		return true;
+	}
+
+	index_t index = root, last_index = invalid;
+	bool left_key = false;
+
+	while(index != invalid && (force_insert || arr[index].key != key))
+	{
+		last_index = index;
+		left_key = key < arr[index].key;
+		index = left_key ? left(index) : right(index);
+	}
+
+	if(!force_insert && index != invalid)
+	{
+		arr[index].value = value;
+		return true;
+	}
+
+	index_t new_node = allocate();
+	if(new_node == invalid)
+		return false;
+	arr[new_node].key = key;
+	arr[new_node].value = value;
+	arr[new_node].parent = last_index;
+	if(left_key)
+		arr[last_index].left = new_node;
+	else
+		arr[last_index].right = new_node;
+	if constexpr (counted)
+	{
+		for(index_t index = last_index; index != invalid; index = parent(index))
+			++arr[index].size;
+	}
+
+	balance(new_node);
+	if constexpr (validated)
+		assert(validate());
+	return true;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+void basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::remove(key_t key)
+{
+	statsscope_t scope(stats_timer_rbtree_remove);
+	index_t index = find_index(key);
+	if(index == invalid)
+		return;
+
+	if(left(index) != invalid && right(index) != invalid)
+	{
+		index_t most_right = left(index);
+		while(right(most_right) != invalid)
+			most_right = right(most_right);
+		arr[index].key = arr[most_right].key;
+		arr[index].value = arr[most_right].value;
+		index = most_right;
+	}
+
+	assert(left(index) == invalid || right(index) == invalid);
+	index_t child = left(index) == invalid ? right(index) : left(index);
+	if constexpr (counted)
+	{
+		// the node stays in place for rebalance but already weighs nothing,
+		// rotations there recount from children and never touch it
+		arr[index].size = subtree_size(child);
+		for(index_t above = parent(index); above != invalid; above = parent(above))
+			--arr[above].size;
+	}
+	if(color(index) == false)
+	{
+		arr[index].color = color(child);
+		rebalance(index);
+	}
+
+	swap(index, child);
+	if(parent(child) == invalid)
+		set_color(child, false);
+
+	if(parent(index) != invalid)
+	{
+		if(right(parent(index)) == index)
+			arr[parent(index)].right = invalid;
+		else
+			arr[parent(index)].left = invalid;
+	}
+	else
+		root = invalid;
+
+	deallocate(index);
+	if constexpr (validated)
+		assert(validate());
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+index_t basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::lower_bound(key_t key) const
+{
+	index_t index = root, result = invalid;
+	while(index != invalid)
+		if(arr[index].key < key)
+			index = right(index);
+		else
+		{
+			result = index;
+			index = left(index);
+		}
+	return result;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+index_t basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::successor(index_t index) const
+{
+	if(index == invalid)
+		return invalid;
+	if(right(index) != invalid)
+	{
+		index = right(index);
+		while(left(index) != invalid)
+			index = left(index);
+		return index;
+	}
+	while(parent(index) != invalid && right(parent(index)) == index)
+		index = parent(index);
+	return parent(index);
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+uint32_t basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::range(key_t lo, key_t hi, key_t * keys, value_t * values, uint32_t max) const
+{
+	uint32_t written = 0;
+	for(index_t index = lower_bound(lo); index != invalid && written < max && !(hi < arr[index].key); index = successor(index))
+	{
+		keys[written] = arr[index].key;
+		values[written++] = arr[index].value;
+	}
+	return written;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+template<bool c, typename>
+index_t basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::rank(key_t key, bool inclusive) const
+{
+	index_t result = 0, index = root;
+	while(index != invalid)
+		if(arr[index].key < key || (inclusive && !(key < arr[index].key)))
+		{
+			result += subtree_size(left(index)) + 1;
+			index = right(index);
+		}
+		else
+			index = left(index);
+	return result;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+template<bool c, typename>
+index_t basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::select(index_t k) const
+{
+	index_t index = root;
+	while(index != invalid)
+	{
+		index_t smaller = subtree_size(left(index));
+		if(k == smaller)
+			return index;
+		if(k < smaller)
+			index = left(index);
+		else
+		{
+			k -= smaller + 1;
+			index = right(index);
+		}
+	}
+	return invalid;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+template<bool c, typename>
+index_t basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::count_range(key_t lo, key_t hi) const
+{
+	if(hi < lo)
+		return 0;
+	return rank(hi, true) - rank(lo);
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+template<bool c, typename>
+index_t basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::percentile(double p) const
+{
+	index_t n = count();
+	if(!n)
+		return invalid;
+	// smallest key with at least p percent of all keys at or below it
+	double rank = p / 100.0 * n;
+	index_t k = rank > 0.0 ? (index_t)rank : 0;
+	k += k < rank; // rounded up
+	return select(k ? (k < n ? k - 1 : n - 1) : 0);
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+index_t basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::allocate()
+{
+	index_t result = free_list;
+	if(result != invalid)
+		free_list = arr[result].right;
+	else if(top < capacity)
+		result = top++;
+	else if constexpr (capacity_t::growable)
+	{
+		if(!this->reserve((uint64_t)capacity + 1))
+			return invalid;
+		result = top++;
+	}
+	else
+		return invalid;
+	arr[result].free();
+	arr[result].color = 0;
+	if constexpr (counted)
+		arr[result].size = 1;
+	return result;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+void basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::deallocate(index_t index)
+{
+	arr[index].free();
+	arr[index].right = free_list;
+	free_list = index;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+void basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::set_color(index_t index, bool color)
+{
+	if(index != invalid)
+		arr[index].color = color;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+bool basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::validate() const
+{
+	// root must be black
+	if(root == invalid || color(root))
+		return root == invalid;
+
+	// adjacent nodes should have different color
+	static bool (*check_color)(const basic_rbtree_t*, index_t) =
+	[](const basic_rbtree_t * tree, index_t index) -> bool
+	{
+		if(index == invalid)
+			return true;
+		if(tree->color(index) && (
+		   tree->color(tree->left(index)) ||
+		   tree->color(tree->right(index)) ||
+		   tree->color(tree->parent(index))))
+			return false;
+		return check_color(tree, tree->left(index)) &&
+			   check_color(tree, tree->right(index));
+	};
+	if(!check_color(this, root))
+		return false;
+
+	// verify if tree is balanced
+	uint32_t target = 1;
+	index_t left_index = root;
+	while(left_index != invalid)
+		if(!color(left_index = left(left_index))) // leaf is when left == invalid
+			++target;
+	static bool (*check_length)(const basic_rbtree_t*, index_t, uint32_t, uint32_t) =
+	[](const basic_rbtree_t * tree, index_t index, uint32_t current, uint32_t target) -> bool
+	{
+		if(index == invalid)
+			return current + 1 == target;
+		if(!tree->color(index))
+			++current;
+		return check_length(tree, tree->left(index), current, target) &&
+			   check_length(tree, tree->right(index), current, target);
+	};
+	if(!check_length(this, root, 0, target))
+		return false;
+
+	// every subtree size adds up
+	if constexpr (counted)
+	{
+		static bool (*check_size)(const basic_rbtree_t*, index_t) =
+		[](const basic_rbtree_t * tree, index_t index) -> bool
+		{
+			if(index == invalid)
+				return true;
+			return tree->subtree_size(index) == 1 + tree->subtree_size(tree->left(index)) + tree->subtree_size(tree->right(index)) &&
+				   check_size(tree, tree->left(index)) && check_size(tree, tree->right(index));
+		};
+		return check_size(this, root);
+	}
+	return true;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+index_t basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::find_index(key_t key) const
+{
+	index_t index = root;
+	while(index != invalid && arr[index].key != key)
+		index = key < arr[index].key ? left(index) : right(index);
+	return index;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+void basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::swap(index_t old_node, index_t new_node)
+{
+	if(old_node == invalid || new_node == invalid)
+		return;
+	else if(root == old_node)
+		root = new_node;
+	else
+	{
+		assert(parent(old_node) != invalid);
+		if(left(parent(old_node)) == old_node)
+			arr[parent(old_node)].left = new_node;
+		else
+			arr[parent(old_node)].right = new_node;
+	}
+	arr[new_node].parent = parent(old_node);
+	arr[old_node].parent = new_node;
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+void basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::rotate_left(index_t index)
+{
+	if(index == invalid)
+		return;
+
+	//  B   ->  A
+	// D A     B C
+	//    C   D
+
+	index_t index_b = index;
+	index_t index_a = right(index);
+	if(index_a == invalid)
+		return;
+	swap(index_b, index_a);
+	arr[index_b].right = left(index_a);
+	if(arr[index_b].right != invalid)
+		arr[arr[index_b].right].parent = index_b;
+	arr[index_a].left = index_b;
+	if constexpr (counted)
+	{
+		arr[index_a].size = arr[index_b].size;
+		update_size(index_b);
+	}
+	stats_add(stats_rbtree_rotations);
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+void basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::rotate_right(index_t index)
+{
+	if(index == invalid)
+		return;
+
+	//  A   ->  B
+	// B C     D A
+	//D           C
+
+	index_t index_a = index;
+	index_t index_b = left(index);
+	if(index_b == invalid)
+		return;
+	swap(index_a, index_b);
+	arr[index_a].left = right(index_b);
+	if(arr[index_a].left != invalid)
+		arr[arr[index_a].left].parent = index_a;
+	arr[index_b].right = index_a;
+	if constexpr (counted)
+	{
+		arr[index_b].size = arr[index_a].size;
+		update_size(index_a);
+	}
+	stats_add(stats_rbtree_rotations);
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+void basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::balance(index_t index)
+{
+	if(index == invalid)
+		return;
+
+	if(parent(index) == invalid)
+	{
+		set_color(index, false);
+		return;
+	}
+	else
+		set_color(index, true);
+
+	if(color(parent(index)) == false)
+		return;
+
+	assert(grandparent(index) != invalid);
+
+	if(color(uncle(index)) == true)
+	{
+		set_color(parent(index), false);
+		set_color(uncle(index), false);
+		set_color(grandparent(index), false);
+		balance(grandparent(index));
+		return;
+	}
+
+	if(right(parent(index)) == index && parent(index) == left(grandparent(index)))
+	{
+		rotate_left(parent(index));
+		index = left(index);
+	}
+	else if(left(parent(index)) == index && parent(index) == right(grandparent(index)))
+	{
+		rotate_right(parent(index));
+		index = right(index);
+	}
+
+	set_color(parent(index), false);
+	set_color(grandparent(index), true);
+
+	if(left(parent(index)) == index && parent(index) == left(grandparent(index)))
+	{
+		rotate_right(grandparent(index));
+	}
+	else
+	{
+		assert(right(parent(index)) == index && parent(index) == right(grandparent(index)));
+		rotate_left(grandparent(index));
+	}
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+void basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::rebalance(index_t index)
+{
+	if(parent(index) == invalid)
+		return;
+
+	if(color(sibling(index)) == true)
+	{
+		set_color(parent(index), true);
+		set_color(sibling(index), false);
+		if(arr[parent(index)].left == index)
+			rotate_left(parent(index));
+		else
+			rotate_right(parent(index));
+	}
+
+	if(color(parent(index)) == false &&
+	   color(sibling(index)) == false &&
+	   color(left(sibling(index))) == false &&
+	   color(right(sibling(index))) == false)
+	{
+		set_color(sibling(index), true);
+		rebalance(parent(index));
+		return;
+	}
+
+	if(color(parent(index)) == true &&
+	   color(sibling(index)) == false &&
+	   color(left(sibling(index))) == false &&
+	   color(right(sibling(index))) == false)
+	{
+		set_color(sibling(index), true);
+		set_color(parent(index), false);
+		return;
+	}
+
+	if(left(parent(index)) == index &&
+	   color(sibling(index)) == false &&
+	   color(left(sibling(index))) == true &&
+	   color(right(sibling(index))) == false)
+	{
+		set_color(sibling(index), true);
+		set_color(left(sibling(index)), false);
+		rotate_right(sibling(index));
+	}
+	else if(right(parent(index)) == index &&
+			color(sibling(index)) == false &&
+			color(left(sibling(index))) == false &&
+			color(right(sibling(index))) == true)
+	{
+		set_color(sibling(index), true);
+		set_color(right(sibling(index)), false);
+		rotate_left(sibling(index));
+	}
+
+	set_color(sibling(index), color(parent(index)));
+	set_color(parent(index), false);
+
+	if(left(parent(index)) == index)
+	{
+		assert(color(right(sibling(index))) == true);
+		set_color(right(sibling(index)), false);
+		rotate_left(parent(index));
+	}
+	else
+	{
+		assert(color(left(sibling(index))) == true);
+		set_color(left(sibling(index)), false);
+		rotate_right(parent(index));
+	}
+}
+
+template<typename key_t, typename value_t, typename capacity_t, bool counted, typename index_t>
+void basic_rbtree_t<key_t, value_t, capacity_t, counted, index_t>::print(uint32_t height) const
+{
+	if(!height)
+	{
+		for(index_t i = 0; i < capacity; ++i)
+			printf("%02u %s %02i:%02i %02i (%llu:%llu)\n", (uint32_t)i,
+				   root == i ? "X" : !arr[i].taken() ? "-" : arr[i].color ? "r": "b",
+				   (int)arr[i].left, (int)arr[i].right,
+				   (int)arr[i].parent,
+				   (unsigned long long)arr[i].key, (unsigned long long)arr[i].value);
+	}
+
+	static void (*pprint)(const basic_rbtree_t*, index_t, uint32_t, uint32_t, uint32_t, index_t, bool) =
+	[](const basic_rbtree_t * tree, index_t index, uint32_t deep, uint32_t target, uint32_t total, index_t parent, bool space)
+	{
+		if(deep == target)
+		{
+			if(index != invalid)
+			{
+				if(tree->parent(index) != parent)
+					printf("*");
+				else
+					printf("%llu", (unsigned long long)tree->arr[index].key);
+					//printf("%u", tree->arr[index].color ? 1 : 0);
+			}
+			else
+				printf("x");
+			if(space)
+				printf("%*s", (1 << (total - target + 1)) - 1, "");
+		}
+		else
+		{
+			pprint(tree, index != invalid ? tree->left(index) : invalid, deep + 1, target, total, index, true);
+			pprint(tree, index != invalid ? tree->right(index) : invalid, deep + 1, target, total, index, space);
+		}
+	};
+
+	if(height)
+		for(uint32_t i = 0; i <= height; ++i)
+		{
+			if(i < height)
+				printf("%*s", (1 << (height - i)) - 1, "");
+			pprint(this, root, 0, i, height, invalid, false);
+			printf("\n");
+		}
+
+	printf("valid tree : %s\n", validate() ? "yes" : "no");
+}
+
+// binary heap
+
+template<typename value_t, typename capacity_t, bool max_heap, typename index_t>
+void basic_binaryheap_t<value_t, capacity_t, max_heap, index_t>::print() const
+{
+	static void (*pprint)(const basic_binaryheap_t*, index_t, uint32_t, uint32_t, uint32_t, bool) =
+			[](const basic_binaryheap_t * tree, index_t index, uint32_t deep, uint32_t target, uint32_t total, bool space)
+	{
+		if(deep == target)
+		{
+			if(index < tree->count)
+				printf("%llu", (unsigned long long)tree->arr[index]);
+			else
+				printf("x");
+			if(space)
+				printf("%*s", (1 << (total - target + 1)) - 1, "");
+		}
+		else
+		{
+			pprint(tree, tree->left(index), deep + 1, target, total, true);
+			pprint(tree, tree->right(index), deep + 1, target, total, space);
+		}
+	};
+
+	uint32_t height = 0;
+	uint32_t t = count;
+	while(t >>= 1)
+		++height;
+	for(uint32_t i = 0; i <= height; ++i)
+	{
+		if(i < height)
+			printf("%*s", (1 << (height - i)) - 1, "");
+		pprint(this, 0, 0, i, height, false);
+		printf("\n");
+	}
+}
+
+// the original fixed uint32_t containers, instantiated once in containers.cpp
+using linkedlist_t = basic_linkedlist_t<>;
+using hashtable_t = basic_hashtable_t<>;
+using rbtree_t = basic_rbtree_t<>;
+using binaryheap_t = basic_binaryheap_t<>;
+
+extern template struct basic_linkedlist_t<>;
+extern template struct basic_hashtable_t<>;
+extern template struct basic_rbtree_t<>;
+extern template struct basic_binaryheap_t<>;
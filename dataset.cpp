@@ -1,4 +1,6 @@
 #include "dataset.h"
+#include "workload.h"
+#include "verify.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -12,9 +14,9 @@ dataset_t::dataset_t(std::initializer_list<uint32_t> init)
 dataset_t dataset_t::random(size_t count)
 {
 	dataset_t result;
-	result.count = count ? count : rand() % (sizeof(items) / sizeof(items[0]));
+	result.count = count ? count : workload_below(sizeof(items) / sizeof(items[0]));
 	for(size_t i = 0; i < result.count; ++i)
-		result.items[i] = rand();
+		result.items[i] = workload_next();
 	return result;
 }
 
@@ -28,11 +30,5 @@ void dataset_t::print() const
 
 bool dataset_t::validate() const
 {
-	uint32_t last = 0;
-	for(size_t i = 0; i < count; ++i)
-		if(last <= items[i])
-			last = items[i];
-		else
-			return false;
-	return true;
+	return verify_sorted(items, count, 1);
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include <initializer_list>
+#include "stats.h"
 
 // to simplify memory management, access patterns, etc
 // let's just do array of integers
@@ -14,7 +16,7 @@ struct dataset_t
 	dataset_t(std::initializer_list<uint32_t> init);
 	static dataset_t random(size_t count = 0);
 
-	inline void swap(size_t a, size_t b) {uint32_t t = items[a]; items[a] = items[b]; items[b] = t;}
+	inline void swap(size_t a, size_t b) {uint32_t t = items[a]; items[a] = items[b]; items[b] = t; stats_add(stats_sorts_swaps);}
 	void print() const;
 	bool validate() const;
 };
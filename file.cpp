@@ -0,0 +1,43 @@
+#include "file.h"
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool mappedfile_t::open(const char * path)
+{
+	close();
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0)
+		return false;
+	struct stat st;
+	if(fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void * ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if(ptr != MAP_FAILED)
+		{
+			data = ptr;
+			size = (size_t)st.st_size;
+		}
+	}
+	::close(fd); // mapping stays valid
+	return data != nullptr;
+}
+
+void mappedfile_t::close()
+{
+	if(data)
+		munmap((void*)data, size);
+	data = nullptr;
+	size = 0;
+}
+
+bool file_write(const char * path, const void * data, size_t size)
+{
+	FILE * f = fopen(path, "wb");
+	if(!f)
+		return false;
+	bool ok = fwrite(data, 1, size, f) == size;
+	return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// read only memory mapping of a whole file
+struct mappedfile_t
+{
+	const void * data = nullptr;
+	size_t size = 0;
+
+	mappedfile_t() = default;
+	mappedfile_t(const char * path) {open(path);}
+	~mappedfile_t() {close();}
+	mappedfile_t(const mappedfile_t &) = delete;
+	mappedfile_t & operator=(const mappedfile_t &) = delete;
+
+	bool open(const char * path);
+	void close();
+	bool valid() const {return data != nullptr;}
+};
+
+bool file_write(const char * path, const void * data, size_t size);
@@ -0,0 +1,497 @@
+#include "filters.h"
+#include "file.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+static inline uint64_t filters_hash(uint32_t key)
+{
+	// murmur3 finalizer, hash_fnv1 is too weak for 8 derived bits
+	uint64_t h = key;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+// odd constants, one per word of the block
+alignas(32) static const uint32_t bloom_salt[8] =
+{
+	0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+	0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+};
+
+static inline uint32_t bloom_block(uint64_t hash, uint32_t block_count)
+{
+	return (uint32_t)(((hash >> 32) * block_count) >> 32);
+}
+
+// bit of word i, the top log2(word bits) bits of the salted hash
+template<uint32_t word_bits>
+static inline uint32_t bloom_bit(uint32_t hash, uint32_t i)
+{
+	return (hash * bloom_salt[i]) >> (word_bits == 32 ? 27 : 26);
+}
+
+#if defined(__AVX2__)
+static inline __m256i bloom_shifts(uint32_t hash, int shift)
+{
+	__m256i salt = _mm256_load_si256((const __m256i*)bloom_salt);
+	return _mm256_srl_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int)hash), salt), _mm_cvtsi32_si128(shift));
+}
+
+static inline __m256i bloom_mask(uint32_t hash)
+{
+	return _mm256_sllv_epi32(_mm256_set1_epi32(1), bloom_shifts(hash, 27));
+}
+
+// the 8 bits of a 512 bit block as two registers of 4 64-bit words
+static inline void bloom_mask(uint32_t hash, __m256i & low, __m256i & high)
+{
+	__m256i bits = bloom_shifts(hash, 26);
+	__m256i one = _mm256_set1_epi64x(1);
+	low = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(bits)));
+	high = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(bits, 1)));
+}
+#endif
+
+template<uint32_t block_bits>
+basic_bloomfilter_t<block_bits>::~basic_bloomfilter_t()
+{
+	free(blocks);
+}
+
+template<uint32_t block_bits>
+void basic_bloomfilter_t<block_bits>::init(uint32_t capacity, float bits_per_key)
+{
+	free(blocks);
+	uint64_t bits = (uint64_t)((float)(capacity ? capacity : 1) * bits_per_key);
+	block_count = (uint32_t)((bits + block_bits - 1) / block_bits);
+	block_count = block_count ? block_count : 1;
+	blocks = (block_t*)aligned_alloc(sizeof(block_t), block_count * sizeof(block_t));
+	clear();
+}
+
+template<uint32_t block_bits>
+void basic_bloomfilter_t<block_bits>::clear()
+{
+	if(blocks)
+		memset(blocks, 0, block_count * sizeof(block_t));
+	count = 0;
+}
+
+template<uint32_t block_bits>
+void basic_bloomfilter_t<block_bits>::add(uint32_t key)
+{
+	assert(blocks);
+	uint64_t hash = filters_hash(key);
+	block_t & block = blocks[bloom_block(hash, block_count)];
+	#if defined(__AVX2__)
+	__m256i * words = (__m256i*)block.words;
+	if constexpr (block_bits == 256)
+		_mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), bloom_mask((uint32_t)hash)));
+	else
+	{
+		__m256i low, high;
+		bloom_mask((uint32_t)hash, low, high);
+		_mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), low));
+		_mm256_store_si256(words + 1, _mm256_or_si256(_mm256_load_si256(words + 1), high));
+	}
+	#else
+	for(uint32_t i = 0; i < 8; ++i)
+		block.words[i] |= (word_t)1 << bloom_bit<word_bits>((uint32_t)hash, i);
+	#endif
+	++count;
+}
+
+template<uint32_t block_bits>
+bool basic_bloomfilter_t<block_bits>::may_contain(uint32_t key) const
+{
+	if(!blocks)
+		return false;
+	uint64_t hash = filters_hash(key);
+	const block_t & block = blocks[bloom_block(hash, block_count)];
+	#if defined(__AVX2__)
+	const __m256i * words = (const __m256i*)block.words;
+	if constexpr (block_bits == 256)
+		return _mm256_testc_si256(_mm256_load_si256(words), bloom_mask((uint32_t)hash));
+	else
+	{
+		__m256i low, high;
+		bloom_mask((uint32_t)hash, low, high);
+		return _mm256_testc_si256(_mm256_load_si256(words), low) & _mm256_testc_si256(_mm256_load_si256(words + 1), high);
+	}
+	#else
+	for(uint32_t i = 0; i < 8; ++i)
+		if(!(block.words[i] & ((word_t)1 << bloom_bit<word_bits>((uint32_t)hash, i))))
+			return false;
+	return true;
+	#endif
+}
+
+template<uint32_t block_bits>
+void basic_bloomfilter_t<block_bits>::add(const uint32_t * keys, size_t size)
+{
+	const size_t ahead = 8;
+	for(size_t i = 0; i < size; ++i)
+	{
+		if(i + ahead < size)
+			__builtin_prefetch(&blocks[bloom_block(filters_hash(keys[i + ahead]), block_count)], 1);
+		add(keys[i]);
+	}
+}
+
+template<uint32_t block_bits>
+size_t basic_bloomfilter_t<block_bits>::may_contain(const uint32_t * keys, size_t size, bool * result) const
+{
+	const size_t ahead = 8;
+	size_t positive = 0;
+	for(size_t i = 0; i < size; ++i)
+	{
+		if(i + ahead < size)
+			__builtin_prefetch(&blocks[bloom_block(filters_hash(keys[i + ahead]), block_count)]);
+		positive += (result[i] = may_contain(keys[i]));
+	}
+	return positive;
+}
+
+template<uint32_t block_bits>
+float basic_bloomfilter_t<block_bits>::false_positive_rate() const
+{
+	// a random key hits a random block and needs one set bit in each word,
+	// so the chance is the mean over blocks of the product of word densities
+	double sum = 0.0;
+	for(uint32_t i = 0; i < block_count; ++i)
+	{
+		double p = 1.0;
+		for(uint32_t j = 0; j < 8; ++j)
+			p *= (double)__builtin_popcountll(blocks[i].words[j]) / (double)word_bits;
+		sum += p;
+	}
+	return block_count ? (float)(sum / block_count) : 0.0f;
+}
+
+template struct basic_bloomfilter_t<256>;
+template struct basic_bloomfilter_t<512>;
+
+// all non decreasing 4-tuples of nibbles, generated in lexicographic order
+// so the packed values are sorted and encoding is a binary search
+struct semisort_table_t
+{
+	static const uint32_t count = 3876;
+	uint16_t tuples[count];
+
+	semisort_table_t()
+	{
+		uint32_t n = 0;
+		for(uint32_t a = 0; a < 16; ++a)
+			for(uint32_t b = a; b < 16; ++b)
+				for(uint32_t c = b; c < 16; ++c)
+					for(uint32_t d = c; d < 16; ++d)
+						tuples[n++] = (uint16_t)(a << 12 | b << 8 | c << 4 | d);
+		assert(n == count);
+	}
+	uint32_t encode(uint16_t tuple) const
+	{
+		uint32_t left = 0, right = count - 1;
+		while(left < right)
+		{
+			uint32_t middle = (left + right) / 2;
+			if(tuples[middle] < tuple)
+				left = middle + 1;
+			else
+				right = middle;
+		}
+		assert(tuples[left] == tuple);
+		return left;
+	}
+};
+
+static const semisort_table_t & semisort_table()
+{
+	static semisort_table_t table;
+	return table;
+}
+
+static inline uint64_t read_bits(const uint64_t * words, uint64_t pos, uint32_t width)
+{
+	uint64_t w = pos >> 6, s = pos & 63;
+	uint64_t value = words[w] >> s;
+	if(s + width > 64)
+		value |= words[w + 1] << (64 - s);
+	return value & ((1ull << width) - 1);
+}
+
+static inline void write_bits(uint64_t * words, uint64_t pos, uint32_t width, uint64_t value)
+{
+	uint64_t w = pos >> 6, s = pos & 63;
+	uint64_t mask = (1ull << width) - 1;
+	words[w] = (words[w] & ~(mask << s)) | (value << s);
+	if(s + width > 64)
+	{
+		uint64_t rest = s + width - 64;
+		words[w + 1] = (words[w + 1] & ~((1ull << rest) - 1)) | (value >> (64 - s));
+	}
+}
+
+cuckoofilter_t::~cuckoofilter_t()
+{
+	release();
+}
+
+void cuckoofilter_t::release()
+{
+	if(!readonly)
+		free(data);
+	data = nullptr;
+	readonly = false;
+}
+
+void cuckoofilter_t::init(uint32_t capacity, uint32_t new_fingerprint_bits)
+{
+	assert(new_fingerprint_bits >= 8 && new_fingerprint_bits <= 16);
+	release();
+	semisort_table();
+	fingerprint_bits = new_fingerprint_bits;
+	bucket_count = 1;
+	while(bucket_count * slots < capacity)
+		bucket_count <<= 1;
+	count = 0;
+	victim = victim_t();
+	data = (uint64_t*)calloc(word_count(), sizeof(uint64_t));
+}
+
+void cuckoofilter_t::hash(uint32_t key, uint32_t & fingerprint, uint32_t & index) const
+{
+	uint64_t h = filters_hash(key);
+	fingerprint = (uint32_t)(h >> 32) & ((1u << fingerprint_bits) - 1);
+	fingerprint += fingerprint == 0; // zero marks an empty slot
+	index = (uint32_t)h & (bucket_count - 1);
+}
+
+uint32_t cuckoofilter_t::alt_index(uint32_t index, uint32_t fingerprint) const
+{
+	// partial-key cuckoo hashing, the other bucket only needs the fingerprint
+	return (index ^ (fingerprint * 0x5bd1e995u)) & (bucket_count - 1);
+}
+
+void cuckoofilter_t::read_bucket(uint32_t index, uint32_t fingerprints[slots]) const
+{
+	uint32_t low_bits = fingerprint_bits - 4;
+	uint64_t bits = read_bits(data, (uint64_t)index * bucket_bits(), bucket_bits());
+	uint32_t tuple = semisort_table().tuples[bits & 0xfff];
+	bits >>= 12;
+	for(uint32_t i = 0; i < slots; ++i)
+	{
+		uint32_t high = (tuple >> (12 - 4 * i)) & 0xf;
+		uint32_t low = (uint32_t)(bits >> (low_bits * i)) & ((1u << low_bits) - 1);
+		fingerprints[i] = high << low_bits | low;
+	}
+}
+
+void cuckoofilter_t::write_bucket(uint32_t index, uint32_t fingerprints[slots])
+{
+	assert(!readonly);
+	auto order = [fingerprints](uint32_t a, uint32_t b)
+	{
+		if(fingerprints[a] > fingerprints[b])
+		{
+			uint32_t t = fingerprints[a];
+			fingerprints[a] = fingerprints[b];
+			fingerprints[b] = t;
+		}
+	};
+	order(0, 1); order(2, 3); order(0, 2); order(1, 3); order(1, 2);
+
+	uint32_t low_bits = fingerprint_bits - 4;
+	uint32_t tuple = 0;
+	uint64_t low = 0;
+	for(uint32_t i = 0; i < slots; ++i)
+	{
+		tuple = tuple << 4 | fingerprints[i] >> low_bits;
+		low |= (uint64_t)(fingerprints[i] & ((1u << low_bits) - 1)) << (low_bits * i);
+	}
+	uint64_t bits = low << 12 | semisort_table().encode((uint16_t)tuple);
+	write_bits(data, (uint64_t)index * bucket_bits(), bucket_bits(), bits);
+}
+
+bool cuckoofilter_t::bucket_contains(uint32_t index, uint32_t fingerprint) const
+{
+	uint32_t fingerprints[slots];
+	read_bucket(index, fingerprints);
+	return fingerprints[0] == fingerprint || fingerprints[1] == fingerprint ||
+		   fingerprints[2] == fingerprint || fingerprints[3] == fingerprint;
+}
+
+bool cuckoofilter_t::bucket_insert(uint32_t index, uint32_t fingerprint)
+{
+	uint32_t fingerprints[slots];
+	read_bucket(index, fingerprints);
+	if(fingerprints[0]) // sorted, so empty slots come first
+		return false;
+	fingerprints[0] = fingerprint;
+	write_bucket(index, fingerprints);
+	return true;
+}
+
+bool cuckoofilter_t::bucket_remove(uint32_t index, uint32_t fingerprint)
+{
+	uint32_t fingerprints[slots];
+	read_bucket(index, fingerprints);
+	for(uint32_t i = 0; i < slots; ++i)
+		if(fingerprints[i] == fingerprint)
+		{
+			fingerprints[i] = 0;
+			write_bucket(index, fingerprints);
+			return true;
+		}
+	return false;
+}
+
+bool cuckoofilter_t::insert(uint32_t index, uint32_t fingerprint)
+{
+	if(bucket_insert(index, fingerprint) || bucket_insert(alt_index(index, fingerprint), fingerprint))
+		return true;
+
+	uint32_t random = fingerprint * 0x9e3779b9u ^ index;
+	for(uint32_t kick = 0; kick < max_kicks; ++kick)
+	{
+		random ^= random << 13; random ^= random >> 17; random ^= random << 5;
+		uint32_t fingerprints[slots];
+		read_bucket(index, fingerprints);
+		uint32_t slot = random % slots;
+		uint32_t evicted = fingerprints[slot];
+		fingerprints[slot] = fingerprint;
+		write_bucket(index, fingerprints);
+
+		fingerprint = evicted;
+		index = alt_index(index, fingerprint);
+		if(bucket_insert(index, fingerprint))
+			return true;
+	}
+
+	// out of kicks, park the homeless fingerprint so nothing is lost
+	victim.index = index;
+	victim.fingerprint = fingerprint;
+	victim.used = true;
+	return true;
+}
+
+bool cuckoofilter_t::add(uint32_t key)
+{
+	if(victim.used || readonly)
+		return false; // full
+	uint32_t fingerprint, index;
+	hash(key, fingerprint, index);
+	insert(index, fingerprint);
+	++count;
+	return true;
+}
+
+bool cuckoofilter_t::may_contain(uint32_t key) const
+{
+	if(!data)
+		return false;
+	uint32_t fingerprint, index;
+	hash(key, fingerprint, index);
+	uint32_t index2 = alt_index(index, fingerprint);
+	if(victim.used && victim.fingerprint == fingerprint && (victim.index == index || victim.index == index2))
+		return true;
+	return bucket_contains(index, fingerprint) || bucket_contains(index2, fingerprint);
+}
+
+size_t cuckoofilter_t::may_contain(const uint32_t * keys, size_t size, bool * result) const
+{
+	size_t positive = 0;
+	for(size_t i = 0; i < size; ++i)
+		positive += (result[i] = may_contain(keys[i]));
+	return positive;
+}
+
+bool cuckoofilter_t::remove(uint32_t key)
+{
+	if(readonly || !data)
+		return false;
+	uint32_t fingerprint, index;
+	hash(key, fingerprint, index);
+	uint32_t index2 = alt_index(index, fingerprint);
+	if(bucket_remove(index, fingerprint) || bucket_remove(index2, fingerprint))
+	{
+		--count;
+		if(victim.used)
+		{
+			// there is room now, give the parked fingerprint a home
+			victim.used = false;
+			insert(victim.index, victim.fingerprint);
+		}
+		return true;
+	}
+	if(victim.used && victim.fingerprint == fingerprint && (victim.index == index || victim.index == index2))
+	{
+		victim.used = false;
+		--count;
+		return true;
+	}
+	return false;
+}
+
+size_t cuckoofilter_t::serialized_size() const
+{
+	return sizeof(header_t) + word_count() * sizeof(uint64_t);
+}
+
+void cuckoofilter_t::serialize(void * out) const
+{
+	header_t * header = (header_t*)out;
+	header->magic = magic;
+	header->version = version;
+	header->fingerprint_bits = fingerprint_bits;
+	header->bucket_count = bucket_count;
+	header->count = count;
+	header->victim_used = victim.used;
+	header->victim_index = victim.index;
+	header->victim_fingerprint = victim.fingerprint;
+	memcpy(header + 1, data, word_count() * sizeof(uint64_t));
+}
+
+bool cuckoofilter_t::attach(const void * buffer, size_t size)
+{
+	const header_t * header = (const header_t*)buffer;
+	if(size < sizeof(header_t) || header->magic != magic || header->version != version ||
+	   header->fingerprint_bits < 8 || header->fingerprint_bits > 16 ||
+	   !header->bucket_count || (header->bucket_count & (header->bucket_count - 1)))
+		return false;
+
+	release();
+	semisort_table();
+	fingerprint_bits = header->fingerprint_bits;
+	bucket_count = header->bucket_count;
+	if(size < serialized_size())
+	{
+		bucket_count = 0;
+		return false;
+	}
+	count = header->count;
+	victim.used = header->victim_used != 0;
+	victim.index = header->victim_index;
+	victim.fingerprint = header->victim_fingerprint;
+	data = (uint64_t*)(header + 1);
+	readonly = true;
+	return true;
+}
+
+bool cuckoofilter_t::save(const char * path) const
+{
+	size_t size = serialized_size();
+	void * buffer = malloc(size);
+	serialize(buffer);
+	bool result = file_write(path, buffer, size);
+	free(buffer);
+	return result;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+
+// register blocked bloom filter
+// every key maps to one block and sets one bit in each of its 8 words
+// 256 bit blocks (half a cache line, 32-bit words): add / test is a single avx2 op
+// 512 bit blocks (a whole line, 64-bit words): two avx2 ops, a negative lookup
+// still reads one line and the wider block lowers the rate at the same bits per key
+template<uint32_t block_bits = 256>
+struct basic_bloomfilter_t
+{
+	static_assert(block_bits == 256 || block_bits == 512, "bloom filter blocks are 256 or 512 bits");
+	using word_t = typename std::conditional<block_bits == 256, uint32_t, uint64_t>::type;
+	static constexpr uint32_t word_bits = sizeof(word_t) * 8;
+
+	struct alignas(block_bits / 8) block_t
+	{
+		word_t words[8];
+	};
+
+	block_t * blocks = nullptr;
+	uint32_t block_count = 0;
+	uint32_t count = 0;
+
+	basic_bloomfilter_t() = default;
+	basic_bloomfilter_t(uint32_t capacity, float bits_per_key = 10.0f) {init(capacity, bits_per_key);}
+	~basic_bloomfilter_t();
+	basic_bloomfilter_t(const basic_bloomfilter_t &) = delete;
+	basic_bloomfilter_t & operator=(const basic_bloomfilter_t &) = delete;
+
+	void init(uint32_t capacity, float bits_per_key = 10.0f);
+	void clear();
+
+	void add(uint32_t key);
+	bool may_contain(uint32_t key) const;
+
+	// batched versions prefetch blocks a few keys ahead
+	void add(const uint32_t * keys, size_t size);
+	size_t may_contain(const uint32_t * keys, size_t size, bool * result) const;
+
+	// expected false positive rate for a random key given current fill
+	float false_positive_rate() const;
+	float bits_per_key() const {return count ? (float)block_count * (float)block_bits / (float)count : 0.0f;}
+};
+
+using bloomfilter_t = basic_bloomfilter_t<256>;
+using bloomfilter512_t = basic_bloomfilter_t<512>;
+
+extern template struct basic_bloomfilter_t<256>;
+extern template struct basic_bloomfilter_t<512>;
+
+// 4-way bucketized cuckoo filter with partial-key cuckoo hashing
+// buckets are semi-sorted: fingerprints are kept in order so the 4 high
+// nibbles are encoded as one of 3876 sorted tuples in 12 bits instead of 16
+// the whole filter is a header plus packed words, so it can be used
+// straight from a mmapped file via attach()
+struct cuckoofilter_t
+{
+	static const uint32_t slots = 4;
+	static const uint32_t max_kicks = 500;
+	static const uint32_t magic = 0x6c6c6366u; // "fcll"
+	static const uint32_t version = 1;
+
+	struct header_t
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t fingerprint_bits;
+		uint32_t bucket_count;
+		uint32_t count;
+		uint32_t victim_used;
+		uint32_t victim_index;
+		uint32_t victim_fingerprint;
+	};
+
+	struct victim_t
+	{
+		uint32_t index = 0;
+		uint32_t fingerprint = 0;
+		bool used = false;
+	};
+
+	uint64_t * data = nullptr;
+	bool readonly = false;
+	uint32_t fingerprint_bits = 0;
+	uint32_t bucket_count = 0;
+	uint32_t count = 0;
+	victim_t victim;
+
+	cuckoofilter_t() = default;
+	cuckoofilter_t(uint32_t capacity, uint32_t fingerprint_bits = 12) {init(capacity, fingerprint_bits);}
+	~cuckoofilter_t();
+	cuckoofilter_t(const cuckoofilter_t &) = delete;
+	cuckoofilter_t & operator=(const cuckoofilter_t &) = delete;
+
+	// public
+	void init(uint32_t capacity, uint32_t fingerprint_bits = 12);
+	bool add(uint32_t key);
+	bool may_contain(uint32_t key) const;
+	bool remove(uint32_t key);
+	size_t may_contain(const uint32_t * keys, size_t size, bool * result) const;
+
+	float load_factor() const {return bucket_count ? (float)count / (float)(bucket_count * slots) : 0.0f;}
+	float bits_per_key() const {return count ? (float)bucket_count * (float)bucket_bits() / (float)count : 0.0f;}
+
+	// flat binary form, header followed by packed buckets
+	size_t serialized_size() const;
+	void serialize(void * out) const;
+	bool attach(const void * buffer, size_t size); // zero copy, read only
+	bool save(const char * path) const;
+
+	// private
+	uint32_t bucket_bits() const {return 4 * fingerprint_bits - 4;}
+	size_t word_count() const {return ((size_t)bucket_count * bucket_bits() + 63) / 64 + 1;}
+	void hash(uint32_t key, uint32_t & fingerprint, uint32_t & index) const;
+	uint32_t alt_index(uint32_t index, uint32_t fingerprint) const;
+	void read_bucket(uint32_t index, uint32_t fingerprints[slots]) const;
+	void write_bucket(uint32_t index, uint32_t fingerprints[slots]);
+	bool bucket_contains(uint32_t index, uint32_t fingerprint) const;
+	bool bucket_insert(uint32_t index, uint32_t fingerprint);
+	bool bucket_remove(uint32_t index, uint32_t fingerprint);
+	bool insert(uint32_t index, uint32_t fingerprint);
+	void release();
+};
@@ -0,0 +1,328 @@
+#include "graph.h"
+#include "sorts.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <new>
+
+graph_t::~graph_t()
+{
+	free(offsets);
+	free(targets);
+	free(weights);
+	free(x);
+	free(y);
+}
+
+void graph_t::build(uint32_t vertices, const uint32_t * sources, const uint32_t * edge_targets, const uint32_t * edge_weights, uint32_t edges)
+{
+	vertex_count = vertices;
+	edge_count = edges;
+	offsets = (uint32_t*)realloc(offsets, (vertices + 1) * sizeof(uint32_t));
+	targets = (uint32_t*)realloc(targets, (edges ? edges : 1) * sizeof(uint32_t));
+	weights = (uint32_t*)realloc(weights, (edges ? edges : 1) * sizeof(uint32_t));
+
+	uint32_t * keys = (uint32_t*)malloc((edges ? edges : 1) * sizeof(uint32_t));
+	uint32_t * order = (uint32_t*)malloc((edges ? edges : 1) * sizeof(uint32_t));
+	for(uint32_t i = 0; i < edges; ++i)
+	{
+		keys[i] = sources[i];
+		order[i] = i;
+	}
+	sorts_radixsort_pairs(keys, order, edges);
+
+	uint32_t e = 0;
+	for(uint32_t v = 0; v < vertices; ++v)
+	{
+		offsets[v] = e;
+		while(e < edges && keys[e] == v)
+			++e;
+	}
+	offsets[vertices] = e;
+	assert(e == edges);
+	for(uint32_t i = 0; i < edges; ++i)
+	{
+		targets[i] = edge_targets[order[i]];
+		weights[i] = edge_weights[order[i]];
+	}
+	free(keys);
+	free(order);
+}
+
+void graph_t::set_coordinates(const float * xs, const float * ys)
+{
+	x = (float*)realloc(x, (vertex_count ? vertex_count : 1) * sizeof(float));
+	y = (float*)realloc(y, (vertex_count ? vertex_count : 1) * sizeof(float));
+	memcpy(x, xs, vertex_count * sizeof(float));
+	memcpy(y, ys, vertex_count * sizeof(float));
+}
+
+graphsearch_t::~graphsearch_t()
+{
+	free(dist);
+	free(parent);
+	free(stamp);
+}
+
+void graphsearch_t::reset(uint32_t vertices)
+{
+	if(vertices != vertex_count)
+	{
+		vertex_count = vertices;
+		dist = (uint32_t*)realloc(dist, (vertices ? vertices : 1) * sizeof(uint32_t));
+		parent = (uint32_t*)realloc(parent, (vertices ? vertices : 1) * sizeof(uint32_t));
+		stamp = (uint32_t*)realloc(stamp, (vertices ? vertices : 1) * sizeof(uint32_t));
+		current = 0;
+	}
+	// fresh arrays, or wrapped around to 0 where every old stamp would look current
+	current += 2;
+	if(current == 0 || current == 2)
+	{
+		memset(stamp, 0, vertex_count * sizeof(uint32_t));
+		current = 2;
+	}
+	queue.clear();
+}
+
+uint32_t graphsearch_t::path(uint32_t target, uint32_t * vertices, uint32_t max) const
+{
+	if(target >= vertex_count || !seen(target))
+		return 0;
+	uint32_t length = 0;
+	for(uint32_t v = target; v != graph_t::invalid; v = parent[v])
+		++length;
+	uint32_t i = length;
+	for(uint32_t v = target; v != graph_t::invalid; v = parent[v])
+		if(--i < max)
+			vertices[i] = v;
+	return length;
+}
+
+// shared by dijkstra (zero heuristic) and a*
+template<typename heuristic_t>
+static uint32_t graph_search(const graph_t & graph, uint32_t source, uint32_t target, graphsearch_t & search, heuristic_t heuristic)
+{
+	statsscope_t scope(stats_timer_graph_search);
+	search.reset(graph.vertex_count);
+	if(source >= graph.vertex_count)
+		return graph_t::invalid;
+
+	search.stamp[source] = search.current;
+	search.dist[source] = 0;
+	search.parent[source] = graph_t::invalid;
+	search.queue.insert((uint64_t)heuristic(source) << 32 | source);
+
+	while(search.queue.count)
+	{
+		uint32_t v = (uint32_t)search.queue.remove();
+		if(search.settled(v))
+			continue; // stale entry
+		search.stamp[v] = search.current + 1;
+		if(v == target)
+			return search.dist[v];
+
+		uint32_t base = search.dist[v];
+		for(uint32_t e = graph.first_edge(v); e < graph.last_edge(v); ++e)
+		{
+			uint32_t u = graph.targets[e];
+			uint32_t d = base + graph.weights[e];
+			if(!search.seen(u) || (!search.settled(u) && d < search.dist[u]))
+			{
+				search.stamp[u] = search.current;
+				search.dist[u] = d;
+				search.parent[u] = v;
+				search.queue.insert((uint64_t)(d + heuristic(u)) << 32 | u);
+			}
+		}
+	}
+	return target != graph_t::invalid ? graph_t::invalid : 0;
+}
+
+uint32_t graph_dijkstra(const graph_t & graph, uint32_t source, uint32_t target, graphsearch_t & search)
+{
+	return graph_search(graph, source, target, search, [](uint32_t) -> uint32_t {return 0;});
+}
+
+uint32_t graph_astar(const graph_t & graph, uint32_t source, uint32_t target, float scale, graphsearch_t & search)
+{
+	assert(graph.x && graph.y && target < graph.vertex_count);
+	float tx = graph.x[target], ty = graph.y[target];
+	return graph_search(graph, source, target, search, [&graph, tx, ty, scale](uint32_t v) -> uint32_t
+	{
+		float dx = graph.x[v] - tx, dy = graph.y[v] - ty;
+		return (uint32_t)(sqrtf(dx * dx + dy * dy) * scale);
+	});
+}
+
+// growable vertex list for buckets and per thread output
+struct graphlist_t
+{
+	uint32_t * arr = nullptr;
+	uint32_t count = 0;
+	uint32_t capacity = 0;
+
+	~graphlist_t() {free(arr);}
+	void push(uint32_t v)
+	{
+		if(count == capacity)
+		{
+			capacity = capacity ? capacity * 2 : 64;
+			arr = (uint32_t*)realloc(arr, capacity * sizeof(uint32_t));
+		}
+		arr[count++] = v;
+	}
+	void append(const graphlist_t & other)
+	{
+		for(uint32_t i = 0; i < other.count; ++i)
+			push(other.arr[i]);
+	}
+};
+
+struct graphbarrier_t
+{
+	std::mutex mutex;
+	std::condition_variable condition;
+	uint32_t threads;
+	uint32_t waiting = 0;
+	uint32_t generation = 0;
+
+	graphbarrier_t(uint32_t threads) : threads(threads) {}
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		uint32_t gen = generation;
+		if(++waiting == threads)
+		{
+			waiting = 0;
+			++generation;
+			condition.notify_all();
+		}
+		else
+			condition.wait(lock, [this, gen]() {return gen != generation;});
+	}
+};
+
+void graph_deltastepping(const graph_t & graph, uint32_t source, uint32_t delta, uint32_t * dist, uint32_t threads)
+{
+	threads = threads ? threads : std::thread::hardware_concurrency();
+	threads = threads ? threads : 1;
+	delta = delta ? delta : 1;
+	for(uint32_t v = 0; v < graph.vertex_count; ++v)
+		dist[v] = graph_t::invalid;
+	if(source >= graph.vertex_count)
+		return;
+
+	graphlist_t * buckets = nullptr;
+	uint32_t bucket_count = 0;
+	auto bucket = [&buckets, &bucket_count](uint32_t index) -> graphlist_t &
+	{
+		if(index >= bucket_count)
+		{
+			uint32_t grown = index + 1 > bucket_count * 2 ? index + 1 : bucket_count * 2;
+			buckets = (graphlist_t*)realloc((void*)buckets, grown * sizeof(graphlist_t));
+			for(uint32_t i = bucket_count; i < grown; ++i)
+				new (&buckets[i]) graphlist_t();
+			bucket_count = grown;
+		}
+		return buckets[index];
+	};
+
+	// phase state shared with the workers
+	graphlist_t frontier, settled;
+	graphlist_t * updated = new graphlist_t[threads];
+	const graphlist_t * work = nullptr;
+	bool heavy = false, stop = false;
+
+	// relax light or heavy edges of a slice of the work list,
+	// improved vertices are collected per thread and bucketed afterwards
+	auto relax = [&](uint32_t t)
+	{
+		graphlist_t & out = updated[t];
+		out.count = 0;
+		uint32_t first = (uint32_t)((uint64_t)work->count * t / threads);
+		uint32_t last = (uint32_t)((uint64_t)work->count * (t + 1) / threads);
+		for(uint32_t i = first; i < last; ++i)
+		{
+			uint32_t v = work->arr[i];
+			uint32_t base = __atomic_load_n(&dist[v], __ATOMIC_RELAXED);
+			for(uint32_t e = graph.first_edge(v); e < graph.last_edge(v); ++e)
+			{
+				if((graph.weights[e] > delta) != heavy)
+					continue;
+				uint32_t u = graph.targets[e];
+				uint32_t d = base + graph.weights[e];
+				uint32_t old = __atomic_load_n(&dist[u], __ATOMIC_RELAXED);
+				while(d < old)
+					if(__atomic_compare_exchange_n(&dist[u], &old, d, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+					{
+						out.push(u);
+						break;
+					}
+			}
+		}
+	};
+
+	graphbarrier_t barrier(threads);
+	std::thread * workers = new std::thread[threads - 1];
+	for(uint32_t t = 1; t < threads; ++t)
+		workers[t - 1] = std::thread([&, t]()
+		{
+			for(;;)
+			{
+				barrier.wait();
+				if(stop)
+					return;
+				relax(t);
+				barrier.wait();
+			}
+		});
+	auto phase = [&](const graphlist_t & list, bool heavy_edges)
+	{
+		work = &list;
+		heavy = heavy_edges;
+		barrier.wait();
+		relax(0);
+		barrier.wait();
+		for(uint32_t t = 0; t < threads; ++t)
+			for(uint32_t i = 0; i < updated[t].count; ++i)
+			{
+				uint32_t u = updated[t].arr[i];
+				bucket(dist[u] / delta).push(u);
+			}
+	};
+
+	dist[source] = 0;
+	bucket(0).push(source);
+	for(uint32_t i = 0; i < bucket_count; ++i)
+	{
+		settled.count = 0;
+		while(buckets[i].count)
+		{
+			// take the bucket, dropping entries that moved to a lower one
+			frontier.count = 0;
+			for(uint32_t j = 0; j < buckets[i].count; ++j)
+				if(dist[buckets[i].arr[j]] / delta == i)
+					frontier.push(buckets[i].arr[j]);
+			buckets[i].count = 0;
+			settled.append(frontier);
+			if(frontier.count)
+				phase(frontier, false); // light edges may refill bucket i
+		}
+		if(settled.count)
+			phase(settled, true); // heavy edges always land in later buckets
+	}
+
+	stop = true;
+	barrier.wait();
+	for(uint32_t t = 1; t < threads; ++t)
+		workers[t - 1].join();
+	delete[] workers;
+	delete[] updated;
+	for(uint32_t i = 0; i < bucket_count; ++i)
+		buckets[i].~graphlist_t();
+	free(buckets);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "containers.h"
+
+// directed weighted graph in compressed sparse row form:
+// edges of vertex v are targets[offsets[v]..offsets[v + 1]]
+struct graph_t
+{
+	static const uint32_t invalid = 0xffffffffu;
+
+	uint32_t vertex_count = 0;
+	uint32_t edge_count = 0;
+	uint32_t * offsets = nullptr;
+	uint32_t * targets = nullptr;
+	uint32_t * weights = nullptr;
+	float * x = nullptr; // optional coordinates for a* heuristic
+	float * y = nullptr;
+
+	graph_t() = default;
+	~graph_t();
+	graph_t(const graph_t &) = delete;
+	graph_t & operator=(const graph_t &) = delete;
+
+	// edge list is sorted by source with sorts_radixsort_pairs
+	void build(uint32_t vertices, const uint32_t * sources, const uint32_t * edge_targets, const uint32_t * edge_weights, uint32_t edges);
+	void set_coordinates(const float * xs, const float * ys);
+	uint32_t first_edge(uint32_t v) const {return offsets[v];}
+	uint32_t last_edge(uint32_t v) const {return offsets[v + 1];}
+};
+
+// min heap of distance << 32 | vertex
+// stale entries are left in and skipped when popped (lazy deletion)
+using graphqueue_t = basic_binaryheap_t<uint64_t, growable_capacity_t, false>;
+
+// per query scratch, reused between queries
+// a slot belongs to the current query only if its stamp says so,
+// so starting a query is one increment instead of clearing every vertex
+struct graphsearch_t
+{
+	uint32_t * dist = nullptr;
+	uint32_t * parent = nullptr;
+	uint32_t * stamp = nullptr;
+	uint32_t vertex_count = 0;
+	uint32_t current = 0; // even, current + 1 marks settled vertices
+	graphqueue_t queue;
+
+	graphsearch_t() = default;
+	~graphsearch_t();
+	graphsearch_t(const graphsearch_t &) = delete;
+	graphsearch_t & operator=(const graphsearch_t &) = delete;
+
+	void reset(uint32_t vertices);
+	bool seen(uint32_t v) const {return stamp[v] >= current;}
+	bool settled(uint32_t v) const {return stamp[v] == current + 1;}
+	uint32_t distance(uint32_t v) const {return seen(v) ? dist[v] : graph_t::invalid;}
+	// vertices from source to target, returns length, written up to max
+	uint32_t path(uint32_t target, uint32_t * vertices, uint32_t max) const;
+};
+
+// distance from source to target, all reachable vertices if target is invalid
+uint32_t graph_dijkstra(const graph_t & graph, uint32_t source, uint32_t target, graphsearch_t & search);
+// heuristic is straight line distance times scale, which must not overestimate
+uint32_t graph_astar(const graph_t & graph, uint32_t source, uint32_t target, float scale, graphsearch_t & search);
+// parallel single source all targets, dist gets vertex_count entries
+void graph_deltastepping(const graph_t & graph, uint32_t source, uint32_t delta, uint32_t * dist, uint32_t threads = 0);
@@ -0,0 +1,111 @@
+#include "join.h"
+#include "containers.h"
+#include "sorts.h"
+#include <stdlib.h>
+#include <string.h>
+
+joinresult_t::~joinresult_t()
+{
+	free(build_values);
+	free(probe_values);
+}
+
+void joinresult_t::push(uint32_t build_value, uint32_t probe_value)
+{
+	if(count == capacity)
+	{
+		capacity = capacity ? capacity * 2 : 1024;
+		build_values = (uint32_t*)realloc(build_values, capacity * sizeof(uint32_t));
+		probe_values = (uint32_t*)realloc(probe_values, capacity * sizeof(uint32_t));
+	}
+	build_values[count] = build_value;
+	probe_values[count++] = probe_value;
+}
+
+void joinresult_t::append(const joinresult_t & other)
+{
+	if(count + other.count > capacity)
+	{
+		capacity = count + other.count;
+		build_values = (uint32_t*)realloc(build_values, capacity * sizeof(uint32_t));
+		probe_values = (uint32_t*)realloc(probe_values, capacity * sizeof(uint32_t));
+	}
+	if(other.count)
+	{
+		memcpy(build_values + count, other.build_values, other.count * sizeof(uint32_t));
+		memcpy(probe_values + count, other.probe_values, other.count * sizeof(uint32_t));
+	}
+	count += other.count;
+}
+
+size_t join_hash(const joinrelation_t & build, const joinrelation_t & probe, joinresult_t & result, uint32_t threads)
+{
+	threads = containers_threads(threads);
+	basic_hashtable_t<uint32_t, uint32_t, growable_capacity_t> table;
+	table.build(build.keys, build.values, build.count, threads);
+
+	// every thread probes a slice into its own result, appended in slice order
+	const size_t ahead = 8;
+	joinresult_t * partial = new joinresult_t[threads];
+	containers_parallel(threads, [&](uint32_t t)
+	{
+		size_t first = (size_t)((uint64_t)probe.count * t / threads);
+		size_t last = (size_t)((uint64_t)probe.count * (t + 1) / threads);
+		joinresult_t & out = threads > 1 ? partial[t] : result;
+		for(size_t i = first; i < last; ++i)
+		{
+			if(i + ahead < last)
+				table.prefetch(probe.keys[i + ahead]);
+			uint32_t probe_value = probe.values[i];
+			table.find_all(probe.keys[i], [&out, probe_value](uint32_t build_value) {out.push(build_value, probe_value);});
+		}
+	});
+	if(threads > 1)
+		for(uint32_t t = 0; t < threads; ++t)
+			result.append(partial[t]);
+	delete[] partial;
+	return result.count;
+}
+
+size_t join_sortmerge(const joinrelation_t & build, const joinrelation_t & probe, joinresult_t & result)
+{
+	size_t bytes_build = (build.count ? build.count : 1) * sizeof(uint32_t);
+	size_t bytes_probe = (probe.count ? probe.count : 1) * sizeof(uint32_t);
+	uint32_t * build_keys = (uint32_t*)malloc(bytes_build);
+	uint32_t * build_values = (uint32_t*)malloc(bytes_build);
+	uint32_t * probe_keys = (uint32_t*)malloc(bytes_probe);
+	uint32_t * probe_values = (uint32_t*)malloc(bytes_probe);
+	memcpy(build_keys, build.keys, build.count * sizeof(uint32_t));
+	memcpy(build_values, build.values, build.count * sizeof(uint32_t));
+	memcpy(probe_keys, probe.keys, probe.count * sizeof(uint32_t));
+	memcpy(probe_values, probe.values, probe.count * sizeof(uint32_t));
+	sorts_radixsort_pairs(build_keys, build_values, build.count);
+	sorts_radixsort_pairs(probe_keys, probe_values, probe.count);
+
+	size_t i = 0, j = 0;
+	while(i < build.count && j < probe.count)
+	{
+		if(build_keys[i] < probe_keys[j])
+			++i;
+		else if(probe_keys[j] < build_keys[i])
+			++j;
+		else
+		{
+			// equal runs on both sides, every pair matches
+			uint32_t key = build_keys[i];
+			size_t run = i;
+			while(run < build.count && build_keys[run] == key)
+				++run;
+			for(; j < probe.count && probe_keys[j] == key; ++j)
+				for(size_t k = i; k < run; ++k)
+					result.push(build_values[k], probe_values[j]);
+			i = run;
+		}
+	}
+
+	free(build_keys);
+	free(build_values);
+	free(probe_keys);
+	free(probe_values);
+	return result.count;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// equi join of two relations of (key, payload) rows
+// the result holds the payload pair of every matching row pair
+struct joinrelation_t
+{
+	const uint32_t * keys;
+	const uint32_t * values;
+	size_t count;
+};
+
+struct joinresult_t
+{
+	uint32_t * build_values = nullptr;
+	uint32_t * probe_values = nullptr;
+	size_t count = 0;
+	size_t capacity = 0;
+
+	joinresult_t() = default;
+	~joinresult_t();
+	joinresult_t(const joinresult_t &) = delete;
+	joinresult_t & operator=(const joinresult_t &) = delete;
+
+	void push(uint32_t build_value, uint32_t probe_value);
+	void append(const joinresult_t & other);
+	void clear() {count = 0;}
+};
+
+// partitioned hash join: hashtable bulk build over build, parallel probe
+// duplicates on either side are fine, the smaller relation should be build
+size_t join_hash(const joinrelation_t & build, const joinrelation_t & probe, joinresult_t & result, uint32_t threads = 0);
+// sort merge join: both sides sorted by key with sorts_radixsort_pairs, equal runs crossed
+size_t join_sortmerge(const joinrelation_t & build, const joinrelation_t & probe, joinresult_t & result);
@@ -3,16 +3,39 @@
 #include <assert.h>
 #include "sorts.h"
 #include "containers.h"
+#include "filters.h"
+#include "file.h"
+#include "radixtree.h"
+#include "spatial.h"
+#include "rtree.h"
+#include "graph.h"
+#include "snapshot.h"
+#include "benchmarks.h"
+#include "stats.h"
+#include "join.h"
+#include "aggregate.h"
+#include "workload.h"
+#include "verify.h"
+#include "search.h"
+#include "sets.h"
+#include "column.h"
+#include "tasks.h"
+#include "cache.h"
+#include "stringsort.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 bool sorts_test(void (*sort)(dataset_t&), size_t count = 1000)
 {
 	for(size_t i = 0; i < count; ++i)
 	{
+		// sorted and nothing lost or duplicated on the way
 		dataset_t a = dataset_t::random();
+		verifier_t verifier(i, 1);
+		verifier.expect(a.items, a.count);
 		sort(a);
-		if(!a.validate())
+		if(!a.validate() || !verifier.check(a.items, a.count))
 			return false;
 	}
 	return true;
@@ -22,26 +45,47 @@ bool linkedlist_test()
 {
 	linkedlist_t list;
 	list.insert(0);
-	for(uint32_t i = 0; i < list.count - 1; ++i)
+	for(uint32_t i = 0; i < list.capacity - 1; ++i)
 		list.insert_before(i, 0);
+
+	// order from the front (next of last), moves keep the ring and the last node consistent
+	linkedlist_t small;
+	auto order = [&small](const uint32_t (&values)[4])
+	{
+		uint32_t index = small.next(small.last());
+		for(uint32_t i = 0; i < 4; ++i, index = small.next(index))
+			if(small.value(index) != values[i])
+				return false;
+		return index == small.next(small.last());
+	};
+	uint32_t nodes[4];
+	for(uint32_t i = 0; i < 4; ++i)
+		nodes[i] = small.insert(i);
+	small.move_after(nodes[0], nodes[1]);
+	bool ok = order({1, 0, 2, 3});
+	small.move_after(nodes[3], nodes[1]);
+	ok = ok && order({1, 3, 0, 2});
+	small.move_after(nodes[1], small.invalid);
+	ok = ok && order({3, 0, 2, 1});
+
 	while(list.last() != list.invalid)
 		list.remove(list.last());
-	return true;
+	return ok;
 }
 
 bool hashtable_test(float loadfactor = 1.0f)
 {
 	hashtable_t table;
-	uint32_t keys[hashtable_t::count] = {0};
-	uint32_t values[hashtable_t::count] = {0};
-	uint32_t payload = (uint32_t)((float)hashtable_t::count * loadfactor);
+	uint32_t keys[hashtable_t::capacity] = {0};
+	uint32_t values[hashtable_t::capacity] = {0};
+	uint32_t payload = (uint32_t)((float)hashtable_t::capacity * loadfactor);
 
 	for(uint32_t i = 0; i < payload; ++i)
 	{
-		uint32_t key = rand();
+		uint32_t key = workload_next();
 		while(table.contains(key))
-			key = rand();
-		table.set(keys[i] = key, values[i] = rand());
+			key = workload_next();
+		table.set(keys[i] = key, values[i] = workload_next());
 	}
 
 	for(uint32_t i = 0; i < payload; ++i)
@@ -51,18 +95,1095 @@ bool hashtable_test(float loadfactor = 1.0f)
 	return true;
 }
 
+bool hashtable_filter_test()
+{
+	hashtable_t table;
+	bloomfilter_t filter(hashtable_t::capacity);
+	table.set_filter(&filter);
+	for(uint32_t i = 0; i < hashtable_t::capacity / 2; ++i)
+		table.set(i * 2, i);
+	for(uint32_t i = 0; i < hashtable_t::capacity; ++i)
+		if(table.contains(i) != !(i & 1))
+			return false;
+	return true;
+}
+
+template<typename filter_t = bloomfilter_t>
+bool bloomfilter_test(uint32_t count = 10000, float bits_per_key = 10.0f)
+{
+	filter_t filter(count, bits_per_key);
+	uint32_t * keys = new uint32_t[count];
+	bool * result = new bool[count];
+	for(uint32_t i = 0; i < count; ++i)
+		keys[i] = i * 2;
+	filter.add(keys, count);
+
+	// no false negatives
+	bool ok = filter.may_contain(keys, count, result) == count;
+
+	// odd keys were never added, measured rate should be near the estimate
+	for(uint32_t i = 0; i < count; ++i)
+		keys[i] = i * 2 + 1;
+	float measured = (float)filter.may_contain(keys, count, result) / (float)count;
+	float expected = filter.false_positive_rate();
+	ok = ok && measured < expected * 2.0f + 0.005f;
+
+	delete[] keys;
+	delete[] result;
+	return ok;
+}
+
+bool cuckoofilter_test(uint32_t count = 4096, uint32_t fingerprint_bits = 12)
+{
+	cuckoofilter_t filter(count, fingerprint_bits);
+	uint32_t added = 0;
+	while(added < count * 9 / 10 && filter.add(added * 3))
+		++added;
+	for(uint32_t i = 0; i < added; ++i)
+		if(!filter.may_contain(i * 3))
+			return false;
+
+	// deletes only drop what was removed
+	for(uint32_t i = 0; i < added; i += 2)
+		if(!filter.remove(i * 3))
+			return false;
+	for(uint32_t i = 1; i < added; i += 2)
+		if(!filter.may_contain(i * 3))
+			return false;
+
+	// round trip through the flat format
+	const char * path = "cuckoofilter.bin";
+	if(!filter.save(path))
+		return false;
+	mappedfile_t file(path);
+	cuckoofilter_t mapped;
+	bool ok = file.valid() && mapped.attach(file.data, file.size) && mapped.count == filter.count;
+	for(uint32_t i = 0; ok && i < added; ++i)
+		ok = mapped.may_contain(i * 3) == filter.may_contain(i * 3);
+	remove(path);
+	return ok;
+}
+
+bool radixtree_test(uint32_t count = 10000)
+{
+	radixtree_t tree;
+	for(uint32_t i = 0; i < count; ++i)
+		tree.set((uint64_t)workload_next() << 20 ^ (uint64_t)i, i);
+	for(uint32_t i = 0; i < count; ++i)
+		tree.set(i, i);
+
+	// in order and complete
+	uint64_t last = 0;
+	size_t seen = 0;
+	bool ordered = true;
+	struct state_t {uint64_t * last; size_t * seen; bool * ordered;} state = {&last, &seen, &ordered};
+	tree.scan(0, ~0ull, [](uint64_t key, uint32_t, void * user) -> bool
+	{
+		state_t & s = *(state_t*)user;
+		*s.ordered = *s.ordered && (!*s.seen || *s.last < key);
+		*s.last = key;
+		++*s.seen;
+		return true;
+	}, &state);
+	if(!ordered || seen != tree.count)
+		return false;
+
+	uint64_t keys[16];
+	uint32_t values[16];
+	if(tree.range(100, 1000, keys, values, 16) != 16 || keys[0] != 100 || keys[15] != 115)
+		return false;
+
+	for(uint32_t i = 0; i < count; i += 2)
+		if(!tree.remove(i))
+			return false;
+	for(uint32_t i = 0; i < count; ++i)
+		if((tree.get(i) == i) != (i & 1))
+			return false;
+	return true;
+}
+
+template<typename tree_t>
+bool spatial_test(uint32_t count = 2000)
+{
+	float x[2000], y[2000];
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		x[i] = (float)workload_below(1000);
+		y[i] = (float)workload_below(1000);
+	}
+	tree_t tree;
+	tree.build(x, y, count);
+
+	for(uint32_t q = 0; q < 100; ++q)
+	{
+		float qx = (float)workload_below(1000), qy = (float)workload_below(1000);
+
+		// nearest neighbours must be as close as brute force ones
+		uint32_t ids[4];
+		float dist[4];
+		if(tree.knn(qx, qy, 4, ids, dist) != 4)
+			return false;
+		uint32_t closer = 0;
+		for(uint32_t i = 0; i < count; ++i)
+			closer += (x[i] - qx) * (x[i] - qx) + (y[i] - qy) * (y[i] - qy) < dist[3];
+		if(closer > 3)
+			return false;
+
+		uint32_t inside = 0;
+		for(uint32_t i = 0; i < count; ++i)
+			inside += x[i] >= qx && x[i] <= qx + 100 && y[i] >= qy && y[i] <= qy + 50;
+		uint32_t found[2000];
+		if(tree.box(qx, qy, qx + 100, qy + 50, found, count) != inside)
+			return false;
+
+		inside = 0;
+		for(uint32_t i = 0; i < count; ++i)
+			inside += (x[i] - qx) * (x[i] - qx) + (y[i] - qy) * (y[i] - qy) <= 50 * 50;
+		if(tree.radius(qx, qy, 50, found, count) != inside)
+			return false;
+	}
+	return true;
+}
+
+bool rtree_test(uint32_t count = 3000)
+{
+	rtree_t::box_t boxes[3000];
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		float x = (float)workload_below(1000), y = (float)workload_below(1000);
+		boxes[i] = {x, y, x + (float)workload_below(20), y + (float)workload_below(20)};
+	}
+	rtree_t packed, dynamic;
+	packed.build(boxes, count);
+	for(uint32_t i = 0; i < count; ++i)
+		dynamic.insert(boxes[i], i);
+
+	const char * path = "rtree.bin";
+	if(!packed.save(path))
+		return false;
+	mappedfile_t file(path);
+	rtree_t mapped;
+	bool ok = file.valid() && mapped.attach(file.data, file.size);
+
+	uint32_t ids[3000];
+	for(uint32_t q = 0; ok && q < 100; ++q)
+	{
+		float x = (float)workload_below(1000), y = (float)workload_below(1000);
+		rtree_t::box_t window = {x, y, x + 50.0f, y + 30.0f};
+		uint32_t expected = 0;
+		for(uint32_t i = 0; i < count; ++i)
+			expected += boxes[i].min_x <= window.max_x && boxes[i].max_x >= window.min_x &&
+						boxes[i].min_y <= window.max_y && boxes[i].max_y >= window.min_y;
+		ok = packed.query(window, ids, count) == expected &&
+			 dynamic.query(window, ids, count) == expected &&
+			 mapped.query(window, ids, count) == expected;
+	}
+	remove(path);
+	return ok;
+}
+
+bool graph_test(uint32_t width = 40)
+{
+	// grid with a few missing edges, unit spacing, weights of at least 10
+	uint32_t vertices = width * width, edges = 0;
+	uint32_t sources[4 * 40 * 40], targets[4 * 40 * 40], weights[4 * 40 * 40];
+	float x[40 * 40], y[40 * 40];
+	for(uint32_t v = 0; v < vertices; ++v)
+	{
+		x[v] = (float)(v % width);
+		y[v] = (float)(v / width);
+		uint32_t neighbours[4] = {v + 1, v - 1, v + width, v - width};
+		bool valid[4] = {v % width + 1 < width, v % width > 0, v + width < vertices, v >= width};
+		for(uint32_t i = 0; i < 4; ++i)
+			if(valid[i] && workload_below(8))
+			{
+				sources[edges] = v;
+				targets[edges] = neighbours[i];
+				weights[edges++] = 10 + workload_below(20);
+			}
+	}
+	graph_t graph;
+	graph.build(vertices, sources, targets, weights, edges);
+	graph.set_coordinates(x, y);
+
+	graphsearch_t all, search;
+	uint32_t dist[40 * 40];
+	for(uint32_t q = 0; q < 10; ++q)
+	{
+		uint32_t source = workload_below(vertices);
+		graph_dijkstra(graph, source, graph_t::invalid, all);
+		graph_deltastepping(graph, source, 15, dist, 3);
+		for(uint32_t v = 0; v < vertices; ++v)
+			if(dist[v] != all.distance(v))
+				return false;
+		for(uint32_t i = 0; i < 10; ++i)
+		{
+			uint32_t target = workload_below(vertices);
+			if(graph_dijkstra(graph, source, target, search) != all.distance(target) ||
+			   graph_astar(graph, source, target, 10.0f, search) != all.distance(target))
+				return false;
+		}
+	}
+
+	// stamps wrapping around, 1 was reached by the search before and not by the one after
+	uint32_t pair_sources[2] = {0, 1}, pair_targets[2] = {1, 0}, pair_weights[2] = {5, 5};
+	graph_t pair;
+	pair.build(3, pair_sources, pair_targets, pair_weights, 2);
+	graphsearch_t wrap;
+	wrap.reset(3);
+	wrap.current = 0xfffffffc;
+	graph_dijkstra(pair, 0, graph_t::invalid, wrap);
+	if(wrap.distance(1) != 5)
+		return false;
+	graph_dijkstra(pair, 2, graph_t::invalid, wrap);
+	return wrap.current == 2 && wrap.distance(1) == graph_t::invalid && wrap.distance(2) == 0;
+}
+
+bool snapshot_test()
+{
+	const char * path = "snapshot.bin";
+	hashtable_t * table = new hashtable_t;
+	rbtree_t * tree = new rbtree_t;
+	dataset_t data = dataset_t::random(100);
+	for(uint32_t i = 0; i < 100; ++i)
+	{
+		table->set(i * 7, i);
+		tree->set(i * 7, i);
+	}
+
+	bool ok = snapshot_write(path, *table);
+	snapshot_t snapshot;
+	ok = ok && snapshot.open(path, true) && !snapshot.get<rbtree_t>();
+	// same family and size, other value type or slots policy
+	ok = ok && !snapshot.get<basic_hashtable_t<uint32_t, float>>() && !snapshot.get<basic_hashtable_t<uint32_t, int32_t>>();
+	ok = ok && !snapshot.get<basic_hashtable_t<uint32_t, uint32_t, fixed_capacity_t<256>, sentinel_slots_t>>();
+	const hashtable_t * mapped_table = snapshot.get<hashtable_t>();
+	for(uint32_t i = 0; ok && i < 100; ++i)
+		ok = mapped_table && mapped_table->get(i * 7) == i && !mapped_table->contains(i * 7 + 1);
+
+	ok = ok && snapshot_write(path, *tree) && snapshot.open(path, true);
+	const rbtree_t * mapped_tree = snapshot.get<rbtree_t>();
+	for(uint32_t i = 0; ok && i < 100; ++i)
+		ok = mapped_tree && mapped_tree->get(i * 7) == i && mapped_tree->find_index(i * 7 + 1) == rbtree_t::invalid;
+
+	ok = ok && snapshot_write(path, data) && snapshot.open(path, true);
+	const dataset_t * mapped_data = snapshot.get<dataset_t>();
+	ok = ok && mapped_data && mapped_data->count == data.count && mapped_data->items[99] == data.items[99];
+
+	snapshot.close();
+	remove(path);
+	delete table;
+	delete tree;
+	return ok;
+}
+
 bool rbtree_test()
 {
 	rbtree_t t;
-	for(uint32_t i = 0; i < t.count; ++i)
-		t.set(i, rand());
+	for(uint32_t i = 0; i < t.capacity; ++i)
+		t.set(i, workload_next());
 	while(t.root != t.invalid)
-		t.remove(rand() % t.count);
+		t.remove(workload_below(t.capacity));
 	return true;
 }
 
-int main()
+bool rbtree_order_test(uint32_t operations = 6000)
 {
+	// random inserts and removes, small enough that validate also checks every subtree size
+	const uint32_t universe = 3000;
+	using tree_t = basic_rbtree_t<uint32_t, uint32_t, fixed_capacity_t<1024>, true>;
+	tree_t * tree = new tree_t;
+	bool * present = new bool[universe]();
+	bool ok = tree->count() == 0 && tree->select(0) == tree->invalid && tree->percentile(50) == tree->invalid;
+	for(uint32_t i = 0; ok && i < operations; ++i)
+	{
+		uint32_t key = workload_below(universe);
+		if(present[key] || tree->count() == 1000)
+		{
+			tree->remove(key);
+			present[key] = false;
+		}
+		else
+			present[key] = tree->set(key, i);
+		if(i % 50)
+			continue;
+
+		uint32_t lo = workload_below(universe), hi = workload_below(universe), below = 0, between = 0, n = 0;
+		for(uint32_t k = 0; k < universe; ++k)
+		{
+			below += present[k] && k < lo;
+			between += present[k] && lo <= k && k <= hi;
+			if(present[k] && ok)
+				ok = tree->arr[tree->select(n++)].key == k;
+		}
+		ok = ok && tree->count() == n && tree->select(n) == tree->invalid &&
+			 tree->rank(lo) == below && tree->count_range(lo, hi) == between;
+	}
+	delete tree;
+	delete[] present;
+
+	// sliding window with repeated values against a sorted copy of the window
+	const uint32_t window = 300;
+	basic_rbtree_t<uint32_t, uint32_t, growable_capacity_t, true> sliding;
+	uint32_t values[window], sorted[window], scratch[window];
+	const double percentiles[] = {0, 1, 50, 90, 99.9, 100};
+	for(uint32_t i = 0; ok && i < 3000; ++i)
+	{
+		if(i >= window)
+			sliding.remove(values[i % window]);
+		values[i % window] = workload_below(200);
+		sliding.set(values[i % window], i, true);
+		uint32_t n = i + 1 < window ? i + 1 : window;
+		memcpy(sorted, values, n * sizeof(uint32_t));
+		sorts_radixsort_pairs(sorted, scratch, n);
+		for(double p : percentiles)
+		{
+			double rank = p / 100.0 * n;
+			uint32_t k = (uint32_t)rank + ((double)(uint32_t)rank < rank);
+			k = k ? (k < n ? k - 1 : n - 1) : 0;
+			ok = ok && sliding.arr[sliding.percentile(p)].key == sorted[k];
+		}
+	}
+	return ok && sliding.validate();
+}
+
+bool containers_template_test(uint32_t count = 2000)
+{
+	// 64 bit keys around the old sentinel, growable storage, removes in the middle of probe runs
+	basic_hashtable_t<uint64_t, uint16_t, growable_capacity_t> table;
+	basic_rbtree_t<uint64_t, uint16_t, growable_capacity_t> tree;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		uint64_t key = 0xffffffffull + i * 0x100000000ull - count / 2;
+		table.set(key, (uint16_t)i);
+		tree.set(key, (uint16_t)i);
+	}
+	for(uint32_t i = 0; i < count; i += 2)
+	{
+		uint64_t key = 0xffffffffull + i * 0x100000000ull - count / 2;
+		table.remove(key);
+		tree.remove(key);
+	}
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		uint64_t key = 0xffffffffull + i * 0x100000000ull - count / 2;
+		bool kept = i & 1;
+		if(table.contains(key) != kept || (tree.find_index(key) != tree.invalid) != kept ||
+		   (kept && (table.get(key) != i || tree.get(key) != i)))
+			return false;
+	}
+	uint64_t keys[4];
+	uint16_t values[4];
+	if(!tree.validate() || tree.range(0, ~0ull, keys, values, 4) != 4 || values[0] != 1 || values[3] != 7)
+		return false;
+
+	// the sentinel policy trades the all ones key for a smaller entry
+	basic_hashtable_t<uint16_t, uint16_t, fixed_capacity_t<64>, sentinel_slots_t> small;
+	static_assert(sizeof(small.arr[0]) == 4, "sentinel entries carry no flag");
+	if(small.set(0xffff, 1) || !small.set(0xfffe, 1))
+		return false;
+
+	basic_binaryheap_t<uint64_t, growable_capacity_t, false> heap;
+	for(uint32_t i = 0; i < count; ++i)
+		heap.insert((uint64_t)(i * 7919u % count) << 32);
+	for(uint32_t i = 0; i < count; ++i)
+		if(heap.remove() != (uint64_t)i << 32)
+			return false;
+	return true;
+}
+
+bool join_test(uint32_t count = 20000)
+{
+	// duplicate keys on both sides, half the probe keys miss
+	uint32_t * keys = new uint32_t[count * 2];
+	uint32_t * values = new uint32_t[count * 2];
+	for(uint32_t i = 0; i < count * 2; ++i)
+	{
+		keys[i] = hash_fnv1(i) % (i < count ? count / 2 : count);
+		values[i] = i;
+	}
+	joinrelation_t build = {keys, values, count}, probe = {keys + count, values + count, count};
+	joinresult_t hashed, merged;
+	join_hash(build, probe, hashed, 4);
+	join_sortmerge(build, probe, merged);
+
+	// same multiset of pairs, compared through an order free fingerprint
+	auto fingerprint = [](const joinresult_t & r)
+	{
+		uint64_t sum = 0;
+		for(size_t i = 0; i < r.count; ++i)
+			sum += hash_fnv1((uint64_t)r.build_values[i] << 32 | r.probe_values[i]);
+		return sum;
+	};
+	size_t expected = 0;
+	for(uint32_t i = 0; i < count; i += 97)
+		for(uint32_t j = 0; j < count; ++j)
+			expected += keys[i] == keys[count + j];
+	size_t sampled = 0;
+	for(size_t i = 0; i < hashed.count; ++i)
+		sampled += hashed.build_values[i] % 97 == 0;
+	delete[] keys;
+	delete[] values;
+	return hashed.count == merged.count && fingerprint(hashed) == fingerprint(merged) && sampled == expected;
+}
+
+bool aggregate_test(uint32_t count = 50000)
+{
+	// few, some and many groups, then clustered keys for the batched runs
+	// values stay below 32 so a bit mask per key is the distinct reference
+	const uint32_t cardinalities[] = {5, 3000, 40000, 0};
+	uint32_t * keys = new uint32_t[count];
+	uint32_t * values = new uint32_t[count];
+	bool ok = true;
+	for(uint32_t cardinality : cardinalities)
+	{
+		uint32_t groups = cardinality ? cardinality : count / 37 + 1;
+		for(uint32_t i = 0; i < count; ++i)
+		{
+			keys[i] = (cardinality ? hash_fnv1(i) % cardinality : i / 37) * 7 + 1;
+			values[i] = hash_fnv1(i + count) % 32;
+		}
+		uint64_t * sums = new uint64_t[groups]();
+		uint32_t * counts = new uint32_t[groups]();
+		uint32_t * masks = new uint32_t[groups]();
+		for(uint32_t i = 0; i < count; ++i)
+		{
+			uint32_t g = (keys[i] - 1) / 7;
+			sums[g] += values[i];
+			++counts[g];
+			masks[g] |= 1u << values[i];
+		}
+
+		for(uint32_t run = 0; run < 4; ++run)
+		{
+			aggregateresult_t result;
+			if(run == 0)
+				aggregate_hash(keys, values, count, result, true, 1);
+			else if(run == 1)
+				aggregate_hash(keys, values, count, result, true, 4);
+			else if(run == 2)
+				aggregate_sort(keys, values, count, result, true);
+			else
+				aggregate(keys, values, count, result, true);
+			result.sort();
+			size_t expected = 0;
+			for(uint32_t g = 0; g < groups; ++g)
+				expected += counts[g] != 0;
+			ok = ok && result.count == expected;
+			for(size_t i = 0; ok && i < result.count; ++i)
+			{
+				const aggregategroup_t & group = result.groups[i];
+				uint32_t g = (group.key - 1) / 7;
+				uint32_t mask = masks[g];
+				ok = (i == 0 || result.groups[i - 1].key < group.key) &&
+					 group.count == counts[g] && group.sum == sums[g] &&
+					 group.min == (uint32_t)__builtin_ctz(mask) && group.max == 31u - __builtin_clz(mask) &&
+					 group.distinct == (uint32_t)__builtin_popcount(mask);
+			}
+		}
+		delete[] sums;
+		delete[] counts;
+		delete[] masks;
+	}
+	delete[] keys;
+	delete[] values;
+
+	// the vector loop against the scalar one, wide values and ragged tails
+	uint32_t wide[100];
+	for(uint32_t i = 0; i < 100; ++i)
+		wide[i] = hash_fnv1(i) | 0x80000000u * (i & 1);
+	for(uint32_t size = 0; ok && size <= 100; size += 7)
+	{
+		aggregategroup_t group = {0, UINT32_MAX, 0, 0, 0, 0};
+		aggregate_accumulate(group, wide, size);
+		uint64_t sum = 0;
+		uint32_t min = UINT32_MAX, max = 0;
+		for(uint32_t i = 0; i < size; ++i)
+		{
+			sum += wide[i];
+			min = wide[i] < min ? wide[i] : min;
+			max = wide[i] > max ? wide[i] : max;
+		}
+		ok = group.count == size && group.sum == sum && group.min == min && group.max == max;
+	}
+	return ok;
+}
+
+bool workload_test(uint32_t count = 200000)
+{
+	// reference outputs of both generators
+	xoshiro256_t xoshiro;
+	xoshiro.s[0] = 1; xoshiro.s[1] = 2; xoshiro.s[2] = 3; xoshiro.s[3] = 4;
+	pcg32_t pcg(42, 54);
+	bool ok = xoshiro.next() == 11520 && xoshiro.next() == 0 && pcg.next() == 0xa15c02b7u && pcg.next() == 0x7b47f409u;
+
+	// same seed, same items for any thread count, and a short fill (the scalar
+	// tail) matches the head of a long one (the vector loop)
+	uint32_t * a = new uint32_t[count];
+	uint32_t * b = new uint32_t[count];
+	workload_uniform(a, count, 7, 0, 1);
+	workload_uniform(b, count, 7, 0, 3);
+	ok = ok && !memcmp(a, b, count * sizeof(uint32_t));
+	workload_uniform(b, 13, 7, 0, 1);
+	ok = ok && !memcmp(a, b, 13 * sizeof(uint32_t));
+	uint32_t high = 0;
+	for(uint32_t i = 0; i < count; ++i)
+		high |= a[i];
+	ok = ok && high == UINT32_MAX;
+
+	workload_uniform(a, count, 8, 1000);
+	workload_uniform(b, 13, 8, 1000);
+	ok = ok && !memcmp(a, b, 13 * sizeof(uint32_t));
+	for(uint32_t i = 0; ok && i < count; ++i)
+		ok = a[i] < 1000;
+	workload_sorted(a, count, 9);
+	for(uint32_t i = 1; ok && i < count; ++i)
+		ok = a[i - 1] <= a[i];
+	workload_sorted(a, count, 9, 0.1);
+	uint32_t descents = 0;
+	for(uint32_t i = 1; i < count; ++i)
+		descents += a[i - 1] > a[i];
+	ok = ok && descents > count / 40 && descents < count / 5;
+
+	// zipf in range with the lowest rank the most frequent
+	uint32_t ranks[100] = {0};
+	workload_zipf(a, count, 10, 100, 1.2);
+	for(uint32_t i = 0; ok && i < count; ++i)
+		ok = a[i] < 100 && ++ranks[a[i]];
+	for(uint32_t i = 1; ok && i < 100; ++i)
+		ok = ranks[0] >= ranks[i];
+	ok = ok && ranks[0] > ranks[1] && ranks[1] > ranks[10] && ranks[10] > ranks[99];
+
+	workload_few_unique(a, count, 11, 5);
+	basic_hashtable_t<uint32_t, uint32_t, growable_capacity_t> seen;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		bool inserted;
+		seen.upsert(a[i], 0, inserted);
+	}
+	ok = ok && seen.size == 5;
+	workload_clustered(a, count, 12, 4, 100);
+	seen.clear();
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		bool inserted;
+		seen.upsert(a[i] / 1024, 0, inserted); // offsets stay in a page or two of their center
+	}
+	ok = ok && seen.size <= 8;
+	delete[] a;
+	delete[] b;
+	return ok;
+}
+
+bool verify_test(uint32_t count = 300000)
+{
+	uint32_t * items = new uint32_t[count];
+	workload_sorted(items, count, 1);
+	verifyfingerprint_t before = verify_fingerprint(items, count, 5, 1);
+	bool ok = verify_sorted(items, count, 1) && verify_sorted(items, count, 4);
+
+	// a descent anywhere is found, at both ends, on chunk and thread borders
+	const uint32_t positions[] = {0, 7, 8, 4095, 4096, count / 4 - 1, count / 4, count / 2, count - 2};
+	for(uint32_t i : positions)
+	{
+		uint32_t a = items[i], b = items[i + 1];
+		items[i] = b + 1;
+		items[i + 1] = b;
+		ok = ok && !verify_sorted(items, count, 1) && !verify_sorted(items, count, 4) && !verify_sorted(items + i, 2, 1);
+		items[i] = a;
+		items[i + 1] = b;
+	}
+
+	// any order gives the same fingerprint, for any thread count
+	for(uint32_t i = count - 1; i > 0; --i)
+	{
+		uint32_t j = workload_below(i + 1), t = items[i];
+		items[i] = items[j];
+		items[j] = t;
+	}
+	ok = ok && verify_fingerprint(items, count, 5, 1) == before && verify_fingerprint(items, count, 5, 3) == before;
+	// one item duplicated over another, and two swapped for their neighbours
+	uint32_t kept = items[100];
+	items[100] = items[101];
+	ok = ok && verify_fingerprint(items, count, 5) != before;
+	items[100] = kept;
+	items[200] += 1;
+	items[201] -= 1;
+	ok = ok && verify_fingerprint(items, count, 5) != before && verify_fingerprint(items, count, 6) != before;
+
+	// a sort that drops an item still passes the order check, not the verifier
+	uint32_t values[] = {5, 3, 3, 9, 1};
+	verifier_t verifier(7);
+	verifier.expect(values, 5);
+	uint32_t lost[] = {1, 3, 5, 9, 9};
+	uint32_t sorted[] = {1, 3, 3, 5, 9};
+	ok = ok && verify_sorted(lost, 5) && !verifier.check(lost, 5) && verifier.check(sorted, 5);
+	delete[] items;
+	return ok;
+}
+
+bool search_test()
+{
+	// sizes around one node and one level of nodes, duplicates and both extremes
+	const size_t sizes[] = {0, 1, 2, 15, 16, 17, 272, 289, 1000, 4913, 100000};
+	const size_t query_count = 4000;
+	uint32_t * queries = new uint32_t[query_count];
+	size_t * batched = new size_t[query_count];
+	bool ok = true;
+	for(size_t count : sizes)
+	{
+		uint32_t * items = new uint32_t[count + 1];
+		uint32_t * scratch = new uint32_t[count + 1];
+		workload_uniform(items, count, count, count < 100 ? 8 : (uint32_t)count * 4);
+		if(count > 2)
+		{
+			items[0] = 0;
+			items[1] = UINT32_MAX;
+		}
+		sorts_radixsort_pairs(items, scratch, count);
+		eytzinger_t eytzinger;
+		statictree_t tree;
+		ok = ok && eytzinger.build(items, count) && tree.build(items, count);
+
+		// present keys, their neighbours and misses everywhere
+		workload_uniform(queries, query_count, count + 1, count < 100 ? 10 : (uint32_t)count * 4);
+		for(size_t i = 0; i < query_count / 2 && count; i += 2)
+		{
+			queries[i] = items[i % count];
+			queries[i + 1] = items[i % count] + (i & 2 ? 1 : -1);
+		}
+		queries[0] = 0;
+		queries[1] = UINT32_MAX;
+		eytzinger.lower_bound(queries, query_count, batched);
+		for(size_t i = 0; ok && i < query_count; ++i)
+		{
+			size_t low = 0, high = count;
+			while(low < high)
+			{
+				size_t middle = (low + high) / 2;
+				if(items[middle] < queries[i])
+					low = middle + 1;
+				else
+					high = middle;
+			}
+			ok = eytzinger.lower_bound(queries[i]) == low && batched[i] == low && tree.lower_bound(queries[i]) == low;
+		}
+		tree.lower_bound(queries, query_count - 3, batched);
+		for(size_t i = 0; ok && i < query_count - 3; ++i)
+			ok = batched[i] == tree.lower_bound(queries[i]);
+		delete[] items;
+		delete[] scratch;
+	}
+	delete[] queries;
+	delete[] batched;
+	return ok;
+}
+
+bool sets_test()
+{
+	// sorted duplicate free lists from bounded draws, the bound sets the overlap
+	const uint32_t sizes[][2] = {{0, 0}, {0, 50}, {7, 9}, {100, 100}, {1000, 1300}, {20, 5000}, {5000, 40}, {30000, 30000}, {3, 200000}};
+	const uint32_t most = 200000 + 30000;
+	uint32_t * a = new uint32_t[most], * b = new uint32_t[most], * scratch = new uint32_t[most];
+	uint32_t * expected = new uint32_t[most * 2], * out = new uint32_t[most * 2];
+	bool ok = true;
+	for(uint32_t round = 0; round < 3; ++round)
+		for(const auto & size : sizes)
+		{
+			uint32_t bound = (size[0] + size[1]) * (round + 1) + 8;
+			workload_uniform(a, size[0], round * 2, bound);
+			workload_uniform(b, size[1], round * 2 + 1, bound);
+			sorts_radixsort_pairs(a, scratch, size[0]);
+			sorts_radixsort_pairs(b, scratch, size[1]);
+			// in place, then against a plain loop
+			size_t a_count = sets_unique(a, size[0], a), b_count = sets_unique(b, size[1], scratch);
+			memcpy(b, scratch, b_count * sizeof(uint32_t));
+			for(size_t i = 1; ok && i < a_count; ++i)
+				ok = a[i - 1] < a[i];
+
+			size_t count = sets_intersect_merge(a, a_count, b, b_count, expected);
+			ok = ok && sets_intersect_simd(a, a_count, b, b_count, out) == count && !memcmp(out, expected, count * sizeof(uint32_t));
+			ok = ok && sets_intersect_gallop(a, a_count, b, b_count, out) == count && !memcmp(out, expected, count * sizeof(uint32_t));
+			ok = ok && sets_intersect(b, b_count, a, a_count, out) == count && !memcmp(out, expected, count * sizeof(uint32_t));
+
+			// union and difference checked through each other: a | b = (a - b) + b
+			size_t difference = sets_difference(a, a_count, b, b_count, expected);
+			ok = ok && difference == a_count - count;
+			size_t all = sets_union(expected, difference, b, b_count, scratch);
+			ok = ok && sets_union(a, a_count, b, b_count, out) == all && !memcmp(out, scratch, all * sizeof(uint32_t));
+			for(size_t i = 1; ok && i < all; ++i)
+				ok = out[i - 1] < out[i];
+			setslist_t lists[] = {{a, a_count}, {b, b_count}, {a, a_count / 2}, {b + b_count / 3, b_count / 3}};
+			ok = ok && sets_union_k(lists, 4, expected) == all && !memcmp(expected, out, all * sizeof(uint32_t));
+		}
+
+	// blocks of b repeating the same items, then the dataset wrappers
+	uint32_t repeated[] = {1, 1, 1, 2, 2, 3, 3, 3, 3, 3, 4, 5, 5, 5, 5, 5, 5, 5, 5, 6, 7, 7};
+	ok = ok && sets_unique(repeated, 22, repeated) == 7 && repeated[6] == 7;
+	dataset_t x = {1, 3, 5, 7, 9, 11, 13, 15, 17, 19}, y = {2, 3, 4, 5, 17, 19, 21};
+	dataset_t both = sets_intersect(x, y), either = sets_union(x, y), only = sets_difference(x, y);
+	dataset_t twice = {4, 4, 8, 8, 8, 9};
+	sets_unique(twice);
+	ok = ok && both.count == 4 && both.items[3] == 19 && either.count == 13 && only.count == 6 && only.items[5] == 15 && twice.count == 3;
+	delete[] a;
+	delete[] b;
+	delete[] scratch;
+	delete[] expected;
+	delete[] out;
+	return ok;
+}
+
+bool column_test()
+{
+	// around one block, duplicates, runs that need no bits and gaps that need all 32
+	const size_t sizes[] = {0, 1, 127, 128, 129, 1000, 100000};
+	const uint32_t gaps[] = {1, 3, 40, 40000, UINT32_MAX};
+	bool ok = true;
+	for(size_t count : sizes)
+		for(uint32_t gap : gaps)
+		{
+			uint32_t * items = new uint32_t[count + 1];
+			uint32_t * decoded = new uint32_t[count + 1];
+			workload_uniform(items, count, count ^ gap, gap);
+			uint32_t sum = 0;
+			for(size_t i = 0; i < count; ++i)
+			{
+				// the largest gap only once, no sum wraps
+				sum += gap == UINT32_MAX ? (i == count / 2 ? gap : 0) : items[i];
+				items[i] = sum;
+			}
+			column_t column;
+			ok = ok && column.build(items, count);
+			column.decode(decoded);
+			ok = ok && !memcmp(items, decoded, count * sizeof(uint32_t));
+			for(size_t i = 0; ok && i < count; i += 1 + i / 8)
+			{
+				size_t low = 0, high = count;
+				uint32_t key = items[i] + (i & 1);
+				while(low < high)
+				{
+					size_t middle = (low + high) / 2;
+					if(items[middle] < key)
+						low = middle + 1;
+					else
+						high = middle;
+				}
+				ok = column.at(i) == items[i] && column.lower_bound(key) == low && column.contains(items[i]);
+			}
+			ok = ok && column.lower_bound(0) == 0 && (!count || items[count - 1] == UINT32_MAX || column.lower_bound(UINT32_MAX) == count);
+			delete[] items;
+			delete[] decoded;
+		}
+
+	// a small consecutive dataset packs at a bit per value
+	dataset_t data;
+	data.count = 200;
+	for(uint32_t i = 0; i < data.count; ++i)
+		data.items[i] = 1000 + i;
+	column_t column;
+	ok = ok && column.build(data) && column.word_count == 8 && column.at(150) == 1150 && !column.contains(999);
+	return ok;
+}
+
+bool tasks_test()
+{
+	bool ok = true;
+	for(uint32_t threads : {1u, 4u})
+	{
+		taskpool_t pool(threads, threads > 1);
+		// nested spawns all finish before their sync returns
+		std::atomic<uint32_t> done(0);
+		{
+			taskgroup_t group(pool);
+			for(uint32_t i = 0; i < 100; ++i)
+				group.spawn([&]()
+				{
+					taskgroup_t inner(pool);
+					for(uint32_t j = 0; j < 10; ++j)
+						inner.spawn([&]() {done.fetch_add(1);});
+					inner.sync();
+					done.fetch_add(1);
+				});
+			group.sync();
+		}
+		ok = ok && done.load() == 1100;
+
+		// every index exactly once, in chunks no longer than the grain
+		const size_t count = 100003;
+		uint8_t * seen = new uint8_t[count]();
+		std::atomic<bool> small(true);
+		tasks_parallel_for(pool, 0, count, 1000, [&](size_t first, size_t last)
+		{
+			if(last - first > 1000)
+				small.store(false);
+			for(size_t i = first; i < last; ++i)
+				++seen[i];
+		});
+		for(size_t i = 0; ok && i < count; ++i)
+			ok = seen[i] == 1;
+		ok = ok && small.load();
+		delete[] seen;
+		uint32_t a = 0, b = 0;
+		tasks_parallel_invoke(pool, [&]() {a = 1;}, [&]() {b = 2;});
+		ok = ok && a == 1 && b == 2;
+
+		// forked sorts against the dataset versions and against each other
+		for(uint32_t round = 0; ok && round < 50; ++round)
+		{
+			dataset_t data = dataset_t::random();
+			data.items[0] = data.items[data.count / 2];
+			uint32_t items[3][256];
+			for(uint32_t sort = 0; sort < 3; ++sort)
+				memcpy(items[sort], data.items, data.count * sizeof(uint32_t));
+			sorts_quicksort(items[0], data.count, pool, 8);
+			sorts_mergesort(items[1], data.count, pool, 8);
+			sorts_bitonicsort(items[2], data.count, pool, 8);
+			sorts_quicksort(data);
+			for(uint32_t sort = 0; sort < 3; ++sort)
+				ok = ok && !memcmp(items[sort], data.items, data.count * sizeof(uint32_t));
+		}
+		const size_t large = 300000;
+		uint32_t * items = new uint32_t[large];
+		// uniform, all equal and four distinct keys, equal runs must not make quicksort quadratic
+		for(uint32_t input = 0; ok && input < 3; ++input)
+		{
+			for(uint32_t sort = 0; ok && sort < 3; ++sort)
+			{
+				if(input == 0)
+					workload_uniform(items, large, sort, sort ? 0 : 1000);
+				else
+					workload_few_unique(items, large, sort, input == 1 ? 1 : 4);
+				verifier_t verifier(sort);
+				verifier.expect(items, large);
+				if(sort == 0)
+					sorts_quicksort(items, large, pool, 1000);
+				else if(sort == 1)
+					sorts_mergesort(items, large, pool, 1000);
+				else
+					sorts_bitonicsort(items, large, pool, 1000);
+				ok = verifier.check(items, large);
+			}
+		}
+		// already sorted input stays shallow with the median pivot
+		sorts_quicksort(items, large, pool, 1000);
+		ok = ok && verify_sorted(items, large);
+		delete[] items;
+	}
+	return ok;
+}
+
+bool cache_test()
+{
+	bool ok = true;
+	uint32_t value = 0;
+
+	// lru: a hit protects 1, so 2 is the oldest when 4 comes in
+	cache_t lru(3, cachepolicy_lru);
+	for(uint32_t key = 1; key <= 3; ++key)
+		lru.put(key, key * 10);
+	ok = ok && lru.get(1, value) && value == 10;
+	lru.put(4, 40);
+	ok = ok && !lru.contains(2) && lru.contains(1) && lru.contains(3) && lru.contains(4);
+	// updates count as use too
+	lru.put(3, 31);
+	lru.put(5, 50);
+	ok = ok && !lru.contains(1) && lru.get(3, value) && value == 31;
+	ok = ok && lru.counters.hits == 2 && lru.counters.misses == 0 && lru.counters.evictions == 2;
+	ok = ok && !lru.get(1, value) && lru.counters.misses == 1;
+
+	// clock and sieve: 1 and 2 get a second chance so 3 goes, then 4 under the hand
+	// after that clock has put 5 behind the hand and takes 1, sieve put 5 at the back and takes it
+	for(cachepolicy_t policy : {cachepolicy_clock, cachepolicy_sieve})
+	{
+		cache_t cache(4, policy);
+		for(uint32_t key = 1; key <= 4; ++key)
+			cache.put(key, key);
+		ok = ok && cache.get(1, value) && cache.get(2, value);
+		cache.put(5, 5);
+		ok = ok && !cache.contains(3) && cache.contains(1) && cache.contains(2);
+		cache.put(6, 6);
+		ok = ok && !cache.contains(4);
+		cache.put(7, 7);
+		if(policy == cachepolicy_sieve)
+			ok = ok && !cache.contains(5) && cache.contains(1);
+		else
+			ok = ok && cache.contains(5) && !cache.contains(1);
+		ok = ok && cache.contains(6) && cache.contains(7) && cache.count == 4 && cache.counters.evictions == 3;
+		// removing under the hand moves it along
+		cache.remove(cache.list.value(cache.hand));
+		cache.put(8, 8);
+		ok = ok && cache.count == 4 && cache.counters.evictions == 3 && cache.contains(8);
+	}
+
+	// never more than capacity, every present key maps back to its own value
+	for(cachepolicy_t policy : {cachepolicy_lru, cachepolicy_clock, cachepolicy_sieve})
+	{
+		cache_t cache(100, policy);
+		workload_seed(policy);
+		for(uint32_t i = 0; ok && i < 20000; ++i)
+		{
+			uint32_t key = workload_next() % 300;
+			if(!cache.get(key, value))
+				cache.put(key, key + 1);
+			else
+				ok = value == key + 1;
+			if(i % 97 == 0)
+				cache.remove(workload_next() % 300);
+			ok = ok && cache.count <= 100 && cache.table.size == cache.count;
+		}
+		uint32_t present = 0;
+		for(uint32_t key = 0; key < 300; ++key)
+			present += cache.contains(key);
+		ok = ok && present == cache.count;
+		cache.clear();
+		ok = ok && !cache.count && !cache.table.size && cache.list.last() == cache_t::invalid;
+	}
+
+	// sharded, threads on their own key ranges see their own values
+	shardedcache_t sharded(1 << 12, cachepolicy_sieve, 8);
+	std::atomic<bool> right(true);
+	containers_parallel(4, [&](uint32_t t)
+	{
+		for(uint32_t i = 0; i < 20000; ++i)
+		{
+			uint32_t key = t << 16 | (i * 7919) % 2000;
+			uint32_t found = 0;
+			if(!sharded.get(key, found))
+				sharded.put(key, key ^ 0x5555);
+			else if(found != (key ^ 0x5555))
+				right.store(false);
+		}
+	});
+	cachecounters_t counters = sharded.counters();
+	ok = ok && right.load() && counters.hits + counters.misses == 80000 && counters.hits > 0;
+	return ok;
+}
+
+bool stringsort_test()
+{
+	bool ok = true;
+	// bytes that sort around each other signed and unsigned, and a zero byte
+	const char alphabet[] = {'a', 'b', 0, (char)0xff, (char)0x80};
+	char * chars = (char*)malloc(1 << 22);
+	taskpool_t pool(4);
+	for(size_t count : {0, 1, 2, 17, 65, 1000, 30000})
+	{
+		// half the keys behind a shared prefix longer than the 8 byte steps, some of them ending right after it
+		stringkey_t * keys = (stringkey_t*)malloc(count * sizeof(stringkey_t) + 1);
+		stringkey_t * expected = (stringkey_t*)malloc(count * sizeof(stringkey_t) + 1);
+		stringkey_t * items = (stringkey_t*)malloc(count * sizeof(stringkey_t) + 1);
+		workload_seed(count);
+		size_t used = 0;
+		for(size_t i = 0; i < count; ++i)
+		{
+			uint32_t prefix = workload_below(2) ? 75 : 0;
+			uint32_t length = prefix + workload_below(i % 3 ? 12 : 40);
+			for(uint32_t j = 0; j < length; ++j)
+				chars[used + j] = j < prefix ? 'x' : alphabet[workload_below(j < prefix + 3 ? 2 : 5)];
+			keys[i] = {chars + used, length};
+			used += length;
+		}
+		memcpy(expected, keys, count * sizeof(stringkey_t));
+		qsort(expected, count, sizeof(stringkey_t), [](const void * a, const void * b)
+		{
+			return stringsort_compare(*(const stringkey_t*)a, *(const stringkey_t*)b);
+		});
+		for(uint32_t sort = 0; ok && sort < 4; ++sort)
+		{
+			memcpy(items, keys, count * sizeof(stringkey_t));
+			if(sort == 0)
+				stringsort_radix(items, count);
+			else if(sort == 1)
+				stringsort_multikey(items, count);
+			else
+				// small grains so the parallel split recurses a few levels
+				stringsort_radix(items, count, pool, sort == 2 ? 100 : 5000);
+			ok = stringsort_sorted(items, count);
+			for(size_t i = 0; ok && i < count; ++i)
+				ok = !stringsort_compare(items[i], expected[i]);
+		}
+		free(keys);
+		free(expected);
+		free(items);
+	}
+
+	// identical and empty keys, a proper prefix sorts first
+	const char * words[] = {"ab", "", "abc", "ab", "a", "", "b", "abc"};
+	stringkey_t small[8];
+	for(uint32_t i = 0; i < 8; ++i)
+		small[i] = {words[i], (uint32_t)strlen(words[i])};
+	stringsort_multikey(small, 8);
+	const char * order[] = {"", "", "a", "ab", "ab", "abc", "abc", "b"};
+	for(uint32_t i = 0; i < 8; ++i)
+		ok = ok && small[i].length == strlen(order[i]) && !memcmp(small[i].chars, order[i], small[i].length);
+	free(chars);
+	return ok;
+}
+
+bool stats_test()
+{
+	stats_reset();
+	hashtable_t table;
+	for(uint32_t i = 0; i < 100; ++i)
+		table.set(i, i);
+	for(uint32_t i = 0; i < 200; ++i)
+		table.contains(i);
+	dataset_t data = dataset_t::random(200);
+	sorts_quicksort(data);
+
+	statsvalues_t values;
+	stats_collect(values);
+	bool counted = values.counters[stats_hashtable_lookups] == 300 &&
+				   values.counters[stats_hashtable_probes] >= 300 &&
+				   values.counters[stats_sorts_compares] > 0 &&
+				   values.timer_calls[stats_timer_hashtable_set] == 100 &&
+				   values.timer_calls[stats_timer_sort] == 1;
+	bool silent = !values.counters[stats_hashtable_lookups] && !values.timer_calls[stats_timer_sort];
+	if(stats_enabled ? !counted : !silent)
+		return false;
+
+	char * text = nullptr;
+	size_t size = 0;
+	FILE * f = open_memstream(&text, &size);
+	stats_write_json(f);
+	stats_write_prometheus(f);
+	fclose(f);
+	bool ok = strstr(text, "\"hashtable_probes\": ") && strstr(text, "letslearn_sorts_swaps_total ");
+	free(text);
+	return ok;
+}
+
+int main(int argc, char ** argv)
+{
+	if(argc > 1 && !strcmp(argv[1], "bench"))
+	{
+		// all of them, or only the one named after "bench"
+		static const struct {const char * name; void (*run)();} benches[] =
+		{
+			{"cuckoofilter", []() {bench_cuckoofilter();}},
+			{"radixtree", []() {bench_radixtree();}},
+			{"spatial", []() {bench_spatial();}},
+			{"rtree", []() {bench_rtree();}},
+			{"graph", []() {bench_graph();}},
+			{"containers", []() {bench_containers();}},
+			{"join", []() {bench_join();}},
+			{"aggregate", []() {bench_aggregate();}},
+			{"workload", []() {bench_workload();}},
+			{"verify", []() {bench_verify();}},
+			{"percentile", []() {bench_percentile();}},
+			{"search", []() {bench_search();}},
+			{"sets", []() {bench_sets();}},
+			{"column", []() {bench_column();}},
+			{"tasks", []() {bench_tasks();}},
+			{"cache", []() {bench_cache();}},
+			{"stringsort", []() {bench_stringsort();}},
+		};
+		for(const auto & bench : benches)
+			if(argc < 3 || !strcmp(argv[2], bench.name))
+				bench.run();
+		return 0;
+	}
+
 	#if 1
 	assert(sorts_test(&sorts_bubble));
 	assert(sorts_test(&sorts_quicksort));
@@ -74,7 +1195,32 @@ int main()
 
 	assert(linkedlist_test());
 	assert(hashtable_test());
+	assert(hashtable_filter_test());
+	assert(bloomfilter_test());
+	assert(bloomfilter_test<bloomfilter512_t>());
+	assert(cuckoofilter_test(4096, 8));
+	assert(cuckoofilter_test(4096, 12));
+	assert(cuckoofilter_test(4096, 16));
 	assert(rbtree_test());
+	assert(rbtree_order_test());
+	assert(containers_template_test());
+	assert(radixtree_test());
+	assert(spatial_test<kdtree_t>());
+	assert(spatial_test<quadtree_t>());
+	assert(rtree_test());
+	assert(graph_test());
+	assert(snapshot_test());
+	assert(stats_test());
+	assert(join_test());
+	assert(aggregate_test());
+	assert(workload_test());
+	assert(verify_test());
+	assert(search_test());
+	assert(sets_test());
+	assert(column_test());
+	assert(tasks_test());
+	assert(cache_test());
+	assert(stringsort_test());
 	#endif
 
 	//for(size_t i = 0; i < 1000; ++i)
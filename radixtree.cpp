@@ -0,0 +1,596 @@
+#include "radixtree.h"
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+template<typename node_t>
+radixtree_t::pool_t<node_t>::~pool_t()
+{
+	free(arr);
+	free(free_slots);
+}
+
+template<typename node_t>
+uint32_t radixtree_t::pool_t<node_t>::allocate()
+{
+	if(free_count)
+		return free_slots[--free_count];
+	if(size == capacity)
+	{
+		capacity = capacity ? capacity * 2 : 16;
+		arr = (node_t*)realloc(arr, capacity * sizeof(node_t));
+	}
+	return size++;
+}
+
+template<typename node_t>
+void radixtree_t::pool_t<node_t>::deallocate(uint32_t index)
+{
+	if(free_count == free_capacity)
+	{
+		free_capacity = free_capacity ? free_capacity * 2 : 16;
+		free_slots = (uint32_t*)realloc(free_slots, free_capacity * sizeof(uint32_t));
+	}
+	free_slots[free_count++] = index;
+}
+
+template struct radixtree_t::pool_t<radixtree_t::leaf_t>;
+template struct radixtree_t::pool_t<radixtree_t::node4_t>;
+template struct radixtree_t::pool_t<radixtree_t::node16_t>;
+template struct radixtree_t::pool_t<radixtree_t::node48_t>;
+template struct radixtree_t::pool_t<radixtree_t::node256_t>;
+
+radixtree_t::header_t & radixtree_t::header(uint32_t ref)
+{
+	return const_cast<header_t&>(static_cast<const radixtree_t*>(this)->header(ref));
+}
+
+const radixtree_t::header_t & radixtree_t::header(uint32_t ref) const
+{
+	switch(type(ref))
+	{
+	case node4: return nodes4.arr[index(ref)].header;
+	case node16: return nodes16.arr[index(ref)].header;
+	case node48: return nodes48.arr[index(ref)].header;
+	default: assert(type(ref) == node256); return nodes256.arr[index(ref)].header;
+	}
+}
+
+uint32_t radixtree_t::prefix_mismatch(const header_t & h, uint64_t key, uint32_t depth) const
+{
+	uint32_t i = 0;
+	while(i < h.prefix_length && h.prefix[i] == key_byte(key, depth + i))
+		++i;
+	return i;
+}
+
+static inline uint32_t node16_find(const uint8_t * keys, uint32_t count, uint8_t byte)
+{
+	#if defined(__SSE2__)
+	__m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)byte), _mm_load_si128((const __m128i*)keys));
+	uint32_t mask = (uint32_t)_mm_movemask_epi8(cmp) & ((1u << count) - 1);
+	return mask ? (uint32_t)__builtin_ctz(mask) : count;
+	#else
+	for(uint32_t i = 0; i < count; ++i)
+		if(keys[i] == byte)
+			return i;
+	return count;
+	#endif
+}
+
+static inline uint32_t node16_lower_bound(const uint8_t * keys, uint32_t count, uint8_t byte)
+{
+	#if defined(__SSE2__)
+	// signed compare only, flip the top bit to order bytes unsigned
+	const __m128i flip = _mm_set1_epi8((char)0x80);
+	__m128i cmp = _mm_cmplt_epi8(_mm_xor_si128(_mm_load_si128((const __m128i*)keys), flip),
+								 _mm_xor_si128(_mm_set1_epi8((char)byte), flip));
+	return (uint32_t)__builtin_popcount((uint32_t)_mm_movemask_epi8(cmp) & ((1u << count) - 1));
+	#else
+	uint32_t i = 0;
+	while(i < count && keys[i] < byte)
+		++i;
+	return i;
+	#endif
+}
+
+uint32_t radixtree_t::find_child(uint32_t ref, uint8_t byte) const
+{
+	switch(type(ref))
+	{
+	case node4:
+	{
+		const node4_t & node = nodes4.arr[index(ref)];
+		for(uint32_t i = 0; i < node.header.count; ++i)
+			if(node.keys[i] == byte)
+				return node.children[i];
+		return invalid;
+	}
+	case node16:
+	{
+		const node16_t & node = nodes16.arr[index(ref)];
+		uint32_t i = node16_find(node.keys, node.header.count, byte);
+		return i < node.header.count ? node.children[i] : invalid;
+	}
+	case node48:
+	{
+		const node48_t & node = nodes48.arr[index(ref)];
+		return node.child_index[byte] != node48_t::empty ? node.children[node.child_index[byte]] : invalid;
+	}
+	case node256:
+		return nodes256.arr[index(ref)].children[byte];
+	default:
+		return invalid;
+	}
+}
+
+void radixtree_t::replace_child(uint32_t ref, uint8_t byte, uint32_t child)
+{
+	if(ref == invalid)
+	{
+		root = child;
+		return;
+	}
+	switch(type(ref))
+	{
+	case node4:
+	{
+		node4_t & node = nodes4.arr[index(ref)];
+		for(uint32_t i = 0; i < node.header.count; ++i)
+			if(node.keys[i] == byte)
+				node.children[i] = child;
+		break;
+	}
+	case node16:
+	{
+		node16_t & node = nodes16.arr[index(ref)];
+		node.children[node16_find(node.keys, node.header.count, byte)] = child;
+		break;
+	}
+	case node48:
+	{
+		node48_t & node = nodes48.arr[index(ref)];
+		node.children[node.child_index[byte]] = child;
+		break;
+	}
+	default:
+		nodes256.arr[index(ref)].children[byte] = child;
+	}
+}
+
+uint32_t radixtree_t::add_child(uint32_t ref, uint8_t byte, uint32_t child)
+{
+	switch(type(ref))
+	{
+	case node4:
+	{
+		node4_t * node = &nodes4.arr[index(ref)];
+		if(node->header.count < 4)
+		{
+			uint32_t i = node->header.count++;
+			for(; i > 0 && node->keys[i - 1] > byte; --i)
+			{
+				node->keys[i] = node->keys[i - 1];
+				node->children[i] = node->children[i - 1];
+			}
+			node->keys[i] = byte;
+			node->children[i] = child;
+			return ref;
+		}
+		uint32_t grown = nodes16.allocate();
+		node = &nodes4.arr[index(ref)];
+		node16_t & bigger = nodes16.arr[grown];
+		bigger.header = node->header;
+		memcpy(bigger.keys, node->keys, 4);
+		memcpy(bigger.children, node->children, 4 * sizeof(uint32_t));
+		nodes4.deallocate(index(ref));
+		return add_child(radixtree_t::ref(node16, grown), byte, child);
+	}
+	case node16:
+	{
+		node16_t * node = &nodes16.arr[index(ref)];
+		uint32_t count = node->header.count;
+		if(count < 16)
+		{
+			uint32_t i = node16_lower_bound(node->keys, count, byte);
+			memmove(node->keys + i + 1, node->keys + i, count - i);
+			memmove(node->children + i + 1, node->children + i, (count - i) * sizeof(uint32_t));
+			node->keys[i] = byte;
+			node->children[i] = child;
+			++node->header.count;
+			return ref;
+		}
+		uint32_t grown = nodes48.allocate();
+		node = &nodes16.arr[index(ref)];
+		node48_t & bigger = nodes48.arr[grown];
+		bigger.header = node->header;
+		memset(bigger.child_index, node48_t::empty, sizeof(bigger.child_index));
+		for(uint32_t i = 0; i < 48; ++i)
+			bigger.children[i] = invalid;
+		for(uint32_t i = 0; i < 16; ++i)
+		{
+			bigger.child_index[node->keys[i]] = (uint8_t)i;
+			bigger.children[i] = node->children[i];
+		}
+		nodes16.deallocate(index(ref));
+		return add_child(radixtree_t::ref(node48, grown), byte, child);
+	}
+	case node48:
+	{
+		node48_t * node = &nodes48.arr[index(ref)];
+		if(node->header.count < 48)
+		{
+			uint32_t slot = 0;
+			while(node->children[slot] != invalid)
+				++slot;
+			node->child_index[byte] = (uint8_t)slot;
+			node->children[slot] = child;
+			++node->header.count;
+			return ref;
+		}
+		uint32_t grown = nodes256.allocate();
+		node = &nodes48.arr[index(ref)];
+		node256_t & bigger = nodes256.arr[grown];
+		bigger.header = node->header;
+		for(uint32_t i = 0; i < 256; ++i)
+			bigger.children[i] = node->child_index[i] != node48_t::empty ? node->children[node->child_index[i]] : invalid;
+		nodes48.deallocate(index(ref));
+		return add_child(radixtree_t::ref(node256, grown), byte, child);
+	}
+	default:
+	{
+		node256_t & node = nodes256.arr[index(ref)];
+		node.children[byte] = child;
+		++node.header.count;
+		return ref;
+	}
+	}
+}
+
+uint32_t radixtree_t::remove_child(uint32_t ref, uint8_t byte)
+{
+	switch(type(ref))
+	{
+	case node4:
+	{
+		node4_t * node = &nodes4.arr[index(ref)];
+		uint32_t i = 0;
+		while(node->keys[i] != byte)
+			++i;
+		for(--node->header.count; i < node->header.count; ++i)
+		{
+			node->keys[i] = node->keys[i + 1];
+			node->children[i] = node->children[i + 1];
+		}
+		if(node->header.count > 1)
+			return ref;
+
+		// single child left, merge this node into it
+		uint32_t child = node->children[0];
+		if(type(child) != leaf)
+		{
+			header_t & h = header(child);
+			uint8_t prefix[8];
+			uint32_t length = node->header.prefix_length;
+			memcpy(prefix, node->header.prefix, length);
+			prefix[length++] = node->keys[0];
+			memcpy(prefix + length, h.prefix, h.prefix_length);
+			h.prefix_length = (uint8_t)(length + h.prefix_length);
+			assert(h.prefix_length <= 8);
+			memcpy(h.prefix, prefix, h.prefix_length);
+		}
+		nodes4.deallocate(index(ref));
+		return child;
+	}
+	case node16:
+	{
+		node16_t * node = &nodes16.arr[index(ref)];
+		uint32_t i = node16_find(node->keys, node->header.count, byte);
+		uint32_t count = --node->header.count;
+		memmove(node->keys + i, node->keys + i + 1, count - i);
+		memmove(node->children + i, node->children + i + 1, (count - i) * sizeof(uint32_t));
+		if(count > 3)
+			return ref;
+		uint32_t shrunk = nodes4.allocate();
+		node = &nodes16.arr[index(ref)];
+		node4_t & smaller = nodes4.arr[shrunk];
+		smaller.header = node->header;
+		memcpy(smaller.keys, node->keys, count);
+		memcpy(smaller.children, node->children, count * sizeof(uint32_t));
+		nodes16.deallocate(index(ref));
+		return radixtree_t::ref(node4, shrunk);
+	}
+	case node48:
+	{
+		node48_t * node = &nodes48.arr[index(ref)];
+		node->children[node->child_index[byte]] = invalid;
+		node->child_index[byte] = node48_t::empty;
+		if(--node->header.count > 12)
+			return ref;
+		uint32_t shrunk = nodes16.allocate();
+		node = &nodes48.arr[index(ref)];
+		node16_t & smaller = nodes16.arr[shrunk];
+		smaller.header = node->header;
+		uint32_t j = 0;
+		for(uint32_t i = 0; i < 256; ++i)
+			if(node->child_index[i] != node48_t::empty)
+			{
+				smaller.keys[j] = (uint8_t)i;
+				smaller.children[j++] = node->children[node->child_index[i]];
+			}
+		nodes48.deallocate(index(ref));
+		return radixtree_t::ref(node16, shrunk);
+	}
+	default:
+	{
+		node256_t * node = &nodes256.arr[index(ref)];
+		node->children[byte] = invalid;
+		if(--node->header.count > 37)
+			return ref;
+		uint32_t shrunk = nodes48.allocate();
+		node = &nodes256.arr[index(ref)];
+		node48_t & smaller = nodes48.arr[shrunk];
+		smaller.header = node->header;
+		memset(smaller.child_index, node48_t::empty, sizeof(smaller.child_index));
+		for(uint32_t i = 0; i < 48; ++i)
+			smaller.children[i] = invalid;
+		uint32_t j = 0;
+		for(uint32_t i = 0; i < 256; ++i)
+			if(node->children[i] != invalid)
+			{
+				smaller.child_index[i] = (uint8_t)j;
+				smaller.children[j++] = node->children[i];
+			}
+		nodes256.deallocate(index(ref));
+		return radixtree_t::ref(node48, shrunk);
+	}
+	}
+}
+
+uint32_t radixtree_t::new_leaf(uint64_t key, uint32_t value)
+{
+	uint32_t i = leaves.allocate();
+	leaves.arr[i].key = key;
+	leaves.arr[i].value = value;
+	++count;
+	return ref(leaf, i);
+}
+
+uint32_t radixtree_t::find_leaf(uint64_t key) const
+{
+	uint32_t node = root;
+	uint32_t depth = 0;
+	while(node != invalid)
+	{
+		if(type(node) == leaf)
+			return leaves.arr[index(node)].key == key ? node : invalid;
+		// leaves keep the whole key, so prefixes are skipped here
+		// and a mismatch is caught by the final compare
+		depth += header(node).prefix_length;
+		node = find_child(node, key_byte(key, depth++));
+	}
+	return invalid;
+}
+
+uint32_t radixtree_t::get(uint64_t key) const
+{
+	uint32_t node = find_leaf(key);
+	return node != invalid ? leaves.arr[index(node)].value : invalid;
+}
+
+void radixtree_t::set(uint64_t key, uint32_t value)
+{
+	uint32_t parent = invalid, node = root, depth = 0;
+	uint8_t parent_byte = 0;
+	while(node != invalid)
+	{
+		if(type(node) == leaf)
+		{
+			uint64_t other = leaves.arr[index(node)].key;
+			if(other == key)
+			{
+				leaves.arr[index(node)].value = value;
+				return;
+			}
+
+			// lazy expansion ends here, both keys get a node of their own
+			uint32_t split = nodes4.allocate();
+			header_t & h = nodes4.arr[split].header;
+			h = header_t();
+			while(key_byte(key, depth + h.prefix_length) == key_byte(other, depth + h.prefix_length))
+			{
+				h.prefix[h.prefix_length] = key_byte(key, depth + h.prefix_length);
+				++h.prefix_length;
+			}
+			uint32_t split_depth = depth + h.prefix_length;
+			uint32_t split_ref = ref(node4, split);
+			add_child(split_ref, key_byte(other, split_depth), node);
+			add_child(split_ref, key_byte(key, split_depth), new_leaf(key, value));
+			replace_child(parent, parent_byte, split_ref);
+			return;
+		}
+
+		header_t & h = header(node);
+		uint32_t mismatch = prefix_mismatch(h, key, depth);
+		if(mismatch < h.prefix_length)
+		{
+			// key leaves the compressed path, split the prefix
+			uint8_t node_byte = h.prefix[mismatch];
+			uint32_t split = nodes4.allocate();
+			header_t & old_header = header(node);
+			header_t & split_header = nodes4.arr[split].header;
+			split_header = header_t();
+			split_header.prefix_length = (uint8_t)mismatch;
+			memcpy(split_header.prefix, old_header.prefix, mismatch);
+			old_header.prefix_length = (uint8_t)(old_header.prefix_length - mismatch - 1);
+			memmove(old_header.prefix, old_header.prefix + mismatch + 1, old_header.prefix_length);
+
+			uint32_t split_ref = ref(node4, split);
+			add_child(split_ref, node_byte, node);
+			add_child(split_ref, key_byte(key, depth + mismatch), new_leaf(key, value));
+			replace_child(parent, parent_byte, split_ref);
+			return;
+		}
+
+		depth += h.prefix_length;
+		uint8_t byte = key_byte(key, depth);
+		uint32_t child = find_child(node, byte);
+		if(child == invalid)
+		{
+			uint32_t leaf_ref = new_leaf(key, value);
+			uint32_t grown = add_child(node, byte, leaf_ref);
+			if(grown != node)
+				replace_child(parent, parent_byte, grown);
+			return;
+		}
+		parent = node;
+		parent_byte = byte;
+		node = child;
+		++depth;
+	}
+	root = new_leaf(key, value);
+}
+
+bool radixtree_t::remove(uint64_t key)
+{
+	uint32_t grandparent = invalid, parent = invalid, node = root, depth = 0;
+	uint8_t grandparent_byte = 0, parent_byte = 0;
+	while(node != invalid)
+	{
+		if(type(node) == leaf)
+		{
+			if(leaves.arr[index(node)].key != key)
+				return false;
+			if(parent == invalid)
+				root = invalid;
+			else
+			{
+				uint32_t shrunk = remove_child(parent, parent_byte);
+				if(shrunk != parent)
+					replace_child(grandparent, grandparent_byte, shrunk);
+			}
+			leaves.deallocate(index(node));
+			--count;
+			return true;
+		}
+		const header_t & h = header(node);
+		if(prefix_mismatch(h, key, depth) != h.prefix_length)
+			return false;
+		depth += h.prefix_length;
+		grandparent = parent;
+		grandparent_byte = parent_byte;
+		parent = node;
+		parent_byte = key_byte(key, depth++);
+		node = find_child(node, parent_byte);
+	}
+	return false;
+}
+
+void radixtree_t::clear()
+{
+	leaves.clear();
+	nodes4.clear();
+	nodes16.clear();
+	nodes48.clear();
+	nodes256.clear();
+	root = invalid;
+	count = 0;
+}
+
+size_t radixtree_t::memory() const
+{
+	return leaves.memory() + nodes4.memory() + nodes16.memory() + nodes48.memory() + nodes256.memory();
+}
+
+bool radixtree_t::scan(uint32_t node, uint32_t depth, uint64_t path, uint64_t lo, uint64_t hi,
+					   bool (*visit)(uint64_t, uint32_t, void *), void * user) const
+{
+	if(type(node) == leaf)
+	{
+		const leaf_t & l = leaves.arr[index(node)];
+		return l.key < lo || l.key > hi || visit(l.key, l.value, user);
+	}
+
+	const header_t & h = header(node);
+	for(uint32_t i = 0; i < h.prefix_length; ++i)
+		path |= (uint64_t)h.prefix[i] << (56 - 8 * (depth + i));
+	depth += h.prefix_length;
+
+	// every key below a child shares the bytes above it,
+	// skip children whose whole key range is outside of lo..hi
+	uint64_t below = depth < 7 ? ~0ull >> (8 * (depth + 1)) : 0;
+	auto child = [&](uint32_t byte, uint32_t child_ref) -> bool
+	{
+		uint64_t first = path | (uint64_t)byte << (56 - 8 * depth);
+		if(first + below < lo || first > hi)
+			return true;
+		return scan(child_ref, depth + 1, first, lo, hi, visit, user);
+	};
+
+	switch(type(node))
+	{
+	case node4:
+	{
+		const node4_t & n = nodes4.arr[index(node)];
+		for(uint32_t i = 0; i < n.header.count; ++i)
+			if(!child(n.keys[i], n.children[i]))
+				return false;
+		return true;
+	}
+	case node16:
+	{
+		const node16_t & n = nodes16.arr[index(node)];
+		for(uint32_t i = 0; i < n.header.count; ++i)
+			if(!child(n.keys[i], n.children[i]))
+				return false;
+		return true;
+	}
+	case node48:
+	{
+		const node48_t & n = nodes48.arr[index(node)];
+		for(uint32_t i = 0; i < 256; ++i)
+			if(n.child_index[i] != node48_t::empty && !child(i, n.children[n.child_index[i]]))
+				return false;
+		return true;
+	}
+	default:
+	{
+		const node256_t & n = nodes256.arr[index(node)];
+		for(uint32_t i = 0; i < 256; ++i)
+			if(n.children[i] != invalid && !child(i, n.children[i]))
+				return false;
+		return true;
+	}
+	}
+}
+
+void radixtree_t::scan(uint64_t lo, uint64_t hi, bool (*visit)(uint64_t, uint32_t, void *), void * user) const
+{
+	if(root != invalid && lo <= hi)
+		scan(root, 0, 0, lo, hi, visit, user);
+}
+
+size_t radixtree_t::range(uint64_t lo, uint64_t hi, uint64_t * keys, uint32_t * values, size_t max) const
+{
+	struct output_t
+	{
+		uint64_t * keys;
+		uint32_t * values;
+		size_t max;
+		size_t size;
+	} output = {keys, values, max, 0};
+	if(!max)
+		return 0;
+	scan(lo, hi, [](uint64_t key, uint32_t value, void * user) -> bool
+	{
+		output_t & out = *(output_t*)user;
+		out.keys[out.size] = key;
+		out.values[out.size] = value;
+		return ++out.size < out.max;
+	}, &output);
+	return output.size;
+}
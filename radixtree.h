@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// adaptive radix tree over 64 bit integer keys
+// keys are split into bytes, most significant first, so in order traversal
+// gives sorted keys. inner nodes grow and shrink between 4, 16, 48 and 256
+// children, common bytes are kept in the node prefix (path compression)
+// and a leaf is stored as soon as its path is unique (lazy expansion)
+struct radixtree_t
+{
+	static const uint32_t invalid = 0xffffffffu;
+
+	// node reference is a type tag in the top 3 bits and an index in its pool
+	enum type_t : uint32_t {leaf = 0, node4 = 1, node16 = 2, node48 = 3, node256 = 4};
+	static uint32_t ref(type_t type, uint32_t index) {return (uint32_t)type << 29 | index;}
+	static type_t type(uint32_t ref) {return (type_t)(ref >> 29);}
+	static uint32_t index(uint32_t ref) {return ref & ((1u << 29) - 1);}
+
+	struct header_t
+	{
+		uint8_t prefix[8];
+		uint8_t prefix_length = 0;
+		uint16_t count = 0;
+	};
+	struct leaf_t
+	{
+		uint64_t key;
+		uint32_t value;
+	};
+	struct node4_t
+	{
+		header_t header;
+		uint8_t keys[4];
+		uint32_t children[4];
+	};
+	struct node16_t
+	{
+		header_t header;
+		alignas(16) uint8_t keys[16];
+		uint32_t children[16];
+	};
+	struct node48_t
+	{
+		static const uint8_t empty = 0xff;
+		header_t header;
+		uint8_t child_index[256];
+		uint32_t children[48];
+	};
+	struct node256_t
+	{
+		header_t header;
+		uint32_t children[256];
+	};
+
+	// growable array of nodes with a stack of released slots
+	template<typename node_t>
+	struct pool_t
+	{
+		node_t * arr = nullptr;
+		uint32_t size = 0;
+		uint32_t capacity = 0;
+		uint32_t * free_slots = nullptr;
+		uint32_t free_count = 0;
+		uint32_t free_capacity = 0;
+
+		~pool_t();
+		uint32_t allocate();
+		void deallocate(uint32_t index);
+		void clear() {size = 0; free_count = 0;}
+		size_t memory() const {return (size_t)capacity * sizeof(node_t) + (size_t)free_capacity * sizeof(uint32_t);}
+	};
+
+	pool_t<leaf_t> leaves;
+	pool_t<node4_t> nodes4;
+	pool_t<node16_t> nodes16;
+	pool_t<node48_t> nodes48;
+	pool_t<node256_t> nodes256;
+	uint32_t root = invalid;
+	size_t count = 0;
+
+	radixtree_t() = default;
+	radixtree_t(const radixtree_t &) = delete;
+	radixtree_t & operator=(const radixtree_t &) = delete;
+
+	// public
+	uint32_t get(uint64_t key) const;
+	void set(uint64_t key, uint32_t value);
+	bool remove(uint64_t key);
+	bool contains(uint64_t key) const {return find_leaf(key) != invalid;}
+	void clear();
+	size_t memory() const;
+
+	// ordered scan of lo <= key <= hi, stops early when visit returns false
+	void scan(uint64_t lo, uint64_t hi, bool (*visit)(uint64_t key, uint32_t value, void * user), void * user) const;
+	// copies up to max pairs in key order, returns how many
+	size_t range(uint64_t lo, uint64_t hi, uint64_t * keys, uint32_t * values, size_t max) const;
+
+	// private
+	static uint8_t key_byte(uint64_t key, uint32_t depth) {return (uint8_t)(key >> (56 - 8 * depth));}
+	uint32_t find_leaf(uint64_t key) const;
+	header_t & header(uint32_t ref);
+	const header_t & header(uint32_t ref) const;
+	uint32_t prefix_mismatch(const header_t & h, uint64_t key, uint32_t depth) const;
+	uint32_t find_child(uint32_t ref, uint8_t byte) const;
+	void replace_child(uint32_t ref, uint8_t byte, uint32_t child);
+	uint32_t add_child(uint32_t ref, uint8_t byte, uint32_t child);
+	uint32_t remove_child(uint32_t ref, uint8_t byte);
+	uint32_t new_leaf(uint64_t key, uint32_t value);
+	bool scan(uint32_t ref, uint32_t depth, uint64_t path, uint64_t lo, uint64_t hi,
+			  bool (*visit)(uint64_t, uint32_t, void *), void * user) const;
+};
@@ -0,0 +1,439 @@
+#include "rtree.h"
+#include "sorts.h"
+#include "file.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <assert.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static inline rtree_t::box_t rtree_union(const rtree_t::box_t & a, const rtree_t::box_t & b)
+{
+	return {a.min_x < b.min_x ? a.min_x : b.min_x, a.min_y < b.min_y ? a.min_y : b.min_y,
+			a.max_x > b.max_x ? a.max_x : b.max_x, a.max_y > b.max_y ? a.max_y : b.max_y};
+}
+
+static inline float rtree_area(const rtree_t::box_t & b)
+{
+	return (b.max_x - b.min_x) * (b.max_y - b.min_y);
+}
+
+static inline float rtree_margin(const rtree_t::box_t & b)
+{
+	return (b.max_x - b.min_x) + (b.max_y - b.min_y);
+}
+
+static inline float rtree_overlap(const rtree_t::box_t & a, const rtree_t::box_t & b)
+{
+	float w = (a.max_x < b.max_x ? a.max_x : b.max_x) - (a.min_x > b.min_x ? a.min_x : b.min_x);
+	float h = (a.max_y < b.max_y ? a.max_y : b.max_y) - (a.min_y > b.min_y ? a.min_y : b.min_y);
+	return w > 0.0f && h > 0.0f ? w * h : 0.0f;
+}
+
+// float bits reordered so unsigned integer order matches float order
+static inline uint32_t rtree_sortable(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+rtree_t::box_t rtree_t::node_t::bounds() const
+{
+	box_t result = {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX};
+	for(uint32_t i = 0; i < count; ++i)
+		result = rtree_union(result, box(i));
+	return result;
+}
+
+void rtree_t::node_t::set(uint32_t i, const box_t & b, uint32_t child)
+{
+	min_x[i] = b.min_x;
+	min_y[i] = b.min_y;
+	max_x[i] = b.max_x;
+	max_y[i] = b.max_y;
+	children[i] = child;
+}
+
+void rtree_t::node_t::clear(uint32_t new_level)
+{
+	for(uint32_t i = 0; i < fanout; ++i)
+		set(i, {FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX}, invalid);
+	count = 0;
+	level = new_level;
+}
+
+rtree_t::~rtree_t()
+{
+	release();
+}
+
+void rtree_t::release()
+{
+	if(!readonly)
+		free(nodes);
+	nodes = nullptr;
+	node_capacity = 0;
+	readonly = false;
+}
+
+void rtree_t::clear()
+{
+	if(readonly)
+		release();
+	node_count = 0;
+	root = invalid;
+	count = 0;
+}
+
+uint32_t rtree_t::allocate(uint32_t level)
+{
+	assert(!readonly);
+	if(node_count == node_capacity)
+	{
+		node_capacity = node_capacity ? node_capacity * 2 : 16;
+		node_t * grown = (node_t*)aligned_alloc(alignof(node_t), node_capacity * sizeof(node_t));
+		if(nodes)
+			memcpy(grown, nodes, node_count * sizeof(node_t));
+		free(nodes);
+		nodes = grown;
+	}
+	nodes[node_count].clear(level);
+	return node_count++;
+}
+
+uint32_t rtree_t::pack(const box_t * boxes, const uint32_t * children, uint32_t size, uint32_t level,
+					   uint32_t * parents, box_t * parent_boxes)
+{
+	// sort-tile-recursive: sort by x, cut into sqrt(nodes) vertical slices,
+	// sort each slice by y and fill nodes from it in order
+	uint32_t * keys = (uint32_t*)malloc(size * sizeof(uint32_t));
+	uint32_t * order = (uint32_t*)malloc(size * sizeof(uint32_t));
+	for(uint32_t i = 0; i < size; ++i)
+	{
+		keys[i] = rtree_sortable((boxes[i].min_x + boxes[i].max_x) * 0.5f);
+		order[i] = i;
+	}
+	sorts_radixsort_pairs(keys, order, size);
+
+	uint32_t node_total = (size + fanout - 1) / fanout;
+	uint32_t slices = (uint32_t)ceil(sqrt((double)node_total));
+	uint32_t slice_size = ((node_total + slices - 1) / slices) * fanout;
+	for(uint32_t first = 0; first < size; first += slice_size)
+	{
+		uint32_t last = first + slice_size < size ? first + slice_size : size;
+		for(uint32_t i = first; i < last; ++i)
+			keys[i] = rtree_sortable((boxes[order[i]].min_y + boxes[order[i]].max_y) * 0.5f);
+		sorts_radixsort_pairs(keys + first, order + first, last - first);
+	}
+
+	uint32_t packed = 0;
+	for(uint32_t first = 0; first < size; first += fanout)
+	{
+		uint32_t node = allocate(level);
+		uint32_t last = first + fanout < size ? first + fanout : size;
+		for(uint32_t i = first; i < last; ++i)
+			nodes[node].set(nodes[node].count++, boxes[order[i]], children ? children[order[i]] : order[i]);
+		parents[packed] = node;
+		parent_boxes[packed++] = nodes[node].bounds();
+	}
+	free(keys);
+	free(order);
+	return packed;
+}
+
+void rtree_t::build(const box_t * boxes, uint32_t size)
+{
+	clear();
+	count = size;
+	if(!size)
+		return;
+
+	// nodes of one level are the entries of the next
+	uint32_t * children = (uint32_t*)malloc(size * sizeof(uint32_t));
+	box_t * child_boxes = (box_t*)malloc(size * sizeof(box_t));
+	uint32_t * parents = (uint32_t*)malloc(size * sizeof(uint32_t));
+	box_t * parent_boxes = (box_t*)malloc(size * sizeof(box_t));
+
+	uint32_t level = 0;
+	uint32_t entries = pack(boxes, nullptr, size, level, parents, parent_boxes);
+	while(entries > 1)
+	{
+		uint32_t * t = children; children = parents; parents = t;
+		box_t * b = child_boxes; child_boxes = parent_boxes; parent_boxes = b;
+		entries = pack(child_boxes, children, entries, ++level, parents, parent_boxes);
+	}
+	root = parents[0];
+
+	free(children);
+	free(child_boxes);
+	free(parents);
+	free(parent_boxes);
+}
+
+uint32_t rtree_t::query(const box_t & box, uint32_t * ids, uint32_t max) const
+{
+	if(root == invalid)
+		return 0;
+
+	uint32_t stack[64 * fanout];
+	uint32_t top = 0, found = 0;
+	stack[top++] = root;
+
+	#if defined(__AVX__)
+	const __m256 q_min_x = _mm256_set1_ps(box.min_x), q_min_y = _mm256_set1_ps(box.min_y);
+	const __m256 q_max_x = _mm256_set1_ps(box.max_x), q_max_y = _mm256_set1_ps(box.max_y);
+	#elif defined(__SSE2__)
+	const __m128 q_min_x = _mm_set1_ps(box.min_x), q_min_y = _mm_set1_ps(box.min_y);
+	const __m128 q_max_x = _mm_set1_ps(box.max_x), q_max_y = _mm_set1_ps(box.max_y);
+	#endif
+
+	while(top)
+	{
+		const node_t & node = nodes[stack[--top]];
+
+		// one bit per slot intersecting the query
+		#if defined(__AVX__)
+		__m256 hit = _mm256_and_ps(
+			_mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(node.min_x), q_max_x, _CMP_LE_OQ),
+						  _mm256_cmp_ps(_mm256_loadu_ps(node.max_x), q_min_x, _CMP_GE_OQ)),
+			_mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(node.min_y), q_max_y, _CMP_LE_OQ),
+						  _mm256_cmp_ps(_mm256_loadu_ps(node.max_y), q_min_y, _CMP_GE_OQ)));
+		uint32_t mask = (uint32_t)_mm256_movemask_ps(hit);
+		#elif defined(__SSE2__)
+		uint32_t mask = 0;
+		for(uint32_t half = 0; half < fanout; half += 4)
+		{
+			__m128 hit = _mm_and_ps(
+				_mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.min_x + half), q_max_x),
+						   _mm_cmpge_ps(_mm_loadu_ps(node.max_x + half), q_min_x)),
+				_mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.min_y + half), q_max_y),
+						   _mm_cmpge_ps(_mm_loadu_ps(node.max_y + half), q_min_y)));
+			mask |= (uint32_t)_mm_movemask_ps(hit) << half;
+		}
+		#else
+		uint32_t mask = 0;
+		for(uint32_t i = 0; i < fanout; ++i)
+			mask |= (uint32_t)(node.min_x[i] <= box.max_x && node.max_x[i] >= box.min_x &&
+							   node.min_y[i] <= box.max_y && node.max_y[i] >= box.min_y) << i;
+		#endif
+
+		while(mask)
+		{
+			uint32_t i = (uint32_t)__builtin_ctz(mask);
+			mask &= mask - 1;
+			if(node.level)
+				stack[top++] = node.children[i];
+			else
+			{
+				if(found < max)
+					ids[found] = node.children[i];
+				++found;
+			}
+		}
+	}
+	return found;
+}
+
+uint32_t rtree_t::choose_child(uint32_t node, const box_t & box) const
+{
+	const node_t & n = nodes[node];
+	uint32_t best = 0;
+	float best_overlap = FLT_MAX, best_enlargement = FLT_MAX, best_area = FLT_MAX;
+	for(uint32_t i = 0; i < n.count; ++i)
+	{
+		box_t grown = rtree_union(n.box(i), box);
+		float area = rtree_area(n.box(i));
+		float enlargement = rtree_area(grown) - area;
+
+		// above leaves pick the least overlap growth, higher up least area growth
+		float overlap = 0.0f;
+		if(n.level == 1)
+			for(uint32_t j = 0; j < n.count; ++j)
+				if(j != i)
+					overlap += rtree_overlap(grown, n.box(j)) - rtree_overlap(n.box(i), n.box(j));
+
+		if(overlap < best_overlap ||
+		   (overlap == best_overlap && (enlargement < best_enlargement ||
+		   (enlargement == best_enlargement && area < best_area))))
+		{
+			best = i;
+			best_overlap = overlap;
+			best_enlargement = enlargement;
+			best_area = area;
+		}
+	}
+	return best;
+}
+
+uint32_t rtree_t::split(uint32_t node, const box_t & box, uint32_t child)
+{
+	const uint32_t total = fanout + 1;
+	box_t boxes[total];
+	uint32_t children[total];
+	for(uint32_t i = 0; i < fanout; ++i)
+	{
+		boxes[i] = nodes[node].box(i);
+		children[i] = nodes[node].children[i];
+	}
+	boxes[fanout] = box;
+	children[fanout] = child;
+
+	// entries sorted by one of min x, max x, min y, max y
+	auto sorted = [&boxes](uint32_t * order, uint32_t by)
+	{
+		auto key = [&boxes, by](uint32_t i)
+		{
+			const float * b = &boxes[i].min_x;
+			return b[(by & 1) + (by >> 1) * 2];
+		};
+		for(uint32_t i = 0; i < total; ++i)
+			order[i] = i;
+		for(uint32_t i = 1; i < total; ++i)
+			for(uint32_t j = i; j > 0 && key(order[j - 1]) > key(order[j]); --j)
+			{
+				uint32_t t = order[j]; order[j] = order[j - 1]; order[j - 1] = t;
+			}
+	};
+	auto group = [&boxes](const uint32_t * order, uint32_t first, uint32_t last)
+	{
+		box_t result = boxes[order[first]];
+		for(uint32_t i = first + 1; i < last; ++i)
+			result = rtree_union(result, boxes[order[i]]);
+		return result;
+	};
+
+	// axis with the smallest margin sum over all distributions,
+	// then the distribution on it with the least overlap, then least area
+	uint32_t orders[4][total];
+	float margin[2] = {0.0f, 0.0f};
+	for(uint32_t by = 0; by < 4; ++by)
+	{
+		sorted(orders[by], by);
+		for(uint32_t k = min_fill; k <= total - min_fill; ++k)
+			margin[by & 1] += rtree_margin(group(orders[by], 0, k)) + rtree_margin(group(orders[by], k, total));
+	}
+	uint32_t axis = margin[1] < margin[0] ? 1 : 0;
+
+	const uint32_t * best_order = orders[axis];
+	uint32_t best_k = min_fill;
+	float best_overlap = FLT_MAX, best_area = FLT_MAX;
+	for(uint32_t by = axis; by < 4; by += 2)
+		for(uint32_t k = min_fill; k <= total - min_fill; ++k)
+		{
+			box_t a = group(orders[by], 0, k), b = group(orders[by], k, total);
+			float overlap = rtree_overlap(a, b), area = rtree_area(a) + rtree_area(b);
+			if(overlap < best_overlap || (overlap == best_overlap && area < best_area))
+			{
+				best_order = orders[by];
+				best_k = k;
+				best_overlap = overlap;
+				best_area = area;
+			}
+		}
+
+	uint32_t sibling = allocate(nodes[node].level);
+	nodes[node].clear(nodes[sibling].level);
+	for(uint32_t i = 0; i < total; ++i)
+	{
+		node_t & target = nodes[i < best_k ? node : sibling];
+		target.set(target.count++, boxes[best_order[i]], children[best_order[i]]);
+	}
+	return sibling;
+}
+
+void rtree_t::insert(const box_t & box, uint32_t id)
+{
+	if(readonly)
+		return;
+	if(root == invalid)
+		root = allocate(0);
+
+	// walk down growing the boxes on the way
+	uint32_t path[64], slots[64], depth = 0;
+	uint32_t node = root;
+	while(nodes[node].level)
+	{
+		uint32_t slot = choose_child(node, box);
+		nodes[node].set(slot, rtree_union(nodes[node].box(slot), box), nodes[node].children[slot]);
+		path[depth] = node;
+		slots[depth++] = slot;
+		node = nodes[node].children[slot];
+	}
+	++count;
+
+	uint32_t entry = id;
+	box_t entry_box = box;
+	while(true)
+	{
+		if(nodes[node].count < fanout)
+		{
+			nodes[node].set(nodes[node].count++, entry_box, entry);
+			return;
+		}
+
+		// full, split and hand the new sibling to the parent
+		uint32_t sibling = split(node, entry_box, entry);
+		if(!depth)
+		{
+			uint32_t new_root = allocate(nodes[node].level + 1);
+			nodes[new_root].set(nodes[new_root].count++, nodes[node].bounds(), node);
+			nodes[new_root].set(nodes[new_root].count++, nodes[sibling].bounds(), sibling);
+			root = new_root;
+			return;
+		}
+		uint32_t parent = path[--depth];
+		nodes[parent].set(slots[depth], nodes[node].bounds(), node);
+		entry = sibling;
+		entry_box = nodes[sibling].bounds();
+		node = parent;
+	}
+}
+
+void rtree_t::serialize(void * out) const
+{
+	header_t * header = (header_t*)out;
+	memset(header, 0, sizeof(header_t));
+	header->magic = magic;
+	header->version = version;
+	header->endian = 0x01020304u;
+	header->fanout = fanout;
+	header->node_count = node_count;
+	header->root = root;
+	header->count = count;
+	if(node_count)
+		memcpy(header + 1, nodes, (size_t)node_count * sizeof(node_t));
+}
+
+bool rtree_t::attach(const void * buffer, size_t size)
+{
+	const header_t * header = (const header_t*)buffer;
+	if(size < sizeof(header_t) || header->magic != magic || header->version != version ||
+	   header->endian != 0x01020304u || header->fanout != fanout ||
+	   size < sizeof(header_t) + (size_t)header->node_count * sizeof(node_t) ||
+	   (header->root != invalid && header->root >= header->node_count))
+		return false;
+	release();
+	nodes = (node_t*)(header + 1);
+	node_count = node_capacity = header->node_count;
+	root = header->root;
+	count = header->count;
+	readonly = true;
+	return true;
+}
+
+bool rtree_t::save(const char * path) const
+{
+	size_t size = serialized_size();
+	void * buffer = aligned_alloc(alignof(header_t), (size + alignof(header_t) - 1) & ~(alignof(header_t) - 1));
+	serialize(buffer);
+	bool result = file_write(path, buffer, size);
+	free(buffer);
+	return result;
+}
@@ -0,0 +1,214 @@
+#include "search.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// queries walked together by the batched lower_bounds
+static const size_t search_lanes = 16;
+
+// eytzinger
+
+eytzinger_t::~eytzinger_t()
+{
+	free(items);
+	free(ranks);
+}
+
+bool eytzinger_t::build(const uint32_t * sorted, size_t count)
+{
+	free(items);
+	free(ranks);
+	// 64 byte aligned so items[16k] starts a cache line
+	size_t bytes = ((count + 1) * sizeof(uint32_t) + 63) & ~(size_t)63;
+	items = (uint32_t*)aligned_alloc(64, bytes);
+	ranks = (uint32_t*)malloc((count + 1) * sizeof(uint32_t));
+	if(!items || !ranks || count > UINT32_MAX)
+	{
+		this->count = 0;
+		return false;
+	}
+	this->count = count;
+	items[0] = 0;
+	ranks[0] = (uint32_t)count;
+
+	// in order walk of the implicit tree hands out the sorted items
+	size_t k = 1;
+	while(2 * k <= count)
+		k *= 2;
+	for(size_t i = 0; i < count; ++i)
+	{
+		items[k] = sorted[i];
+		ranks[k] = (uint32_t)i;
+		if(2 * k + 1 <= count)
+		{
+			k = 2 * k + 1;
+			while(2 * k <= count)
+				k *= 2;
+		}
+		else
+		{
+			while(k & 1)
+				k >>= 1;
+			k >>= 1;
+		}
+	}
+	return true;
+}
+
+size_t eytzinger_t::lower_bound(uint32_t key) const
+{
+	size_t k = 1;
+	while(k <= count)
+	{
+		__builtin_prefetch(items + k * 16);
+		k = 2 * k + (items[k] < key);
+	}
+	// the right turns after the last left one are trailing ones, the answer is above them
+	k >>= __builtin_ffsll(~(long long)k);
+	return ranks[k];
+}
+
+void eytzinger_t::lower_bound(const uint32_t * keys, size_t n, size_t * positions) const
+{
+	uint32_t levels = count ? 64 - __builtin_clzll(count) : 0;
+	for(size_t first = 0; first < n; first += search_lanes)
+	{
+		size_t width = n - first < search_lanes ? n - first : search_lanes;
+		size_t k[search_lanes];
+		for(size_t j = 0; j < width; ++j)
+			k[j] = 1;
+		// the deepest path is levels long, finished lanes stay where they are
+		for(uint32_t level = 0; level < levels; ++level)
+			for(size_t j = 0; j < width; ++j)
+			{
+				size_t kj = k[j];
+				bool inside = kj <= count;
+				__builtin_prefetch(items + kj * 16);
+				size_t next = 2 * kj + (items[inside ? kj : 0] < keys[first + j]);
+				k[j] = inside ? next : kj;
+			}
+		for(size_t j = 0; j < width; ++j)
+			positions[first + j] = ranks[k[j] >> __builtin_ffsll(~(long long)k[j])];
+	}
+}
+
+// static b+ tree
+
+static inline int32_t search_bias(uint32_t key)
+{
+	return (int32_t)(key ^ 0x80000000u);
+}
+
+statictree_t::~statictree_t()
+{
+	free(keys);
+}
+
+bool statictree_t::build(const uint32_t * sorted, size_t count)
+{
+	free(keys);
+	keys = nullptr;
+	this->count = 0;
+	height = 0;
+
+	// layer sizes in nodes, a parent has node_keys + 1 children
+	size_t nodes = count ? (count + node_keys - 1) / node_keys : 1;
+	size_t leaf_keys = nodes * node_keys;
+	size_t total = leaf_keys;
+	offsets[0] = 0;
+	uint32_t layers = 1;
+	while(nodes > 1)
+	{
+		if(layers == max_height)
+			return false;
+		nodes = (nodes + node_keys) / (node_keys + 1);
+		offsets[layers++] = total;
+		total += nodes * node_keys;
+	}
+	keys = (int32_t*)aligned_alloc(64, total * sizeof(int32_t));
+	if(!keys)
+		return false;
+	this->count = count;
+	height = layers;
+
+	// leaves are the sorted keys, padding compares above everything
+	for(size_t i = 0; i < count; ++i)
+		keys[i] = search_bias(sorted[i]);
+	for(size_t i = count; i < leaf_keys; ++i)
+		keys[i] = INT32_MAX;
+
+	// key j of a node is the first leaf key below child j + 1
+	for(uint32_t h = 1; h < layers; ++h)
+	{
+		size_t layer_keys = (h + 1 < layers ? offsets[h + 1] : total) - offsets[h];
+		for(size_t i = 0; i < layer_keys; ++i)
+		{
+			size_t leftmost = (i / node_keys) * (node_keys + 1) + i % node_keys + 1;
+			for(uint32_t l = 1; l < h; ++l)
+				leftmost *= node_keys + 1;
+			size_t position = leftmost * node_keys;
+			keys[offsets[h] + i] = position < count ? keys[position] : INT32_MAX;
+		}
+	}
+	return true;
+}
+
+uint32_t statictree_t::rank(const int32_t * node, int32_t key)
+{
+	// keys of the node below key, the node is sorted so that is where key goes
+	#if defined(__AVX2__)
+	__m256i x = _mm256_set1_epi32(key);
+	__m256i low = _mm256_cmpgt_epi32(x, _mm256_load_si256((const __m256i*)node));
+	__m256i high = _mm256_cmpgt_epi32(x, _mm256_load_si256((const __m256i*)(node + 8)));
+	uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(low)) |
+					(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(high)) << 8;
+	return (uint32_t)__builtin_popcount(mask);
+	#else
+	uint32_t result = 0;
+	for(uint32_t i = 0; i < node_keys; ++i)
+		result += node[i] < key;
+	return result;
+	#endif
+}
+
+size_t statictree_t::lower_bound(uint32_t key) const
+{
+	int32_t x = search_bias(key);
+	size_t node = 0; // within its layer
+	for(uint32_t h = height - 1; h > 0; --h)
+		node = node * (node_keys + 1) + rank(keys + offsets[h] + node * node_keys, x);
+	// a full leaf rank lands on the start of the next leaf, the leaves are contiguous
+	size_t position = node * node_keys + rank(keys + node * node_keys, x);
+	return position < count ? position : count;
+}
+
+void statictree_t::lower_bound(const uint32_t * queries, size_t n, size_t * positions) const
+{
+	for(size_t first = 0; first < n; first += search_lanes)
+	{
+		size_t width = n - first < search_lanes ? n - first : search_lanes;
+		size_t node[search_lanes];
+		int32_t x[search_lanes];
+		for(size_t j = 0; j < width; ++j)
+		{
+			node[j] = 0;
+			x[j] = search_bias(queries[first + j]);
+		}
+		for(uint32_t h = height - 1; h > 0; --h)
+		{
+			// every lane is on the same layer, one node load each before any is ranked
+			for(size_t j = 0; j < width; ++j)
+				__builtin_prefetch(keys + offsets[h] + node[j] * node_keys);
+			for(size_t j = 0; j < width; ++j)
+				node[j] = node[j] * (node_keys + 1) + rank(keys + offsets[h] + node[j] * node_keys, x[j]);
+		}
+		for(size_t j = 0; j < width; ++j)
+		{
+			size_t position = node[j] * node_keys + rank(keys + node[j] * node_keys, x[j]);
+			positions[first + j] = position < count ? position : count;
+		}
+	}
+}
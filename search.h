@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// static search indexes over a sorted array, built once and then only queried
+// lower_bound gives the position in the sorted array of the first item >= key,
+// count when every item is smaller, like std::lower_bound
+
+// eytzinger (bfs) order: node k has children 2k and 2k + 1, so the 16
+// descendants four levels down share one cache line and are prefetched early
+struct eytzinger_t
+{
+	uint32_t * items = nullptr; // 1 based, items[0] unused
+	uint32_t * ranks = nullptr; // position in the sorted array of items[k], ranks[0] is count
+	size_t count = 0;
+
+	eytzinger_t() = default;
+	~eytzinger_t();
+	eytzinger_t(const eytzinger_t &) = delete;
+	eytzinger_t & operator=(const eytzinger_t &) = delete;
+
+	bool build(const uint32_t * sorted, size_t count);
+	size_t lower_bound(uint32_t key) const;
+	// several queries walk the levels in lockstep so their misses overlap
+	void lower_bound(const uint32_t * keys, size_t n, size_t * positions) const;
+};
+
+// static b+ tree, 16 keys to a 64 byte node and 17 children, the leaves are
+// the sorted array itself (padded to whole nodes), nodes are ranked with
+// two 8 lane compares and a popcount with avx2
+struct statictree_t
+{
+	static const uint32_t node_keys = 16;
+	static const uint32_t max_height = 16;
+
+	// keys stored with the top bit flipped so signed compares order them unsigned
+	int32_t * keys = nullptr;
+	size_t count = 0;
+	uint32_t height = 0;
+	size_t offsets[max_height] = {0}; // first key of every layer, leaves are layer 0
+
+	statictree_t() = default;
+	~statictree_t();
+	statictree_t(const statictree_t &) = delete;
+	statictree_t & operator=(const statictree_t &) = delete;
+
+	bool build(const uint32_t * sorted, size_t count);
+	size_t lower_bound(uint32_t key) const;
+	void lower_bound(const uint32_t * keys, size_t n, size_t * positions) const;
+
+	// private
+	static uint32_t rank(const int32_t * node, int32_t key);
+};
@@ -0,0 +1,291 @@
+#include "sets.h"
+#include "containers.h"
+#include <assert.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// size ratio from where searching beats merging the larger side
+static const size_t sets_gallop_ratio = 128;
+
+// first position >= key at or after first, doubling steps then a binary search
+static inline size_t sets_gallop(const uint32_t * items, size_t first, size_t count, uint32_t key)
+{
+	if(first >= count || items[first] >= key)
+		return first;
+	size_t low = first, step = 1; // items[low] < key
+	while(low + step < count && items[low + step] < key)
+	{
+		low += step;
+		step *= 2;
+	}
+	size_t high = low + step < count ? low + step : count;
+	++low;
+	while(low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+		if(items[middle] < key)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
+
+#if defined(__AVX2__)
+// permute indices moving the lanes set in a mask to the front, a byte each
+static const uint64_t * sets_compact_table()
+{
+	static uint64_t table[256];
+	static bool ready = []()
+	{
+		for(uint32_t mask = 0; mask < 256; ++mask)
+		{
+			uint64_t indices = 0;
+			uint32_t position = 0;
+			for(uint32_t lane = 0; lane < 8; ++lane)
+				if(mask & (1u << lane))
+					indices |= (uint64_t)lane << (8 * position++);
+			table[mask] = indices;
+		}
+		return true;
+	}();
+	(void)ready;
+	return table;
+}
+
+// stores all 8 lanes, the ones past the popcount are garbage
+static inline size_t sets_compact(__m256i items, uint32_t mask, const uint64_t * table, uint32_t * out)
+{
+	__m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(table + mask)));
+	_mm256_storeu_si256((__m256i*)out, _mm256_permutevar8x32_epi32(items, indices));
+	return (size_t)__builtin_popcount(mask);
+}
+#endif
+
+size_t sets_intersect_merge(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out)
+{
+	size_t i = 0, j = 0, count = 0;
+	while(i < a_count && j < b_count)
+	{
+		if(a[i] < b[j])
+			++i;
+		else if(b[j] < a[i])
+			++j;
+		else
+		{
+			out[count++] = a[i];
+			++i;
+			++j;
+		}
+	}
+	return count;
+}
+
+size_t sets_intersect_simd(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out)
+{
+	size_t i = 0, j = 0, count = 0;
+	#if defined(__AVX2__)
+	// a block of a can match over several blocks of b, so near the end of out
+	// the full 8 lane store goes through a buffer
+	const uint64_t * table = sets_compact_table();
+	size_t limit = a_count < b_count ? a_count : b_count;
+	while(i + 8 <= a_count && j + 8 <= b_count)
+	{
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+		// three in lane rotations, then the same with the halves swapped
+		__m256i vs = _mm256_permute2x128_si256(vb, vb, 1);
+		__m256i eq = _mm256_or_si256(_mm256_cmpeq_epi32(va, vb), _mm256_cmpeq_epi32(va, vs));
+		eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, 0x39)));
+		eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, 0x39)));
+		eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, 0x4e)));
+		eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, 0x4e)));
+		eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, 0x93)));
+		eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, 0x93)));
+		uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(eq));
+		if(count + 8 <= limit)
+			count += sets_compact(va, mask, table, out + count);
+		else
+		{
+			uint32_t matched[8];
+			size_t size = sets_compact(va, mask, table, matched);
+			memcpy(out + count, matched, size * sizeof(uint32_t));
+			count += size;
+		}
+		// the block with the smaller last item is done, both on a tie
+		uint32_t a_last = a[i + 7], b_last = b[j + 7];
+		i += a_last <= b_last ? 8 : 0;
+		j += b_last <= a_last ? 8 : 0;
+	}
+	#endif
+	// partners of anything already matched are behind j, so the merge cannot repeat it
+	return count + sets_intersect_merge(a + i, a_count - i, b + j, b_count - j, out + count);
+}
+
+size_t sets_intersect_gallop(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out)
+{
+	if(a_count > b_count)
+	{
+		const uint32_t * t = a;
+		a = b;
+		b = t;
+		size_t c = a_count;
+		a_count = b_count;
+		b_count = c;
+	}
+	size_t j = 0, count = 0;
+	for(size_t i = 0; i < a_count && j < b_count; ++i)
+	{
+		j = sets_gallop(b, j, b_count, a[i]);
+		if(j < b_count && b[j] == a[i])
+			out[count++] = b[j++];
+	}
+	return count;
+}
+
+size_t sets_intersect(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out)
+{
+	if(a_count * sets_gallop_ratio < b_count || b_count * sets_gallop_ratio < a_count)
+		return sets_intersect_gallop(a, a_count, b, b_count, out);
+	return sets_intersect_simd(a, a_count, b, b_count, out);
+}
+
+size_t sets_union(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out)
+{
+	// the smaller head goes out, both advance on a tie, no branch on the data
+	size_t i = 0, j = 0, count = 0;
+	while(i < a_count && j < b_count)
+	{
+		uint32_t x = a[i], y = b[j];
+		out[count++] = x < y ? x : y;
+		i += x <= y;
+		j += y <= x;
+	}
+	for(; i < a_count; ++i)
+		out[count++] = a[i];
+	for(; j < b_count; ++j)
+		out[count++] = b[j];
+	return count;
+}
+
+size_t sets_difference(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out)
+{
+	size_t j = 0, count = 0;
+	if(a_count * sets_gallop_ratio < b_count)
+	{
+		for(size_t i = 0; i < a_count; ++i)
+		{
+			j = sets_gallop(b, j, b_count, a[i]);
+			if(j == b_count || b[j] != a[i])
+				out[count++] = a[i];
+		}
+		return count;
+	}
+	// a[i] goes out unless b has it, the store is unconditional and only counted
+	size_t i = 0;
+	while(i < a_count && j < b_count)
+	{
+		uint32_t x = a[i], y = b[j];
+		out[count] = x;
+		count += x < y;
+		i += x <= y;
+		j += y <= x;
+	}
+	for(; i < a_count; ++i)
+		out[count++] = a[i];
+	return count;
+}
+
+size_t sets_unique(const uint32_t * items, size_t count, uint32_t * out)
+{
+	if(!count)
+		return 0;
+	uint32_t last = items[0];
+	out[0] = last;
+	size_t i = 1, result = 1;
+	#if defined(__AVX2__)
+	// each item against its predecessor, built from the register and the last
+	// item of the block before, so stores in place never clobber unread items
+	const uint64_t * table = sets_compact_table();
+	const __m256i rotate = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i v = _mm256_loadu_si256((const __m256i*)(items + i));
+		__m256i previous = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(v, rotate), _mm256_set1_epi32((int)last), 1);
+		uint32_t repeats = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, previous)));
+		last = items[i + 7];
+		result += sets_compact(v, ~repeats & 0xff, table, out + result);
+	}
+	#endif
+	for(; i < count; ++i)
+	{
+		uint32_t x = items[i];
+		out[result] = x;
+		result += x != last;
+		last = x;
+	}
+	return result;
+}
+
+size_t sets_union_k(const setslist_t * lists, size_t k, uint32_t * out)
+{
+	if(k == 1)
+		return sets_unique(lists[0].items, lists[0].count, out);
+	if(k == 2)
+		return sets_union(lists[0].items, lists[0].count, lists[1].items, lists[1].count, out);
+
+	// heap items are item << 32 | list, so equal items come out in list order
+	basic_binaryheap_t<uint64_t, growable_capacity_t, false> heap;
+	size_t * positions = new size_t[k]();
+	for(size_t list = 0; list < k; ++list)
+		if(lists[list].count)
+			heap.insert((uint64_t)lists[list].items[0] << 32 | list);
+	size_t count = 0;
+	while(heap.count)
+	{
+		uint64_t top = heap.arr[0];
+		uint32_t item = (uint32_t)(top >> 32);
+		size_t list = (size_t)(top & 0xffffffffu);
+		out[count] = item;
+		count += !count || out[count - 1] != item;
+		// the next head of the same list takes the top slot in one sift
+		size_t next = ++positions[list];
+		if(next < lists[list].count)
+			heap.replace((uint64_t)lists[list].items[next] << 32 | list);
+		else
+			heap.remove();
+	}
+	delete[] positions;
+	return count;
+}
+
+dataset_t sets_intersect(const dataset_t & a, const dataset_t & b)
+{
+	dataset_t result;
+	result.count = sets_intersect(a.items, a.count, b.items, b.count, result.items);
+	return result;
+}
+
+dataset_t sets_union(const dataset_t & a, const dataset_t & b)
+{
+	// the result may not fit otherwise, same as the initializer list
+	assert(a.count + b.count <= sizeof(a.items) / sizeof(a.items[0]));
+	dataset_t result;
+	result.count = sets_union(a.items, a.count, b.items, b.count, result.items);
+	return result;
+}
+
+dataset_t sets_difference(const dataset_t & a, const dataset_t & b)
+{
+	dataset_t result;
+	result.count = sets_difference(a.items, a.count, b.items, b.count, result.items);
+	return result;
+}
+
+void sets_unique(dataset_t & data)
+{
+	data.count = sets_unique(data.items, data.count, data.items);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dataset.h"
+
+// operations on sorted, duplicate free uint32 lists (posting lists, id sets)
+// sets_unique turns any sorted list into one, out never aliases an input
+// unless said otherwise, and must hold as many items as the result can have
+
+// a and b both present, out holds min(a_count, b_count)
+// gallops once one side is 128 times the other, simd blocks below that
+size_t sets_intersect(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out);
+// the plain branchy merge every other path is checked against
+size_t sets_intersect_merge(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out);
+// 8 items of a against 8 of b, all pairs by rotating b, matches compacted with a permute
+size_t sets_intersect_simd(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out);
+// every item of the smaller side is found in the larger with an exponential search
+size_t sets_intersect_gallop(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out);
+
+// a or b, out holds a_count + b_count
+size_t sets_union(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out);
+// a and not b, out holds a_count, gallops through b when it is the much larger one
+size_t sets_difference(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out);
+// drops repeats of a sorted list, out may be items
+size_t sets_unique(const uint32_t * items, size_t count, uint32_t * out);
+
+struct setslist_t
+{
+	const uint32_t * items;
+	size_t count;
+};
+
+// union of k lists, heads merged through a min binaryheap of (item, list),
+// out holds the sum of the counts
+size_t sets_union_k(const setslist_t * lists, size_t k, uint32_t * out);
+
+// the same on datasets, sorted and duplicate free except for unique
+dataset_t sets_intersect(const dataset_t & a, const dataset_t & b);
+dataset_t sets_union(const dataset_t & a, const dataset_t & b);
+dataset_t sets_difference(const dataset_t & a, const dataset_t & b);
+void sets_unique(dataset_t & data);
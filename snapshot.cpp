@@ -0,0 +1,79 @@
+#include "snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char snapshot_magic[8] = {'l', 'l', 's', 'n', 'a', 'p', 0, 0};
+
+uint64_t snapshot_checksum(const void * data, size_t size, uint64_t seed)
+{
+	// word at a time multiply-rotate, fast enough to not dominate a verify
+	const uint64_t k1 = 0x9e3779b185ebca87ull, k2 = 0xc2b2ae3d27d4eb4full;
+	const uint8_t * bytes = (const uint8_t*)data;
+	uint64_t h = seed ^ (size * k1);
+	size_t i = 0;
+	for(; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		h ^= word * k2;
+		h = (h << 31 | h >> 33) * k1;
+	}
+	uint64_t tail = 0;
+	for(uint32_t shift = 0; i < size; ++i, shift += 8)
+		tail |= (uint64_t)bytes[i] << shift;
+	h ^= tail * k2;
+	h ^= h >> 29;
+	h *= k1;
+	h ^= h >> 32;
+	return h;
+}
+
+bool snapshot_write(const char * path, snapshot_t::type_t type, uint32_t type_size, uint64_t layout, const void * payload, size_t size)
+{
+	snapshot_t::header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+	header.version = snapshot_t::version;
+	header.endian = snapshot_t::endian;
+	header.type = type;
+	header.type_size = type_size;
+	header.layout = layout;
+	header.payload_size = size;
+	header.checksum = snapshot_checksum(payload, size);
+
+	FILE * f = fopen(path, "wb");
+	if(!f)
+		return false;
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(payload, 1, size, f) == size;
+	return fclose(f) == 0 && ok;
+}
+
+bool snapshot_t::open(const char * path, bool verify_payload)
+{
+	if(!file.open(path))
+		return false;
+	const header_t * h = header();
+	if(file.size < sizeof(header_t) || memcmp(h->magic, snapshot_magic, sizeof(h->magic)) ||
+	   h->version != version || h->endian != endian ||
+	   file.size < sizeof(header_t) + h->payload_size ||
+	   (verify_payload && !verify()))
+	{
+		file.close();
+		return false;
+	}
+	return true;
+}
+
+bool snapshot_t::verify() const
+{
+	return file.valid() && snapshot_checksum(header() + 1, header()->payload_size) == header()->checksum;
+}
+
+const void * snapshot_t::payload(type_t type, uint32_t type_size, uint64_t layout) const
+{
+	if(!file.valid() || header()->type != type || header()->type_size != type_size || header()->layout != layout ||
+	   header()->payload_size < type_size)
+		return nullptr;
+	return header() + 1;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "file.h"
+#include "containers.h"
+#include "dataset.h"
+
+// on disk image of a container: 64 byte header then the container itself
+// containers are flat arrays of plain nodes linked by index, so the mapped
+// bytes are used as they are, nothing is deserialized on open
+struct snapshot_t
+{
+	static const uint32_t version = 2;
+	static const uint32_t endian = 0x01020304u; // reads differently on a foreign byte order
+
+	enum type_t : uint32_t
+	{
+		hashtable = 1,
+		rbtree = 2,
+		dataset = 3,
+	};
+
+	struct alignas(64) header_t
+	{
+		char magic[8]; // "llsnap\0\0"
+		uint32_t version;
+		uint32_t endian;
+		uint32_t type;
+		uint32_t type_size; // sizeof at write time, catches layout changes
+		uint64_t payload_size;
+		uint64_t checksum;
+		uint64_t layout; // element types and flags, see snapshot_layout
+	};
+
+	mappedfile_t file;
+
+	// verify reads the whole payload, leave it off for instant startup
+	bool open(const char * path, bool verify = false);
+	void close() {file.close();}
+	bool verify() const;
+
+	const header_t * header() const {return (const header_t*)file.data;}
+	const void * payload(type_t type, uint32_t type_size, uint64_t layout) const;
+
+	// null if the snapshot holds something else
+	template<typename container_t>
+	const container_t * get() const;
+};
+
+// what sizeof and the family tag do not tell apart: containers of the same
+// size with other key, value or index types, or another slots / counted flag
+// a type is its size plus whether it is signed or floating point
+template<typename type_t>
+constexpr uint64_t snapshot_type()
+{
+	return sizeof(type_t) | (uint64_t)std::is_signed<type_t>::value << 8 | (uint64_t)std::is_floating_point<type_t>::value << 9;
+}
+
+constexpr uint64_t snapshot_layout(uint64_t key_type, uint64_t value_type, uint64_t index_type, uint32_t flags)
+{
+	return key_type | value_type << 16 | index_type << 32 | (uint64_t)flags << 48;
+}
+
+// type tag and layout per container family, only fixed capacity containers
+// are one flat block, growable ones keep their nodes on the heap
+template<typename container_t> struct snapshot_kind;
+
+template<typename key_t, typename value_t, uint32_t N, typename slots_t, typename index_t>
+struct snapshot_kind<basic_hashtable_t<key_t, value_t, fixed_capacity_t<N>, slots_t, index_t>>
+{
+	static constexpr snapshot_t::type_t type = snapshot_t::hashtable;
+	static constexpr uint64_t layout = snapshot_layout(snapshot_type<key_t>(), snapshot_type<value_t>(), snapshot_type<index_t>(), std::is_same<slots_t, flagged_slots_t>::value);
+};
+
+template<typename key_t, typename value_t, uint32_t N, bool counted, typename index_t>
+struct snapshot_kind<basic_rbtree_t<key_t, value_t, fixed_capacity_t<N>, counted, index_t>>
+{
+	static constexpr snapshot_t::type_t type = snapshot_t::rbtree;
+	static constexpr uint64_t layout = snapshot_layout(snapshot_type<key_t>(), snapshot_type<value_t>(), snapshot_type<index_t>(), counted);
+};
+
+template<>
+struct snapshot_kind<dataset_t>
+{
+	static constexpr snapshot_t::type_t type = snapshot_t::dataset;
+	static constexpr uint64_t layout = snapshot_layout(0, snapshot_type<uint32_t>(), 0, 0);
+};
+
+uint64_t snapshot_checksum(const void * data, size_t size, uint64_t seed = 0);
+bool snapshot_write(const char * path, snapshot_t::type_t type, uint32_t type_size, uint64_t layout, const void * payload, size_t size);
+
+template<typename container_t>
+const container_t * snapshot_t::get() const
+{
+	return (const container_t*)payload(snapshot_kind<container_t>::type, sizeof(container_t), snapshot_kind<container_t>::layout);
+}
+
+template<typename container_t>
+bool snapshot_write(const char * path, const container_t & container)
+{
+	constexpr snapshot_t::type_t type = snapshot_kind<container_t>::type;
+	constexpr uint64_t layout = snapshot_kind<container_t>::layout;
+	if constexpr (type == snapshot_t::hashtable)
+	{
+		// the front filter lives on the heap and is not part of the image
+		container_t * image = (container_t*)malloc(sizeof(container_t));
+		memcpy((void*)image, (const void*)&container, sizeof(container_t));
+		image->filter = nullptr;
+		bool result = snapshot_write(path, type, sizeof(container_t), layout, image, sizeof(container_t));
+		free(image);
+		return result;
+	}
+	else
+		return snapshot_write(path, type, sizeof(container_t), layout, &container, sizeof(container_t));
+}
@@ -1,10 +1,195 @@
 #include "sorts.h"
 #include "containers.h"
+#include "tasks.h"
 #include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
+// every comparison of the comparison sorts goes through here to be counted
+static inline bool sorts_less(uint32_t a, uint32_t b)
+{
+	stats_add(stats_sorts_compares);
+	return a < b;
+}
+
+// every swap of the in place sorts, counted like dataset_t::swap
+static inline void sorts_swap(uint32_t * items, size_t a, size_t b)
+{
+	uint32_t t = items[a];
+	items[a] = items[b];
+	items[b] = t;
+	stats_add(stats_sorts_swaps);
+}
+
+// the recursive sorts work on [left, right] of a plain array, a pool forks
+// both halves of ranges longer than grain, without one they run as they always did
+
+// [first, last) split three ways around a median of three, so runs of equal keys
+// are finished in one pass; the smaller side recurses (or is spawned on group for
+// ranges longer than grain) and the larger one stays in this loop, log n deep at most
+static void sorts_quicksort_range(uint32_t * items, size_t first, size_t last, taskgroup_t * group, size_t grain)
+{
+	while(last - first > 1)
+	{
+		size_t middle = first + (last - first) / 2;
+		uint32_t a = items[first], b = items[middle], c = items[last - 1];
+		uint32_t pivot = sorts_less(a, b) ? (sorts_less(b, c) ? b : sorts_less(a, c) ? c : a)
+										  : (sorts_less(a, c) ? a : sorts_less(b, c) ? c : b);
+
+		// [first, lt) below the pivot, [lt, i) equal, [gt, last) above
+		size_t lt = first, i = first, gt = last;
+		while(i < gt)
+		{
+			if(sorts_less(items[i], pivot))
+				sorts_swap(items, lt++, i++);
+			else if(sorts_less(pivot, items[i]))
+				sorts_swap(items, i, --gt);
+			else
+				++i;
+		}
+
+		bool below_smaller = lt - first < last - gt;
+		size_t small_first = below_smaller ? first : gt;
+		size_t small_last = below_smaller ? lt : last;
+		if(group && last - first >= grain)
+			group->spawn([=]()
+			{
+				taskgroup_t inner(group->pool);
+				sorts_quicksort_range(items, small_first, small_last, &inner, grain);
+			});
+		else
+			sorts_quicksort_range(items, small_first, small_last, group, grain);
+		first = below_smaller ? gt : first;
+		last = below_smaller ? last : lt;
+	}
+}
+
+// a and b into out, b goes first only when strictly smaller, so the merge is stable
+static void sorts_merge(const uint32_t * a, size_t a_count, const uint32_t * b, size_t b_count, uint32_t * out, taskpool_t * pool, size_t grain)
+{
+	if(!pool || a_count + b_count <= grain)
+	{
+		for(size_t i = 0, j = 0, k = 0; k < a_count + b_count; ++k)
+			if(i == a_count || (j < b_count && sorts_less(b[j], a[i])))
+				out[k] = b[j++];
+			else
+				out[k] = a[i++];
+		return;
+	}
+	// split the larger side in half, the other where its items stop going first
+	size_t i, j;
+	if(a_count >= b_count)
+	{
+		i = a_count / 2;
+		size_t low = 0, high = b_count;
+		while(low < high)
+		{
+			size_t middle = low + (high - low) / 2;
+			if(sorts_less(b[middle], a[i]))
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		j = low;
+	}
+	else
+	{
+		j = b_count / 2;
+		size_t low = 0, high = a_count;
+		while(low < high)
+		{
+			size_t middle = low + (high - low) / 2;
+			if(!sorts_less(b[j], a[middle]))
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		i = low;
+	}
+	tasks_parallel_invoke(*pool,
+						  [=]() {sorts_merge(a, i, b, j, out, pool, grain);},
+						  [=]() {sorts_merge(a + i, a_count - i, b + j, b_count - j, out + i + j, pool, grain);});
+}
+
+static void sorts_mergesort_range(uint32_t * items, uint32_t * scratch, size_t left, size_t right, taskpool_t * pool, size_t grain)
+{
+	if(left >= right)
+		return;
+	size_t middle = (left + right) / 2;
+	bool fork = pool && right - left >= grain;
+	if(fork)
+		tasks_parallel_invoke(*pool,
+							  [=]() {sorts_mergesort_range(items, scratch, left, middle, pool, grain);},
+							  [=]() {sorts_mergesort_range(items, scratch, middle + 1, right, pool, grain);});
+	else
+	{
+		sorts_mergesort_range(items, scratch, left, middle, pool, grain);
+		sorts_mergesort_range(items, scratch, middle + 1, right, pool, grain);
+	}
+	// merged into the same range of scratch and copied back
+	sorts_merge(items + left, middle + 1 - left, items + middle + 1, right - middle, scratch + left, fork ? pool : nullptr, grain);
+	if(fork)
+		tasks_parallel_for(*pool, left, right + 1, grain, [=](size_t first, size_t last)
+		{
+			memcpy(items + first, scratch + first, (last - first) * sizeof(uint32_t));
+		});
+	else
+		memcpy(items + left, scratch + left, (right + 1 - left) * sizeof(uint32_t));
+}
+
+static void sorts_bitonicmerge_range(uint32_t * items, size_t left, size_t right, bool ascending, taskpool_t * pool, size_t grain)
+{
+	if(left >= right)
+		return;
+
+	size_t middle = 1;
+	while(middle + left < right + 1)
+		middle <<= 1;
+	middle >>= 1;
+
+	auto compare = [=](size_t first, size_t last)
+	{
+		for(size_t i = first, j = first + middle; i < last; ++i, ++j)
+			if(ascending == sorts_less(items[j], items[i]))
+				sorts_swap(items, i, j);
+	};
+	if(pool && right - left >= grain)
+	{
+		tasks_parallel_for(*pool, left, right + 1 - middle, grain, compare);
+		tasks_parallel_invoke(*pool,
+							  [=]() {sorts_bitonicmerge_range(items, left, middle + left - 1, ascending, pool, grain);},
+							  [=]() {sorts_bitonicmerge_range(items, middle + left, right, ascending, pool, grain);});
+	}
+	else
+	{
+		compare(left, right + 1 - middle);
+		sorts_bitonicmerge_range(items, left, middle + left - 1, ascending, pool, grain);
+		sorts_bitonicmerge_range(items, middle + left, right, ascending, pool, grain);
+	}
+}
+
+static void sorts_bitonicsort_range(uint32_t * items, size_t left, size_t right, bool ascending, taskpool_t * pool, size_t grain)
+{
+	if(left >= right)
+		return;
+
+	size_t middle = (left + right) / 2;
+	if(pool && right - left >= grain)
+		tasks_parallel_invoke(*pool,
+							  [=]() {sorts_bitonicsort_range(items, left, middle, !ascending, pool, grain);},
+							  [=]() {sorts_bitonicsort_range(items, middle + 1, right, ascending, pool, grain);});
+	else
+	{
+		sorts_bitonicsort_range(items, left, middle, !ascending, pool, grain);
+		sorts_bitonicsort_range(items, middle + 1, right, ascending, pool, grain);
+	}
+	sorts_bitonicmerge_range(items, left, right, ascending, pool, grain);
+}
+
 void sorts_bubble(dataset_t & data)
 {
+	statsscope_t scope(stats_timer_sort);
 	bool swap = true;
 	size_t count = data.count;
 	while(swap)
@@ -12,7 +197,7 @@ void sorts_bubble(dataset_t & data)
 		swap = false;
 		for(size_t i = 1; i < count; ++i)
 		{
-			if(data.items[i - 1] > data.items[i])
+			if(sorts_less(data.items[i], data.items[i - 1]))
 			{
 				data.swap(i - 1, i);
 				swap = true;
@@ -24,42 +209,13 @@ void sorts_bubble(dataset_t & data)
 
 void sorts_quicksort(dataset_t & data)
 {
-	// TODO try more optimized versions
-	static void (*sort)(dataset_t&, size_t, size_t) =
-	[](dataset_t & data, size_t left, size_t right)
-	{
-		if(left >= right)
-			return;
-		size_t pivot = left; // TODO figure out why only this pivot point works
-		auto pivot_val = data.items[pivot];
-		size_t i = left + 1;
-		size_t j = right;
-
-		while(i < j)
-		{
-			if(data.items[i] <= pivot_val)
-				i++;
-			else if(pivot_val <= data.items[j])
-				j--;
-			else
-				data.swap(i, j);
-		}
-
-		if(data.items[i] < pivot_val) // TODO what exactly does this do ?
-			data.swap(i--, pivot);
-		else
-			data.swap(--i, pivot);
-
-		sort(data, left, i);
-		sort(data, j, right);
-	};
-
-	if(data.count)
-		sort(data, 0, data.count - 1);
+	statsscope_t scope(stats_timer_sort);
+	sorts_quicksort_range(data.items, 0, data.count, nullptr, 0);
 }
 
 void sorts_heapsort(dataset_t & data)
 {
+	statsscope_t scope(stats_timer_sort);
 	binaryheap_t heap;
 	heap.build(data.items, (uint32_t)data.count);
 	for(size_t i = data.count; i > 0; --i)
@@ -68,6 +224,7 @@ void sorts_heapsort(dataset_t & data)
 
 void sorts_treesort(dataset_t & data)
 {
+	statsscope_t scope(stats_timer_sort);
 	rbtree_t tree;
 	for(size_t i = 0; i < data.count; ++i)
 		tree.set(data.items[i], 0, true);
@@ -88,37 +245,15 @@ void sorts_treesort(dataset_t & data)
 
 void sorts_mergesort(dataset_t & data)
 {
-	static void (*merge)(dataset_t&, size_t, size_t, size_t) =
-	[](dataset_t & data, size_t left, size_t right, size_t middle)
-	{
-		auto temp = (decltype(&dataset_t::items[0]))alloca(
-						(right - left + 1) * sizeof(dataset_t::items[0]));
-		for(size_t i = left, j = middle + 1, k = 0; k + left <= right; ++k)
-			if(i > middle || j <= right && data.items[j] < data.items[i])
-				temp[k] = data.items[j++];
-			else
-				temp[k] = data.items[i++];
-		for(size_t k = 0; k + left <= right; ++k)
-			data.items[k + left] = temp[k];
-	};
-
-	static void (*sort)(dataset_t&, size_t, size_t) =
-	[](dataset_t & data, size_t left, size_t right)
-	{
-		if(left >= right)
-			return;
-		size_t middle = (left + right) / 2;
-		sort(data, left, middle);
-		sort(data, middle + 1, right);
-		merge(data, left, right, middle);
-	};
-
+	statsscope_t scope(stats_timer_sort);
+	uint32_t scratch[sizeof(data.items) / sizeof(data.items[0])];
 	if(data.count)
-		sort(data, 0, data.count - 1);
+		sorts_mergesort_range(data.items, scratch, 0, data.count - 1, nullptr, 0);
 }
 
 void sorts_radixsort(dataset_t & data)
 {
+	statsscope_t scope(stats_timer_sort);
 	static void (*sort)(dataset_t&, size_t, size_t, uint32_t) =
 	[](dataset_t & data, size_t left, size_t right, uint32_t bit)
 	{
@@ -160,37 +295,79 @@ void sorts_radixsort(dataset_t & data)
 
 void sorts_bitonicsort(dataset_t & data)
 {
-	static void (*merge)(dataset_t&, size_t, size_t, bool) =
-	[](dataset_t & data, size_t left, size_t right, bool ascending)
-	{
-		if(left >= right)
-			return;
+	statsscope_t scope(stats_timer_sort);
+	if(data.count)
+		sorts_bitonicsort_range(data.items, 0, data.count - 1, true, nullptr, 0);
+}
 
-		size_t middle = 1;
-		while(middle + left < right + 1)
-			middle <<= 1;
-		middle >>= 1;
+void sorts_radixsort_pairs(uint32_t * keys, uint32_t * values, size_t count)
+{
+	if(count < 2)
+		return;
+	uint32_t * temp_keys = (uint32_t*)malloc(count * sizeof(uint32_t));
+	uint32_t * temp_values = (uint32_t*)malloc(count * sizeof(uint32_t));
 
-		for(size_t i = left, j = left + middle; i + middle < right + 1; ++i, ++j)
-			if(ascending == (data.items[i] > data.items[j]))
-				data.swap(i, j);
+	// all four histograms in one read
+	size_t histogram[4][256] = {{0}};
+	for(size_t i = 0; i < count; ++i)
+		for(uint32_t pass = 0; pass < 4; ++pass)
+			++histogram[pass][(keys[i] >> (8 * pass)) & 0xff];
 
-		merge(data, left, middle + left - 1, ascending);
-		merge(data, middle + left, right, ascending);
-	};
+	uint32_t * from_keys = keys, * from_values = values;
+	uint32_t * to_keys = temp_keys, * to_values = temp_values;
+	for(uint32_t pass = 0; pass < 4; ++pass)
+	{
+		// every key has the same digit, nothing to move
+		if(histogram[pass][(keys[0] >> (8 * pass)) & 0xff] == count)
+			continue;
+
+		size_t offset = 0;
+		for(uint32_t digit = 0; digit < 256; ++digit)
+		{
+			size_t size = histogram[pass][digit];
+			histogram[pass][digit] = offset;
+			offset += size;
+		}
+		for(size_t i = 0; i < count; ++i)
+		{
+			size_t j = histogram[pass][(from_keys[i] >> (8 * pass)) & 0xff]++;
+			to_keys[j] = from_keys[i];
+			to_values[j] = from_values[i];
+		}
+		uint32_t * t = from_keys; from_keys = to_keys; to_keys = t;
+		t = from_values; from_values = to_values; to_values = t;
+	}
 
-	static void (*sort)(dataset_t&, size_t, size_t, bool) =
-	[](dataset_t & data, size_t left, size_t right, bool ascending)
+	if(from_keys != keys)
 	{
-		if(left >= right)
-			return;
+		memcpy(keys, from_keys, count * sizeof(uint32_t));
+		memcpy(values, from_values, count * sizeof(uint32_t));
+	}
+	free(temp_keys);
+	free(temp_values);
+}
 
-		size_t middle = (left + right) / 2;
-		sort(data, left, middle, !ascending);
-		sort(data, middle + 1, right, ascending);
-		merge(data, left, right, ascending);
-	};
+void sorts_quicksort(uint32_t * items, size_t count, taskpool_t & pool, size_t grain)
+{
+	statsscope_t scope(stats_timer_sort);
+	taskgroup_t group(pool);
+	sorts_quicksort_range(items, 0, count, &group, grain);
+	group.sync();
+}
 
-	if(data.count)
-		sort(data, 0, data.count - 1, true);
+void sorts_mergesort(uint32_t * items, size_t count, taskpool_t & pool, size_t grain)
+{
+	statsscope_t scope(stats_timer_sort);
+	if(count < 2)
+		return;
+	uint32_t * scratch = (uint32_t*)malloc(count * sizeof(uint32_t));
+	sorts_mergesort_range(items, scratch, 0, count - 1, &pool, grain);
+	free(scratch);
+}
+
+void sorts_bitonicsort(uint32_t * items, size_t count, taskpool_t & pool, size_t grain)
+{
+	statsscope_t scope(stats_timer_sort);
+	if(count)
+		sorts_bitonicsort_range(items, 0, count - 1, true, &pool, grain);
 }
@@ -9,3 +9,17 @@ void sorts_treesort(dataset_t & data);
 void sorts_mergesort(dataset_t & data);
 void sorts_radixsort(dataset_t & data);
 void sorts_bitonicsort(dataset_t & data);
+
+// stable lsd radix sort of keys carrying a value each, for arrays of any size
+void sorts_radixsort_pairs(uint32_t * keys, uint32_t * values, size_t count);
+
+struct taskpool_t;
+
+// the recursive sorts on arrays of any size, both halves of every range longer
+// than grain forked on pool (quicksort forks the smaller side and keeps going on
+// the larger one), same result as the dataset versions whatever the
+// thread count (a pool of one thread runs the forked second half right away,
+// before the first, which only works out because the halves never overlap)
+void sorts_quicksort(uint32_t * items, size_t count, taskpool_t & pool, size_t grain = 1 << 14);
+void sorts_mergesort(uint32_t * items, size_t count, taskpool_t & pool, size_t grain = 1 << 14);
+void sorts_bitonicsort(uint32_t * items, size_t count, taskpool_t & pool, size_t grain = 1 << 14);
@@ -0,0 +1,477 @@
+#include "spatial.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <assert.h>
+#include <thread>
+
+template<typename function_t>
+static void spatial_parallel(uint32_t count, uint32_t threads, function_t function)
+{
+	threads = threads ? threads : std::thread::hardware_concurrency();
+	threads = threads ? threads : 1;
+	if(threads > count)
+		threads = count ? count : 1;
+	std::thread * workers = new std::thread[threads];
+	for(uint32_t t = 0; t < threads; ++t)
+		workers[t] = std::thread([=]()
+		{
+			uint32_t first = (uint32_t)((uint64_t)count * t / threads);
+			uint32_t last = (uint32_t)((uint64_t)count * (t + 1) / threads);
+			for(uint32_t i = first; i < last; ++i)
+				function(i);
+		});
+	for(uint32_t t = 0; t < threads; ++t)
+		workers[t].join();
+	delete[] workers;
+}
+
+float knnheap_t::worst() const
+{
+	return count < k ? FLT_MAX : dist[0];
+}
+
+void knnheap_t::push(float distance, uint32_t id)
+{
+	if(!k || (count == k && distance >= dist[0]))
+		return;
+	uint32_t index;
+	if(count < k)
+	{
+		// sift up from the new slot
+		index = count++;
+		while(index && dist[(index - 1) / 2] < distance)
+		{
+			dist[index] = dist[(index - 1) / 2];
+			ids[index] = ids[(index - 1) / 2];
+			index = (index - 1) / 2;
+		}
+	}
+	else
+	{
+		// replace the worst and sift down
+		index = 0;
+		for(;;)
+		{
+			uint32_t largest = index, left = 2 * index + 1, right = 2 * index + 2;
+			float largest_dist = distance;
+			if(left < count && dist[left] > largest_dist)
+				largest = left, largest_dist = dist[left];
+			if(right < count && dist[right] > largest_dist)
+				largest = right;
+			if(largest == index)
+				break;
+			dist[index] = dist[largest];
+			ids[index] = ids[largest];
+			index = largest;
+		}
+	}
+	dist[index] = distance;
+	ids[index] = id;
+}
+
+void knnheap_t::sort()
+{
+	// heap is tiny, insertion sort keeps it simple
+	for(uint32_t i = 1; i < count; ++i)
+	{
+		float d = dist[i];
+		uint32_t id = ids[i], j = i;
+		for(; j > 0 && dist[j - 1] > d; --j)
+		{
+			dist[j] = dist[j - 1];
+			ids[j] = ids[j - 1];
+		}
+		dist[j] = d;
+		ids[j] = id;
+	}
+	for(uint32_t i = count; i < k; ++i)
+	{
+		dist[i] = FLT_MAX;
+		ids[i] = spatialpoints_t::invalid;
+	}
+}
+
+spatialpoints_t::~spatialpoints_t()
+{
+	free(x);
+	free(y);
+	free(ids);
+}
+
+void spatialpoints_t::assign(const float * xs, const float * ys, uint32_t size)
+{
+	count = size;
+	x = (float*)realloc(x, (size ? size : 1) * sizeof(float));
+	y = (float*)realloc(y, (size ? size : 1) * sizeof(float));
+	ids = (uint32_t*)realloc(ids, (size ? size : 1) * sizeof(uint32_t));
+	if(size)
+	{
+		memcpy(x, xs, size * sizeof(float));
+		memcpy(y, ys, size * sizeof(float));
+	}
+	for(uint32_t i = 0; i < size; ++i)
+		ids[i] = i;
+}
+
+void spatialpoints_t::swap(uint32_t a, uint32_t b)
+{
+	float tx = x[a]; x[a] = x[b]; x[b] = tx;
+	float ty = y[a]; y[a] = y[b]; y[b] = ty;
+	uint32_t ti = ids[a]; ids[a] = ids[b]; ids[b] = ti;
+}
+
+void spatialpoints_t::scan_knn(uint32_t first, uint32_t last, float qx, float qy, knnheap_t & heap) const
+{
+	const uint32_t chunk = 16;
+	float d[chunk];
+	for(uint32_t base = first; base < last; base += chunk)
+	{
+		uint32_t n = last - base < chunk ? last - base : chunk;
+		// straight line arithmetic, vectorizes
+		for(uint32_t i = 0; i < n; ++i)
+		{
+			float dx = x[base + i] - qx, dy = y[base + i] - qy;
+			d[i] = dx * dx + dy * dy;
+		}
+		float worst = heap.worst();
+		for(uint32_t i = 0; i < n; ++i)
+			if(d[i] < worst)
+			{
+				heap.push(d[i], ids[base + i]);
+				worst = heap.worst();
+			}
+	}
+}
+
+uint32_t spatialpoints_t::scan_radius(uint32_t first, uint32_t last, float qx, float qy, float r2, uint32_t * out, uint32_t size, uint32_t max) const
+{
+	const uint32_t chunk = 16;
+	uint8_t inside[chunk];
+	for(uint32_t base = first; base < last; base += chunk)
+	{
+		uint32_t n = last - base < chunk ? last - base : chunk;
+		for(uint32_t i = 0; i < n; ++i)
+		{
+			float dx = x[base + i] - qx, dy = y[base + i] - qy;
+			inside[i] = dx * dx + dy * dy <= r2;
+		}
+		for(uint32_t i = 0; i < n; ++i)
+			if(inside[i])
+			{
+				if(size < max)
+					out[size] = ids[base + i];
+				++size;
+			}
+	}
+	return size;
+}
+
+uint32_t spatialpoints_t::scan_box(uint32_t first, uint32_t last, float min_x, float min_y, float max_x, float max_y, uint32_t * out, uint32_t size, uint32_t max) const
+{
+	const uint32_t chunk = 16;
+	uint8_t inside[chunk];
+	for(uint32_t base = first; base < last; base += chunk)
+	{
+		uint32_t n = last - base < chunk ? last - base : chunk;
+		for(uint32_t i = 0; i < n; ++i)
+			inside[i] = (x[base + i] >= min_x) & (x[base + i] <= max_x) & (y[base + i] >= min_y) & (y[base + i] <= max_y);
+		for(uint32_t i = 0; i < n; ++i)
+			if(inside[i])
+			{
+				if(size < max)
+					out[size] = ids[base + i];
+				++size;
+			}
+	}
+	return size;
+}
+
+kdtree_t::~kdtree_t()
+{
+	free(splits);
+}
+
+void kdtree_t::build(const float * xs, const float * ys, uint32_t count)
+{
+	points.assign(xs, ys, count);
+	levels = 0;
+	while(((uint64_t)count + (1ull << levels) - 1) >> levels > leaf_size)
+		++levels;
+	splits = (float*)realloc(splits, ((1u << levels)) * sizeof(float));
+	if(levels)
+		build(0, 0, count, 0);
+}
+
+void kdtree_t::build(uint32_t node, uint32_t first, uint32_t last, uint32_t depth)
+{
+	if(depth == levels)
+		return;
+
+	// quickselect the median on this level's axis
+	const float * axis = depth & 1 ? points.y : points.x;
+	uint32_t middle = first + (last - first) / 2;
+	int64_t left = first, right = (int64_t)last - 1;
+	while(left < right)
+	{
+		float pivot = axis[middle];
+		int64_t i = left, j = right;
+		do
+		{
+			while(axis[i] < pivot)
+				++i;
+			while(pivot < axis[j])
+				--j;
+			if(i <= j)
+				points.swap((uint32_t)i++, (uint32_t)j--);
+		}
+		while(i <= j);
+		if(j < (int64_t)middle)
+			left = i;
+		if((int64_t)middle < i)
+			right = j;
+	}
+	splits[node] = axis[middle];
+
+	build(2 * node + 1, first, middle, depth + 1);
+	build(2 * node + 2, middle, last, depth + 1);
+}
+
+void kdtree_t::knn(uint32_t node, uint32_t first, uint32_t last, uint32_t depth, float x, float y, knnheap_t & heap) const
+{
+	if(depth == levels)
+	{
+		points.scan_knn(first, last, x, y, heap);
+		return;
+	}
+	uint32_t middle = first + (last - first) / 2;
+	float diff = (depth & 1 ? y : x) - splits[node];
+	if(diff < 0.0f)
+	{
+		knn(2 * node + 1, first, middle, depth + 1, x, y, heap);
+		if(diff * diff < heap.worst())
+			knn(2 * node + 2, middle, last, depth + 1, x, y, heap);
+	}
+	else
+	{
+		knn(2 * node + 2, middle, last, depth + 1, x, y, heap);
+		if(diff * diff < heap.worst())
+			knn(2 * node + 1, first, middle, depth + 1, x, y, heap);
+	}
+}
+
+uint32_t kdtree_t::knn(float x, float y, uint32_t k, uint32_t * ids, float * dist) const
+{
+	knnheap_t heap(dist, ids, k);
+	if(points.count)
+		knn(0, 0, points.count, 0, x, y, heap);
+	heap.sort();
+	return heap.count;
+}
+
+void kdtree_t::knn(const float * xs, const float * ys, uint32_t count, uint32_t k, uint32_t * ids, float * dist, uint32_t threads) const
+{
+	spatial_parallel(count, threads, [=](uint32_t i)
+	{
+		knn(xs[i], ys[i], k, ids + (size_t)i * k, dist + (size_t)i * k);
+	});
+}
+
+uint32_t kdtree_t::radius(uint32_t node, uint32_t first, uint32_t last, uint32_t depth, float x, float y, float r, uint32_t * ids, uint32_t size, uint32_t max) const
+{
+	if(depth == levels)
+		return points.scan_radius(first, last, x, y, r * r, ids, size, max);
+	uint32_t middle = first + (last - first) / 2;
+	float q = depth & 1 ? y : x;
+	if(q - r <= splits[node])
+		size = radius(2 * node + 1, first, middle, depth + 1, x, y, r, ids, size, max);
+	if(q + r >= splits[node])
+		size = radius(2 * node + 2, middle, last, depth + 1, x, y, r, ids, size, max);
+	return size;
+}
+
+uint32_t kdtree_t::radius(float x, float y, float r, uint32_t * ids, uint32_t max) const
+{
+	return points.count ? radius(0, 0, points.count, 0, x, y, r, ids, 0, max) : 0;
+}
+
+uint32_t kdtree_t::box(uint32_t node, uint32_t first, uint32_t last, uint32_t depth, const float * bounds, uint32_t * ids, uint32_t size, uint32_t max) const
+{
+	if(depth == levels)
+		return points.scan_box(first, last, bounds[0], bounds[1], bounds[2], bounds[3], ids, size, max);
+	uint32_t middle = first + (last - first) / 2;
+	uint32_t axis = depth & 1;
+	if(bounds[axis] <= splits[node])
+		size = box(2 * node + 1, first, middle, depth + 1, bounds, ids, size, max);
+	if(bounds[axis + 2] >= splits[node])
+		size = box(2 * node + 2, middle, last, depth + 1, bounds, ids, size, max);
+	return size;
+}
+
+uint32_t kdtree_t::box(float min_x, float min_y, float max_x, float max_y, uint32_t * ids, uint32_t max) const
+{
+	float bounds[4] = {min_x, min_y, max_x, max_y};
+	return points.count ? box(0, 0, points.count, 0, bounds, ids, 0, max) : 0;
+}
+
+quadtree_t::~quadtree_t()
+{
+	free(nodes);
+}
+
+uint32_t quadtree_t::allocate()
+{
+	if(node_count + 4 > node_capacity)
+	{
+		node_capacity = node_capacity ? node_capacity * 2 : 64;
+		nodes = (node_t*)realloc(nodes, node_capacity * sizeof(node_t));
+	}
+	for(uint32_t i = 0; i < 4; ++i)
+		nodes[node_count + i] = node_t();
+	node_count += 4;
+	return node_count - 4;
+}
+
+void quadtree_t::build(const float * xs, const float * ys, uint32_t count)
+{
+	points.assign(xs, ys, count);
+	node_count = 0;
+	min_x = min_y = FLT_MAX;
+	float max_x = -FLT_MAX, max_y = -FLT_MAX;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		min_x = points.x[i] < min_x ? points.x[i] : min_x;
+		min_y = points.y[i] < min_y ? points.y[i] : min_y;
+		max_x = points.x[i] > max_x ? points.x[i] : max_x;
+		max_y = points.y[i] > max_y ? points.y[i] : max_y;
+	}
+	if(!count)
+		min_x = min_y = max_x = max_y = 0.0f;
+	size = (max_x - min_x > max_y - min_y ? max_x - min_x : max_y - min_y) * 1.0001f + FLT_MIN;
+
+	allocate(); // root is node 0, the other three stay unused
+	nodes[0].count = count;
+	build(0, min_x, min_y, size, 0);
+}
+
+void quadtree_t::build(uint32_t node, float node_x, float node_y, float node_size, uint32_t depth)
+{
+	uint32_t first = nodes[node].first, count = nodes[node].count;
+	if(count <= leaf_size || depth >= max_depth)
+		return;
+
+	float half = node_size * 0.5f, cx = node_x + half, cy = node_y + half;
+	auto partition = [this](uint32_t left, uint32_t right, const float * axis, float split) -> uint32_t
+	{
+		while(left < right)
+			if(axis[left] < split)
+				++left;
+			else
+				points.swap(left, --right);
+		return left;
+	};
+	uint32_t last = first + count;
+	uint32_t y_split = partition(first, last, points.y, cy);
+	uint32_t ranges[5] = {first, partition(first, y_split, points.x, cx), y_split, partition(y_split, last, points.x, cx), last};
+
+	uint32_t children = allocate();
+	nodes[node].children = children;
+	for(uint32_t i = 0; i < 4; ++i)
+	{
+		nodes[children + i].first = ranges[i];
+		nodes[children + i].count = ranges[i + 1] - ranges[i];
+		build(children + i, i & 1 ? cx : node_x, i & 2 ? cy : node_y, half, depth + 1);
+	}
+}
+
+static inline float quadtree_distance(float x, float y, float node_x, float node_y, float node_size)
+{
+	float dx = x < node_x ? node_x - x : x > node_x + node_size ? x - node_x - node_size : 0.0f;
+	float dy = y < node_y ? node_y - y : y > node_y + node_size ? y - node_y - node_size : 0.0f;
+	return dx * dx + dy * dy;
+}
+
+void quadtree_t::knn(uint32_t node, float node_x, float node_y, float node_size, float x, float y, knnheap_t & heap) const
+{
+	const node_t & n = nodes[node];
+	if(n.children == invalid)
+	{
+		points.scan_knn(n.first, n.first + n.count, x, y, heap);
+		return;
+	}
+
+	// closest quadrant first
+	float half = node_size * 0.5f;
+	float dist[4];
+	uint32_t order[4] = {0, 1, 2, 3};
+	for(uint32_t i = 0; i < 4; ++i)
+		dist[i] = quadtree_distance(x, y, i & 1 ? node_x + half : node_x, i & 2 ? node_y + half : node_y, half);
+	for(uint32_t i = 1; i < 4; ++i)
+		for(uint32_t j = i; j > 0 && dist[order[j - 1]] > dist[order[j]]; --j)
+		{
+			uint32_t t = order[j]; order[j] = order[j - 1]; order[j - 1] = t;
+		}
+	for(uint32_t i = 0; i < 4; ++i)
+	{
+		uint32_t c = order[i];
+		if(nodes[n.children + c].count && dist[c] < heap.worst())
+			knn(n.children + c, c & 1 ? node_x + half : node_x, c & 2 ? node_y + half : node_y, half, x, y, heap);
+	}
+}
+
+uint32_t quadtree_t::knn(float x, float y, uint32_t k, uint32_t * ids, float * dist) const
+{
+	knnheap_t heap(dist, ids, k);
+	if(points.count)
+		knn(0, min_x, min_y, size, x, y, heap);
+	heap.sort();
+	return heap.count;
+}
+
+void quadtree_t::knn(const float * xs, const float * ys, uint32_t count, uint32_t k, uint32_t * ids, float * dist, uint32_t threads) const
+{
+	spatial_parallel(count, threads, [=](uint32_t i)
+	{
+		knn(xs[i], ys[i], k, ids + (size_t)i * k, dist + (size_t)i * k);
+	});
+}
+
+uint32_t quadtree_t::box(uint32_t node, float node_x, float node_y, float node_size, const float * bounds, float r2, uint32_t * ids, uint32_t size, uint32_t max) const
+{
+	const node_t & n = nodes[node];
+	if(!n.count || node_x > bounds[2] || node_y > bounds[3] || node_x + node_size < bounds[0] || node_y + node_size < bounds[1])
+		return size;
+
+	bool radius = r2 >= 0.0f;
+	if(!radius && node_x >= bounds[0] && node_y >= bounds[1] && node_x + node_size <= bounds[2] && node_y + node_size <= bounds[3])
+	{
+		// whole square is inside, take the range as is
+		for(uint32_t i = n.first; i < n.first + n.count; ++i, ++size)
+			if(size < max)
+				ids[size] = points.ids[i];
+		return size;
+	}
+	if(n.children == invalid)
+	{
+		if(radius)
+			return points.scan_radius(n.first, n.first + n.count, bounds[4], bounds[5], r2, ids, size, max);
+		return points.scan_box(n.first, n.first + n.count, bounds[0], bounds[1], bounds[2], bounds[3], ids, size, max);
+	}
+
+	float half = node_size * 0.5f;
+	for(uint32_t i = 0; i < 4; ++i)
+		size = box(n.children + i, i & 1 ? node_x + half : node_x, i & 2 ? node_y + half : node_y, half, bounds, r2, ids, size, max);
+	return size;
+}
+
+uint32_t quadtree_t::radius(float x, float y, float r, uint32_t * ids, uint32_t max) const
+{
+	float bounds[6] = {x - r, y - r, x + r, y + r, x, y}; // box around the circle, then its center
+	return points.count ? box(0, min_x, min_y, size, bounds, r * r, ids, 0, max) : 0;
+}
+
+uint32_t quadtree_t::box(float box_min_x, float box_min_y, float box_max_x, float box_max_y, uint32_t * ids, uint32_t max) const
+{
+	float bounds[4] = {box_min_x, box_min_y, box_max_x, box_max_y};
+	return points.count ? box(0, min_x, min_y, size, bounds, -1.0f, ids, 0, max) : 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 2d point indexes, points are kept as structure of arrays and reordered
+// so every leaf is a contiguous run that scans in straight vector loops
+// query results are point ids, the position in the array given to build
+
+// k nearest so far as a max heap on distance, the root is the one to beat
+struct knnheap_t
+{
+	float * dist;
+	uint32_t * ids;
+	uint32_t k;
+	uint32_t count = 0;
+
+	knnheap_t(float * dist, uint32_t * ids, uint32_t k) : dist(dist), ids(ids), k(k) {}
+	float worst() const;
+	void push(float distance, uint32_t id);
+	void sort(); // ascending distance, unused slots get invalid ids
+};
+
+struct spatialpoints_t
+{
+	static const uint32_t invalid = 0xffffffffu;
+
+	float * x = nullptr;
+	float * y = nullptr;
+	uint32_t * ids = nullptr;
+	uint32_t count = 0;
+
+	spatialpoints_t() = default;
+	~spatialpoints_t();
+	spatialpoints_t(const spatialpoints_t &) = delete;
+	spatialpoints_t & operator=(const spatialpoints_t &) = delete;
+
+	void assign(const float * xs, const float * ys, uint32_t size);
+	void swap(uint32_t a, uint32_t b);
+	void scan_knn(uint32_t first, uint32_t last, float qx, float qy, knnheap_t & heap) const;
+	uint32_t scan_radius(uint32_t first, uint32_t last, float qx, float qy, float r2, uint32_t * out, uint32_t size, uint32_t max) const;
+	uint32_t scan_box(uint32_t first, uint32_t last, float min_x, float min_y, float max_x, float max_y, uint32_t * out, uint32_t size, uint32_t max) const;
+};
+
+// bulk built k-d tree in implicit layout: node i has children 2i+1 and 2i+2,
+// ranges are halved at every level so only split values need storing
+struct kdtree_t
+{
+	static const uint32_t invalid = 0xffffffffu;
+	static const uint32_t leaf_size = 16;
+
+	spatialpoints_t points;
+	float * splits = nullptr;
+	uint32_t levels = 0;
+
+	kdtree_t() = default;
+	~kdtree_t();
+	kdtree_t(const kdtree_t &) = delete;
+	kdtree_t & operator=(const kdtree_t &) = delete;
+
+	// public
+	void build(const float * xs, const float * ys, uint32_t count);
+	// results are written up to max and the total number found is returned
+	uint32_t knn(float x, float y, uint32_t k, uint32_t * ids, float * dist) const;
+	uint32_t radius(float x, float y, float r, uint32_t * ids, uint32_t max) const;
+	uint32_t box(float min_x, float min_y, float max_x, float max_y, uint32_t * ids, uint32_t max) const;
+	// k results per query, threads = 0 uses all cores
+	void knn(const float * xs, const float * ys, uint32_t count, uint32_t k, uint32_t * ids, float * dist, uint32_t threads = 0) const;
+
+	// private
+	void build(uint32_t node, uint32_t first, uint32_t last, uint32_t depth);
+	void knn(uint32_t node, uint32_t first, uint32_t last, uint32_t depth, float x, float y, knnheap_t & heap) const;
+	uint32_t radius(uint32_t node, uint32_t first, uint32_t last, uint32_t depth, float x, float y, float r, uint32_t * ids, uint32_t size, uint32_t max) const;
+	uint32_t box(uint32_t node, uint32_t first, uint32_t last, uint32_t depth, const float * bounds, uint32_t * ids, uint32_t size, uint32_t max) const;
+};
+
+// point region quad tree, every node splits its square into 4 equal ones
+// points are partitioned in place so any node covers a contiguous range
+struct quadtree_t
+{
+	static const uint32_t invalid = 0xffffffffu;
+	static const uint32_t leaf_size = 16;
+	static const uint32_t max_depth = 24;
+
+	struct node_t
+	{
+		uint32_t children = invalid; // first of 4 consecutive nodes, invalid for leaf
+		uint32_t first = 0;
+		uint32_t count = 0;
+	};
+
+	spatialpoints_t points;
+	node_t * nodes = nullptr;
+	uint32_t node_count = 0;
+	uint32_t node_capacity = 0;
+	float min_x = 0.0f, min_y = 0.0f, size = 0.0f; // root square
+
+	quadtree_t() = default;
+	~quadtree_t();
+	quadtree_t(const quadtree_t &) = delete;
+	quadtree_t & operator=(const quadtree_t &) = delete;
+
+	// public
+	void build(const float * xs, const float * ys, uint32_t count);
+	uint32_t knn(float x, float y, uint32_t k, uint32_t * ids, float * dist) const;
+	uint32_t radius(float x, float y, float r, uint32_t * ids, uint32_t max) const;
+	uint32_t box(float min_x, float min_y, float max_x, float max_y, uint32_t * ids, uint32_t max) const;
+	void knn(const float * xs, const float * ys, uint32_t count, uint32_t k, uint32_t * ids, float * dist, uint32_t threads = 0) const;
+
+	// private
+	uint32_t allocate();
+	void build(uint32_t node, float node_x, float node_y, float node_size, uint32_t depth);
+	void knn(uint32_t node, float node_x, float node_y, float node_size, float x, float y, knnheap_t & heap) const;
+	uint32_t box(uint32_t node, float node_x, float node_y, float node_size, const float * bounds, float r2, uint32_t * ids, uint32_t size, uint32_t max) const;
+};
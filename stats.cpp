@@ -0,0 +1,151 @@
+#include "stats.h"
+#include <string.h>
+#include <mutex>
+
+static std::mutex stats_mutex;
+static statsblock_t * stats_blocks = nullptr;
+static statsvalues_t stats_finished; // threads that already exited
+
+static const char * stats_counter_names[stats_counter_count] =
+{
+	"hashtable_lookups",
+	"hashtable_probes",
+	"hashtable_filtered",
+	"rbtree_rotations",
+	"binaryheap_sifts",
+	"binaryheap_sift_levels",
+	"sorts_compares",
+	"sorts_swaps",
+	"aggregate_spills",
+};
+
+static const char * stats_timer_names[stats_timer_count] =
+{
+	"sort",
+	"hashtable_set",
+	"rbtree_set",
+	"rbtree_remove",
+	"graph_search",
+};
+
+statsblock_t::statsblock_t()
+{
+	memset(counters, 0, sizeof(counters));
+	memset(timer_calls, 0, sizeof(timer_calls));
+	memset(timer_ns, 0, sizeof(timer_ns));
+	memset(timer_max_ns, 0, sizeof(timer_max_ns));
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	prev = nullptr;
+	next = stats_blocks;
+	if(next)
+		next->prev = this;
+	stats_blocks = this;
+}
+
+statsblock_t::~statsblock_t()
+{
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	for(uint32_t i = 0; i < stats_counter_count; ++i)
+		stats_finished.counters[i] += counters[i];
+	for(uint32_t i = 0; i < stats_timer_count; ++i)
+	{
+		stats_finished.timer_calls[i] += timer_calls[i];
+		stats_finished.timer_ns[i] += timer_ns[i];
+		if(timer_max_ns[i] > stats_finished.timer_max_ns[i])
+			stats_finished.timer_max_ns[i] = timer_max_ns[i];
+	}
+	if(prev)
+		prev->next = next;
+	else
+		stats_blocks = next;
+	if(next)
+		next->prev = prev;
+}
+
+statsblock_t & stats_local()
+{
+	static thread_local statsblock_t block;
+	return block;
+}
+
+void stats_collect(statsvalues_t & values)
+{
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	values = stats_finished;
+	for(statsblock_t * block = stats_blocks; block; block = block->next)
+	{
+		for(uint32_t i = 0; i < stats_counter_count; ++i)
+			values.counters[i] += __atomic_load_n(&block->counters[i], __ATOMIC_RELAXED);
+		for(uint32_t i = 0; i < stats_timer_count; ++i)
+		{
+			values.timer_calls[i] += __atomic_load_n(&block->timer_calls[i], __ATOMIC_RELAXED);
+			values.timer_ns[i] += __atomic_load_n(&block->timer_ns[i], __ATOMIC_RELAXED);
+			uint64_t max_ns = __atomic_load_n(&block->timer_max_ns[i], __ATOMIC_RELAXED);
+			if(max_ns > values.timer_max_ns[i])
+				values.timer_max_ns[i] = max_ns;
+		}
+	}
+}
+
+void stats_reset()
+{
+	// other threads may still add while this runs, call it between workloads
+	std::lock_guard<std::mutex> lock(stats_mutex);
+	memset(&stats_finished, 0, sizeof(stats_finished));
+	for(statsblock_t * block = stats_blocks; block; block = block->next)
+	{
+		for(uint32_t i = 0; i < stats_counter_count; ++i)
+			__atomic_store_n(&block->counters[i], 0, __ATOMIC_RELAXED);
+		for(uint32_t i = 0; i < stats_timer_count; ++i)
+		{
+			__atomic_store_n(&block->timer_calls[i], 0, __ATOMIC_RELAXED);
+			__atomic_store_n(&block->timer_ns[i], 0, __ATOMIC_RELAXED);
+			__atomic_store_n(&block->timer_max_ns[i], 0, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+const char * stats_counter_name(stats_counter_t counter)
+{
+	return counter < stats_counter_count ? stats_counter_names[counter] : "unknown";
+}
+
+const char * stats_timer_name(stats_timer_t timer)
+{
+	return timer < stats_timer_count ? stats_timer_names[timer] : "unknown";
+}
+
+void stats_write_json(FILE * f)
+{
+	statsvalues_t values;
+	stats_collect(values);
+	fprintf(f, "{\"enabled\": %s, \"counters\": {", stats_enabled ? "true" : "false");
+	for(uint32_t i = 0; i < stats_counter_count; ++i)
+		fprintf(f, "%s\"%s\": %llu", i ? ", " : "", stats_counter_names[i], (unsigned long long)values.counters[i]);
+	fprintf(f, "}, \"timers\": {");
+	for(uint32_t i = 0; i < stats_timer_count; ++i)
+		fprintf(f, "%s\"%s\": {\"calls\": %llu, \"seconds\": %.9f, \"max_seconds\": %.9f}", i ? ", " : "",
+				stats_timer_names[i], (unsigned long long)values.timer_calls[i],
+				(double)values.timer_ns[i] * 1e-9, (double)values.timer_max_ns[i] * 1e-9);
+	fprintf(f, "}}\n");
+}
+
+void stats_write_prometheus(FILE * f)
+{
+	statsvalues_t values;
+	stats_collect(values);
+	for(uint32_t i = 0; i < stats_counter_count; ++i)
+	{
+		fprintf(f, "# TYPE letslearn_%s_total counter\n", stats_counter_names[i]);
+		fprintf(f, "letslearn_%s_total %llu\n", stats_counter_names[i], (unsigned long long)values.counters[i]);
+	}
+	fprintf(f, "# TYPE letslearn_timer_calls_total counter\n");
+	for(uint32_t i = 0; i < stats_timer_count; ++i)
+		fprintf(f, "letslearn_timer_calls_total{timer=\"%s\"} %llu\n", stats_timer_names[i], (unsigned long long)values.timer_calls[i]);
+	fprintf(f, "# TYPE letslearn_timer_seconds_total counter\n");
+	for(uint32_t i = 0; i < stats_timer_count; ++i)
+		fprintf(f, "letslearn_timer_seconds_total{timer=\"%s\"} %.9f\n", stats_timer_names[i], (double)values.timer_ns[i] * 1e-9);
+	fprintf(f, "# TYPE letslearn_timer_max_seconds gauge\n");
+	for(uint32_t i = 0; i < stats_timer_count; ++i)
+		fprintf(f, "letslearn_timer_max_seconds{timer=\"%s\"} %.9f\n", stats_timer_names[i], (double)values.timer_max_ns[i] * 1e-9);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// instrumentation counters, build with -DLETSLEARN_STATS=1 to switch them on
+// off (the default) every hook is an empty inline function and compiles away
+#if !defined(LETSLEARN_STATS)
+#define LETSLEARN_STATS 0
+#endif
+
+static constexpr bool stats_enabled = LETSLEARN_STATS != 0;
+
+enum stats_counter_t : uint32_t
+{
+	stats_hashtable_lookups,
+	stats_hashtable_probes,       // slots visited by index(), probes / lookups is the mean probe length
+	stats_hashtable_filtered,     // lookups stopped by the front filter
+	stats_rbtree_rotations,
+	stats_binaryheap_sifts,
+	stats_binaryheap_sift_levels, // levels moved by sift up / down, sift depth
+	stats_sorts_compares,
+	stats_sorts_swaps,
+	stats_aggregate_spills,       // pre-aggregation tables flushed to the merge partitions
+	stats_counter_count
+};
+
+enum stats_timer_t : uint32_t
+{
+	stats_timer_sort,
+	stats_timer_hashtable_set,
+	stats_timer_rbtree_set,
+	stats_timer_rbtree_remove,
+	stats_timer_graph_search,
+	stats_timer_count
+};
+
+// one per thread, written only by its own thread so the hot path is a plain add
+// (relaxed atomic stores keep concurrent readers well defined)
+struct statsblock_t
+{
+	uint64_t counters[stats_counter_count];
+	uint64_t timer_calls[stats_timer_count];
+	uint64_t timer_ns[stats_timer_count];
+	uint64_t timer_max_ns[stats_timer_count];
+	statsblock_t * next;
+	statsblock_t * prev;
+
+	statsblock_t();  // registers with the global list
+	~statsblock_t(); // folds into the totals of finished threads
+};
+
+// sum over live threads plus finished ones
+struct statsvalues_t
+{
+	uint64_t counters[stats_counter_count];
+	uint64_t timer_calls[stats_timer_count];
+	uint64_t timer_ns[stats_timer_count];
+	uint64_t timer_max_ns[stats_timer_count];
+};
+
+statsblock_t & stats_local();
+void stats_collect(statsvalues_t & values);
+void stats_reset();
+const char * stats_counter_name(stats_counter_t counter);
+const char * stats_timer_name(stats_timer_t timer);
+void stats_write_json(FILE * f);
+void stats_write_prometheus(FILE * f);
+
+inline void stats_add(stats_counter_t counter, uint64_t amount = 1)
+{
+	if constexpr (stats_enabled)
+	{
+		uint64_t & value = stats_local().counters[counter];
+		__atomic_store_n(&value, value + amount, __ATOMIC_RELAXED);
+	}
+}
+
+inline uint64_t stats_now_ns()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// scoped timer, counts a call and its duration when it goes out of scope
+struct statsscope_t
+{
+	stats_timer_t timer;
+	uint64_t start;
+
+	statsscope_t(stats_timer_t timer) : timer(timer)
+	{
+		if constexpr (stats_enabled)
+			start = stats_now_ns();
+	}
+	~statsscope_t()
+	{
+		if constexpr (stats_enabled)
+		{
+			uint64_t elapsed = stats_now_ns() - start;
+			statsblock_t & block = stats_local();
+			__atomic_store_n(&block.timer_calls[timer], block.timer_calls[timer] + 1, __ATOMIC_RELAXED);
+			__atomic_store_n(&block.timer_ns[timer], block.timer_ns[timer] + elapsed, __ATOMIC_RELAXED);
+			if(elapsed > block.timer_max_ns[timer])
+				__atomic_store_n(&block.timer_max_ns[timer], elapsed, __ATOMIC_RELAXED);
+		}
+	}
+	statsscope_t(const statsscope_t &) = delete;
+	statsscope_t & operator=(const statsscope_t &) = delete;
+};
@@ -0,0 +1,318 @@
+#include "stringsort.h"
+#include "tasks.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ranges up to these counts go to insertion sort and multikey quicksort
+static const size_t stringsort_insertion_count = 16;
+static const size_t stringsort_multikey_count = 64;
+// one bucket per byte value, bucket 0 for keys that end at the depth
+static const uint32_t stringsort_buckets = 257;
+
+static inline uint32_t stringsort_char(const stringkey_t & key, size_t depth)
+{
+	return depth < key.length ? (uint32_t)(uint8_t)key.chars[depth] + 1 : 0;
+}
+
+static inline void stringsort_swap(stringkey_t * keys, size_t a, size_t b)
+{
+	stringkey_t t = keys[a];
+	keys[a] = keys[b];
+	keys[b] = t;
+}
+
+int stringsort_compare(const stringkey_t & a, const stringkey_t & b)
+{
+	uint32_t length = a.length < b.length ? a.length : b.length;
+	int order = length ? memcmp(a.chars, b.chars, length) : 0;
+	return order ? order : (a.length > b.length) - (a.length < b.length);
+}
+
+bool stringsort_sorted(const stringkey_t * keys, size_t count)
+{
+	for(size_t i = 1; i < count; ++i)
+		if(stringsort_compare(keys[i - 1], keys[i]) > 0)
+			return false;
+	return true;
+}
+
+// the keys share their first depth bytes and are at least that long
+static inline bool stringsort_less(const stringkey_t & a, const stringkey_t & b, size_t depth)
+{
+	size_t length = (a.length < b.length ? a.length : b.length) - depth;
+	int order = length ? memcmp(a.chars + depth, b.chars + depth, length) : 0;
+	return order ? order < 0 : a.length < b.length;
+}
+
+static void stringsort_insertion(stringkey_t * keys, size_t count, size_t depth)
+{
+	for(size_t i = 1; i < count; ++i)
+	{
+		stringkey_t key = keys[i];
+		size_t j = i;
+		for(; j > 0 && stringsort_less(key, keys[j - 1], depth); --j)
+			keys[j] = keys[j - 1];
+		keys[j] = key;
+	}
+}
+
+// how many bytes from depth on every key shares with first, at most common
+// compared 8 bytes at a time, the lowest set bit of the difference is the first byte that differs
+static size_t stringsort_common(const stringkey_t & first, const stringkey_t * keys, size_t count, size_t depth, size_t common)
+{
+	for(size_t i = 0; i < count && common; ++i)
+	{
+		size_t limit = keys[i].length - depth < common ? keys[i].length - depth : common;
+		const char * a = first.chars + depth;
+		const char * b = keys[i].chars + depth;
+		size_t j = 0;
+		uint64_t diff = 0;
+		for(; j + 8 <= limit; j += 8)
+		{
+			uint64_t x, y;
+			memcpy(&x, a + j, sizeof(x));
+			memcpy(&y, b + j, sizeof(y));
+			diff = x ^ y;
+			if(diff)
+				break;
+		}
+		if(diff)
+			j += __builtin_ctzll(diff) / 8;
+		else
+			while(j < limit && a[j] == b[j])
+				++j;
+		common = j;
+	}
+	return common;
+}
+
+static void stringsort_multikey_range(stringkey_t * keys, size_t count, size_t depth)
+{
+	while(count > stringsort_insertion_count)
+	{
+		uint32_t a = stringsort_char(keys[0], depth);
+		uint32_t b = stringsort_char(keys[count / 2], depth);
+		uint32_t c = stringsort_char(keys[count - 1], depth);
+		uint32_t pivot = a < b ? (b < c ? b : a < c ? c : a) : (a < c ? a : b < c ? c : b);
+
+		// [0, lt) below the pivot byte, [lt, i) equal, [gt, count) above
+		size_t lt = 0, i = 0, gt = count;
+		while(i < gt)
+		{
+			uint32_t ch = stringsort_char(keys[i], depth);
+			if(ch < pivot)
+				stringsort_swap(keys, lt++, i++);
+			else if(ch > pivot)
+				stringsort_swap(keys, i, --gt);
+			else
+				++i;
+		}
+		// all equal: done when they all ended, else past every byte they share in one go
+		if(lt == 0 && gt == count)
+		{
+			if(!pivot)
+				return;
+			depth += 1 + stringsort_common(keys[0], keys + 1, count - 1, depth + 1, keys[0].length - depth - 1);
+			continue;
+		}
+
+		// the smaller parts recursively, the largest in this loop keeps the stack at log n
+		struct {stringkey_t * keys; size_t count; size_t depth;} parts[3] =
+		{
+			{keys, lt, depth},
+			{keys + lt, pivot ? gt - lt : 0, depth + 1},
+			{keys + gt, count - gt, depth},
+		};
+		uint32_t largest = 0;
+		for(uint32_t p = 1; p < 3; ++p)
+			largest = parts[p].count > parts[largest].count ? p : largest;
+		for(uint32_t p = 0; p < 3; ++p)
+			if(p != largest && parts[p].count > 1)
+				stringsort_multikey_range(parts[p].keys, parts[p].count, parts[p].depth);
+		keys = parts[largest].keys;
+		count = parts[largest].count;
+		depth = parts[largest].depth;
+	}
+	stringsort_insertion(keys, count, depth);
+}
+
+// keys end up sorted in place, scratch and cache are as long as keys
+static void stringsort_radix_range(stringkey_t * keys, stringkey_t * scratch, uint16_t * cache, size_t count, size_t depth)
+{
+	size_t counts[stringsort_buckets];
+	size_t starts[stringsort_buckets];
+	while(count > stringsort_multikey_count)
+	{
+		// the byte of every key read once, counted and kept for the scatter
+		memset(counts, 0, sizeof(counts));
+		for(size_t i = 0; i < count; ++i)
+		{
+			cache[i] = (uint16_t)stringsort_char(keys[i], depth);
+			++counts[cache[i]];
+		}
+		if(counts[cache[0]] == count)
+		{
+			if(!cache[0])
+				return;
+			depth += 1 + stringsort_common(keys[0], keys + 1, count - 1, depth + 1, keys[0].length - depth - 1);
+			continue;
+		}
+
+		size_t offset = 0;
+		for(uint32_t b = 0; b < stringsort_buckets; ++b)
+		{
+			starts[b] = offset;
+			offset += counts[b];
+		}
+		for(size_t i = 0; i < count; ++i)
+			scratch[starts[cache[i]]++] = keys[i];
+		memcpy(keys, scratch, count * sizeof(stringkey_t));
+
+		// starts moved to the bucket ends, bucket 0 holds equal keys and stays as is
+		uint32_t largest = 1;
+		for(uint32_t b = 2; b < stringsort_buckets; ++b)
+			largest = counts[b] > counts[largest] ? b : largest;
+		for(uint32_t b = 1; b < stringsort_buckets; ++b)
+		{
+			size_t start = starts[b] - counts[b];
+			if(b != largest && counts[b] > 1)
+				stringsort_radix_range(keys + start, scratch + start, cache + start, counts[b], depth + 1);
+		}
+		size_t start = starts[largest] - counts[largest];
+		keys += start;
+		scratch += start;
+		cache += start;
+		count = counts[largest];
+		++depth;
+	}
+	stringsort_multikey_range(keys, count, depth);
+}
+
+// the same steps as stringsort_radix_range on a range longer than grain, with
+// counting, scatter and copy back in chunks over the pool and the buckets forked
+static void stringsort_radix_split(taskpool_t & pool, stringkey_t * keys, stringkey_t * scratch, uint16_t * cache, size_t count, size_t depth, size_t grain)
+{
+	if(count <= grain)
+	{
+		stringsort_radix_range(keys, scratch, cache, count, depth);
+		return;
+	}
+	size_t chunks = (size_t)pool.threads * 4;
+	size_t chunk = (count + chunks - 1) / chunks;
+	chunks = (count + chunk - 1) / chunk;
+	// a histogram per chunk, turned into the chunk's write positions per bucket
+	size_t * histograms = (size_t*)malloc(chunks * stringsort_buckets * sizeof(size_t));
+	size_t counts[stringsort_buckets];
+	for(;;)
+	{
+		tasks_parallel_for(pool, 0, chunks, 1, [&](size_t first, size_t last)
+		{
+			for(size_t c = first; c < last; ++c)
+			{
+				size_t * histogram = histograms + c * stringsort_buckets;
+				memset(histogram, 0, stringsort_buckets * sizeof(size_t));
+				size_t end = (c + 1) * chunk < count ? (c + 1) * chunk : count;
+				for(size_t i = c * chunk; i < end; ++i)
+				{
+					cache[i] = (uint16_t)stringsort_char(keys[i], depth);
+					++histogram[cache[i]];
+				}
+			}
+		});
+		memset(counts, 0, sizeof(counts));
+		for(size_t c = 0; c < chunks; ++c)
+			for(uint32_t b = 0; b < stringsort_buckets; ++b)
+				counts[b] += histograms[c * stringsort_buckets + b];
+		if(counts[cache[0]] != count)
+			break;
+		if(!cache[0])
+		{
+			free(histograms);
+			return;
+		}
+		// shared bytes per chunk against the first key, the smallest run holds for all
+		size_t * commons = (size_t*)malloc(chunks * sizeof(size_t));
+		tasks_parallel_for(pool, 0, chunks, 1, [&](size_t first, size_t last)
+		{
+			for(size_t c = first; c < last; ++c)
+			{
+				size_t end = (c + 1) * chunk < count ? (c + 1) * chunk : count;
+				commons[c] = stringsort_common(keys[0], keys + c * chunk, end - c * chunk, depth + 1, keys[0].length - depth - 1);
+			}
+		});
+		size_t common = commons[0];
+		for(size_t c = 1; c < chunks; ++c)
+			common = commons[c] < common ? commons[c] : common;
+		free(commons);
+		depth += 1 + common;
+	}
+
+	size_t starts[stringsort_buckets];
+	size_t offset = 0;
+	for(uint32_t b = 0; b < stringsort_buckets; ++b)
+	{
+		starts[b] = offset;
+		for(size_t c = 0; c < chunks; ++c)
+		{
+			size_t n = histograms[c * stringsort_buckets + b];
+			histograms[c * stringsort_buckets + b] = offset;
+			offset += n;
+		}
+	}
+	tasks_parallel_for(pool, 0, chunks, 1, [&](size_t first, size_t last)
+	{
+		for(size_t c = first; c < last; ++c)
+		{
+			size_t * positions = histograms + c * stringsort_buckets;
+			size_t end = (c + 1) * chunk < count ? (c + 1) * chunk : count;
+			for(size_t i = c * chunk; i < end; ++i)
+				scratch[positions[cache[i]]++] = keys[i];
+		}
+	});
+	free(histograms);
+	tasks_parallel_for(pool, 0, count, chunk, [&](size_t first, size_t last)
+	{
+		memcpy(keys + first, scratch + first, (last - first) * sizeof(stringkey_t));
+	});
+
+	taskgroup_t group(pool);
+	for(uint32_t b = 1; b < stringsort_buckets; ++b)
+	{
+		size_t start = starts[b];
+		size_t size = counts[b];
+		if(size > 1)
+			group.spawn([&pool, keys, scratch, cache, start, size, depth, grain]()
+			{
+				stringsort_radix_split(pool, keys + start, scratch + start, cache + start, size, depth + 1, grain);
+			});
+	}
+	group.sync();
+}
+
+void stringsort_radix(stringkey_t * keys, size_t count)
+{
+	if(count < 2)
+		return;
+	stringkey_t * scratch = (stringkey_t*)malloc(count * sizeof(stringkey_t));
+	uint16_t * cache = (uint16_t*)malloc(count * sizeof(uint16_t));
+	stringsort_radix_range(keys, scratch, cache, count, 0);
+	free(scratch);
+	free(cache);
+}
+
+void stringsort_multikey(stringkey_t * keys, size_t count)
+{
+	if(count > 1)
+		stringsort_multikey_range(keys, count, 0);
+}
+
+void stringsort_radix(stringkey_t * keys, size_t count, taskpool_t & pool, size_t grain)
+{
+	if(count < 2)
+		return;
+	stringkey_t * scratch = (stringkey_t*)malloc(count * sizeof(stringkey_t));
+	uint16_t * cache = (uint16_t*)malloc(count * sizeof(uint16_t));
+	stringsort_radix_split(pool, keys, scratch, cache, count, 0, grain ? grain : 1);
+	free(scratch);
+	free(cache);
+}
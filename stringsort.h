@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// sorts of variable length keys held as (pointer, length) records, only the
+// records move, the bytes they point at stay where they are
+// order is by unsigned bytes, a proper prefix before the longer key
+
+struct stringkey_t
+{
+	const char * chars;
+	uint32_t length;
+};
+
+struct taskpool_t;
+
+// < 0, 0 or > 0 like memcmp
+int stringsort_compare(const stringkey_t & a, const stringkey_t & b);
+bool stringsort_sorted(const stringkey_t * keys, size_t count);
+
+// msd radix sort, every range caches the byte it splits on next to the records
+// so the counting and the scatter read the keys once, runs of bytes shared by a
+// whole range are skipped in one pass, small ranges go to the multikey quicksort
+void stringsort_radix(stringkey_t * keys, size_t count);
+// three way radix quicksort (bentley, sedgewick) on one byte at a time,
+// splits around the byte present instead of 256 buckets, better on skewed alphabets
+void stringsort_multikey(stringkey_t * keys, size_t count);
+// the radix sort with ranges longer than grain counted and scattered in
+// parallel chunks, every bucket of such a range a task of its own
+void stringsort_radix(stringkey_t * keys, size_t count, taskpool_t & pool, size_t grain = 1 << 16);
@@ -0,0 +1,178 @@
+#include "tasks.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// yields before an idle worker goes to sleep
+static const uint32_t tasks_idle_spins = 64;
+
+static thread_local const taskpool_t * tasks_pool = nullptr;
+static thread_local uint32_t tasks_index = 0;
+
+// chase-lev deque, fixed size version of "correct and efficient work-stealing
+// for weak memory models" (le et al.)
+
+bool taskdeque_t::push(task_t * task)
+{
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+	if(b - t >= capacity)
+		return false;
+	items[b & (capacity - 1)].store(task, std::memory_order_relaxed);
+	// release so a thief that sees the new bottom also sees the task
+	bottom.store(b + 1, std::memory_order_release);
+	return true;
+}
+
+task_t * taskdeque_t::pop()
+{
+	// seq_cst store then load instead of the paper's fence, same order and
+	// something thread sanitizer understands
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_seq_cst);
+	if(t > b)
+	{
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	task_t * task = items[b & (capacity - 1)].load(std::memory_order_relaxed);
+	// the last task, a thief may be taking it at the same time
+	if(t == b)
+	{
+		if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			task = nullptr;
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+	return task;
+}
+
+task_t * taskdeque_t::steal()
+{
+	int64_t t = top.load(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_seq_cst);
+	if(t >= b)
+		return nullptr;
+	task_t * task = items[t & (capacity - 1)].load(std::memory_order_relaxed);
+	if(!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+	return task;
+}
+
+taskpool_t::taskpool_t(uint32_t threads, bool pin)
+{
+	threads = threads ? threads : std::thread::hardware_concurrency();
+	this->threads = threads ? threads : 1;
+	deques = new taskdeque_t[this->threads];
+	workers = new std::thread[this->threads - 1];
+	for(uint32_t t = 1; t < this->threads; ++t)
+		workers[t - 1] = std::thread([this, t, pin]() {work(t, pin);});
+}
+
+taskpool_t::~taskpool_t()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stop.store(true);
+	}
+	wakeup.notify_all();
+	for(uint32_t t = 1; t < threads; ++t)
+		workers[t - 1].join();
+	delete[] workers;
+	delete[] deques;
+}
+
+uint32_t taskpool_t::self() const
+{
+	// outside threads use worker 0
+	return tasks_pool == this ? tasks_index : 0;
+}
+
+void taskpool_t::push(task_t * task)
+{
+	if(!deques[self()].push(task))
+	{
+		execute(task);
+		return;
+	}
+	// seq_cst on both sides: either a worker about to sleep sees the new
+	// epoch, or this sees it counted as a sleeper and wakes it
+	epoch.fetch_add(1);
+	if(sleepers.load())
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		wakeup.notify_one();
+	}
+}
+
+task_t * taskpool_t::find(uint32_t index)
+{
+	task_t * task = deques[index].pop();
+	// victims round robin from a neighbour, so thieves spread out
+	for(uint32_t i = 1; !task && i < threads; ++i)
+		task = deques[(index + i) % threads].steal();
+	return task;
+}
+
+void taskpool_t::execute(task_t * task)
+{
+	taskgroup_t * group = task->group;
+	task->run(task);
+	group->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void taskpool_t::work(uint32_t index, bool pin)
+{
+	tasks_pool = this;
+	tasks_index = index;
+	#if defined(__linux__)
+	if(pin)
+	{
+		uint32_t cores = std::thread::hardware_concurrency();
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(index % (cores ? cores : 1), &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+	}
+	#else
+	(void)pin;
+	#endif
+
+	uint32_t idle = 0;
+	while(!stop.load(std::memory_order_relaxed))
+	{
+		uint64_t seen = epoch.load();
+		task_t * task = find(index);
+		if(task)
+		{
+			execute(task);
+			idle = 0;
+			continue;
+		}
+		if(++idle < tasks_idle_spins)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(mutex);
+		sleepers.fetch_add(1);
+		wakeup.wait(lock, [&]() {return stop.load() || epoch.load() != seen;});
+		sleepers.fetch_sub(1);
+		idle = 0;
+	}
+}
+
+void taskgroup_t::sync()
+{
+	uint32_t index = pool.self();
+	while(pending.load(std::memory_order_acquire))
+	{
+		task_t * task = pool.find(index);
+		if(task)
+			pool.execute(task);
+		else
+			std::this_thread::yield();
+	}
+}
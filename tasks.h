@@ -0,0 +1,136 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// fork join on a pool of workers with a chase-lev deque each: a worker pushes
+// and pops its own end, idle workers steal the oldest (largest) task from the
+// other end, and a sync helps with whatever work it finds until its group is done
+
+struct taskgroup_t;
+
+struct task_t
+{
+	void (*run)(task_t * task); // runs and deletes the task
+	taskgroup_t * group;
+};
+
+template<typename function_t>
+struct taskclosure_t : task_t
+{
+	function_t function;
+
+	taskclosure_t(function_t function, taskgroup_t * group) : function(function)
+	{
+		this->run = [](task_t * task)
+		{
+			taskclosure_t * closure = (taskclosure_t*)task;
+			closure->function();
+			delete closure;
+		};
+		this->group = group;
+	}
+};
+
+// fixed size chase-lev deque, push refuses when full and the task runs inline
+struct taskdeque_t
+{
+	static const int64_t capacity = 1 << 13;
+
+	alignas(64) std::atomic<int64_t> top{0};
+	alignas(64) std::atomic<int64_t> bottom{0};
+	std::atomic<task_t*> items[capacity];
+
+	// owner only
+	bool push(task_t * task);
+	task_t * pop();
+	// any thread
+	task_t * steal();
+};
+
+// threads counts the thread that spawns and syncs as worker 0, so threads - 1
+// are started, pin binds those to cores round robin (linux only)
+// one outside thread drives a pool at a time, tasks may spawn freely
+struct taskpool_t
+{
+	uint32_t threads = 1;
+
+	taskpool_t(uint32_t threads = 0, bool pin = false);
+	~taskpool_t();
+	taskpool_t(const taskpool_t &) = delete;
+	taskpool_t & operator=(const taskpool_t &) = delete;
+
+	// private
+	taskdeque_t * deques = nullptr;
+	std::thread * workers = nullptr;
+	std::atomic<bool> stop{false};
+	// bumped on every push, idle workers sleep until it moves
+	std::atomic<uint64_t> epoch{0};
+	std::atomic<uint32_t> sleepers{0};
+	std::mutex mutex;
+	std::condition_variable wakeup;
+
+	uint32_t self() const;
+	void push(task_t * task);
+	task_t * find(uint32_t index);
+	void execute(task_t * task);
+	void work(uint32_t index, bool pin);
+};
+
+struct taskgroup_t
+{
+	taskpool_t & pool;
+	std::atomic<uint32_t> pending{0};
+
+	explicit taskgroup_t(taskpool_t & pool) : pool(pool) {}
+	~taskgroup_t() {sync();}
+	taskgroup_t(const taskgroup_t &) = delete;
+	taskgroup_t & operator=(const taskgroup_t &) = delete;
+
+	// function() later on any worker, on a pool of one thread right away
+	template<typename function_t>
+	void spawn(function_t function)
+	{
+		if(pool.threads == 1)
+		{
+			function();
+			return;
+		}
+		pending.fetch_add(1, std::memory_order_relaxed);
+		pool.push(new taskclosure_t<function_t>(function, this));
+	}
+	// every task spawned on the group has finished
+	void sync();
+};
+
+// function(first, last) over chunks of at most grain covering [first, last),
+// halves are split off into tasks so thieves take big pieces
+template<typename function_t>
+void tasks_parallel_for(taskpool_t & pool, size_t first, size_t last, size_t grain, const function_t & function)
+{
+	grain = grain ? grain : 1;
+	taskgroup_t group(pool);
+	while(last > first && last - first > grain)
+	{
+		size_t middle = first + (last - first) / 2;
+		group.spawn([&pool, middle, last, grain, &function]() {tasks_parallel_for(pool, middle, last, grain, function);});
+		last = middle;
+	}
+	if(first < last)
+		function(first, last);
+	group.sync();
+}
+
+// first() and second() in parallel, second is the one offered to thieves
+template<typename first_t, typename second_t>
+void tasks_parallel_invoke(taskpool_t & pool, const first_t & first, const second_t & second)
+{
+	taskgroup_t group(pool);
+	group.spawn([&second]() {second();});
+	first();
+	group.sync();
+}
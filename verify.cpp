@@ -0,0 +1,131 @@
+#include "verify.h"
+#include "containers.h"
+#include "workload.h"
+#include <atomic>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// below this many items a thread costs more than it saves
+static const size_t verify_parallel_min = 1 << 16;
+// sorted checks look at the early out flag once per this many pairs
+static const size_t verify_chunk = 1 << 12;
+
+static uint32_t verify_threads(size_t count, uint32_t threads)
+{
+	return count < verify_parallel_min ? 1 : containers_threads(threads);
+}
+
+// pairs (i, i + 1) for i in [first, last)
+static bool verify_sorted_range(const uint32_t * items, size_t first, size_t last)
+{
+	size_t i = first;
+	#if defined(__AVX2__)
+	// a <= b exactly where max(a, b) == b, so all ones in every lane of a sorted step
+	__m256i all = _mm256_set1_epi32(-1);
+	for(; i + verify_chunk <= last; )
+	{
+		__m256i sorted = all;
+		for(size_t end = i + verify_chunk; i < end; i += 8)
+		{
+			__m256i a = _mm256_loadu_si256((const __m256i*)(items + i));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(items + i + 1));
+			sorted = _mm256_and_si256(sorted, _mm256_cmpeq_epi32(_mm256_max_epu32(a, b), b));
+		}
+		if(!_mm256_testc_si256(sorted, all))
+			return false;
+	}
+	#endif
+	// no branch per pair, the compiler vectorizes this without avx2 too
+	uint32_t unsorted = 0;
+	for(; i < last; ++i)
+		unsorted |= items[i] > items[i + 1];
+	return !unsorted;
+}
+
+bool verify_sorted(const uint32_t * items, size_t count, uint32_t threads)
+{
+	if(count < 2)
+		return true;
+	size_t pairs = count - 1;
+	threads = verify_threads(count, threads);
+	if(threads == 1)
+		return verify_sorted_range(items, 0, pairs);
+
+	// threads stop early once any of them found a descent
+	std::atomic<bool> sorted(true);
+	containers_parallel(threads, [&](uint32_t t)
+	{
+		size_t first = (size_t)((uint64_t)pairs * t / threads);
+		size_t last = (size_t)((uint64_t)pairs * (t + 1) / threads);
+		for(size_t i = first; i < last && sorted.load(std::memory_order_relaxed); i += verify_chunk * 16)
+		{
+			size_t end = last - i < verify_chunk * 16 ? last : i + verify_chunk * 16;
+			if(!verify_sorted_range(items, i, end))
+				sorted.store(false, std::memory_order_relaxed);
+		}
+	});
+	return sorted.load();
+}
+
+static void verify_fingerprint_range(const uint32_t * items, size_t first, size_t last, uint32_t a, uint32_t b, uint64_t & sum, uint64_t & mixed)
+{
+	size_t i = first;
+	#if defined(__AVX2__)
+	// mul_epu32 multiplies the low halves of 64 bit lanes, odd items are shifted down
+	__m256i va = _mm256_set1_epi32((int)a), vb = _mm256_set1_epi64x(b);
+	__m256i vsum = _mm256_setzero_si256(), vmixed = _mm256_setzero_si256();
+	for(; i + 8 <= last; i += 8)
+	{
+		__m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(items + i)), va);
+		__m256i even = _mm256_mul_epu32(x, vb);
+		__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), vb);
+		vsum = _mm256_add_epi64(vsum, _mm256_add_epi64(even, odd));
+		vmixed = _mm256_add_epi64(vmixed, _mm256_mul_epu32(even, _mm256_srli_epi64(even, 32)));
+		vmixed = _mm256_add_epi64(vmixed, _mm256_mul_epu32(odd, _mm256_srli_epi64(odd, 32)));
+	}
+	uint64_t lanes[4];
+	_mm256_storeu_si256((__m256i*)lanes, vsum);
+	sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	_mm256_storeu_si256((__m256i*)lanes, vmixed);
+	mixed += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	#endif
+	for(; i < last; ++i)
+	{
+		uint64_t h = (uint64_t)(items[i] ^ a) * b;
+		sum += h;
+		mixed += (h & 0xffffffffu) * (h >> 32);
+	}
+}
+
+verifyfingerprint_t verify_fingerprint(const uint32_t * items, size_t count, uint64_t seed, uint32_t threads)
+{
+	// b odd and large so h is one to one and spreads into the high half
+	uint64_t state = seed;
+	uint32_t a = (uint32_t)splitmix64(state);
+	uint32_t b = (uint32_t)splitmix64(state) | 0x80000001u;
+	verifyfingerprint_t fingerprint = {count, 0, 0};
+	threads = verify_threads(count, threads);
+	if(threads == 1)
+	{
+		verify_fingerprint_range(items, 0, count, a, b, fingerprint.sum, fingerprint.mixed);
+		return fingerprint;
+	}
+
+	// sums commute, so the split does not change the result
+	uint64_t * partial = new uint64_t[threads * 2]();
+	containers_parallel(threads, [&](uint32_t t)
+	{
+		size_t first = (size_t)((uint64_t)count * t / threads);
+		size_t last = (size_t)((uint64_t)count * (t + 1) / threads);
+		verify_fingerprint_range(items, first, last, a, b, partial[t * 2], partial[t * 2 + 1]);
+	});
+	for(uint32_t t = 0; t < threads; ++t)
+	{
+		fingerprint.sum += partial[t * 2];
+		fingerprint.mixed += partial[t * 2 + 1];
+	}
+	delete[] partial;
+	return fingerprint;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// checks for sort output, cheap enough to run after every sort in benchmarks
+// and randomized tests, threads 0 for all cores
+
+// items[i] <= items[i + 1] for every i, 8 neighbour pairs a step with avx2
+bool verify_sorted(const uint32_t * items, size_t count, uint32_t threads = 0);
+
+// order independent multiset hash, sums of a non linear per item hash
+// equal multisets always match, a lost or duplicated item changes it
+struct verifyfingerprint_t
+{
+	uint64_t count;
+	uint64_t sum;   // of h(x) = (x ^ a) * b
+	uint64_t mixed; // of low(h(x)) * high(h(x))
+
+	bool operator==(const verifyfingerprint_t & other) const
+	{
+		return count == other.count && sum == other.sum && mixed == other.mixed;
+	}
+	bool operator!=(const verifyfingerprint_t & other) const {return !(*this == other);}
+};
+
+// a and b come from seed, a seed per run keeps crafted collisions out
+verifyfingerprint_t verify_fingerprint(const uint32_t * items, size_t count, uint64_t seed = 0, uint32_t threads = 0);
+
+// fingerprint the input with expect, sort it, then check the output:
+// sorted and still the same multiset
+struct verifier_t
+{
+	verifyfingerprint_t expected = {0, 0, 0};
+	uint64_t seed = 0;
+	uint32_t threads = 0;
+
+	verifier_t(uint64_t seed = 0, uint32_t threads = 0) : seed(seed), threads(threads) {}
+	void expect(const uint32_t * items, size_t count) {expected = verify_fingerprint(items, count, seed, threads);}
+	bool check(const uint32_t * items, size_t count) const
+	{
+		return verify_sorted(items, count, threads) && verify_fingerprint(items, count, seed, threads) == expected;
+	}
+};
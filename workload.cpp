@@ -0,0 +1,221 @@
+#include "workload.h"
+#include "containers.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// items per block, every block has its own streams so threads split blocks freely
+static const size_t workload_block_size = 1 << 16;
+static std::atomic<uint64_t> workload_thread_count(0);
+
+xoshiro256_t & workload_local()
+{
+	static thread_local xoshiro256_t rng(0x6c6574736c6561ull ^ workload_thread_count.fetch_add(1) * 0xd1b54a32d192ed03ull);
+	return rng;
+}
+
+void workload_seed(uint64_t seed)
+{
+	workload_local().seed(seed);
+}
+
+workloadzipf_t::workloadzipf_t(uint32_t universe, double skew) : universe(universe ? universe : 1), skew(skew)
+{
+	h_x1 = h_integral(1.5) - 1.0;
+	h_n = h_integral(this->universe + 0.5);
+	s = 2.0 - h_integral_inverse(h_integral(2.5) - h(2.0));
+}
+
+uint32_t workloadzipf_t::operator()(xoshiro256_t & rng) const
+{
+	// ranks are 1 based in here, accepted within a couple of tries on average
+	for(;;)
+	{
+		double u = h_n + rng.real() * (h_x1 - h_n);
+		double x = h_integral_inverse(u);
+		double k = floor(x + 0.5);
+		k = k < 1.0 ? 1.0 : (k > universe ? universe : k);
+		if(k - x <= s || u >= h_integral(k + 0.5) - h(k))
+			return (uint32_t)k - 1;
+	}
+}
+
+double workloadzipf_t::h(double x) const
+{
+	return exp(-skew * log(x));
+}
+
+double workloadzipf_t::h_integral(double x) const
+{
+	// (x^(1 - skew) - 1) / (1 - skew), log x where skew is 1
+	double log_x = log(x);
+	double t = (1.0 - skew) * log_x;
+	return (fabs(t) > 1e-8 ? expm1(t) / t : 1.0 + t * 0.5 * (1.0 + t / 3.0 * (1.0 + 0.25 * t))) * log_x;
+}
+
+double workloadzipf_t::h_integral_inverse(double x) const
+{
+	double t = x * (1.0 - skew);
+	t = t < -1.0 ? -1.0 : t;
+	return exp((fabs(t) > 1e-8 ? log1p(t) / t : 1.0 - t * (0.5 - t * (1.0 / 3.0 - 0.25 * t))) * x);
+}
+
+// count raw words of block, 4 xoshiro256** streams side by side, a step
+// yields one 64 bit word per stream, stored low half first
+// a bound scales every word into [0, bound) on the way out
+static void workload_words(uint32_t * out, size_t count, uint64_t seed, uint64_t block, uint32_t bound = 0)
+{
+	uint64_t state = seed ^ block * 0xd1b54a32d192ed03ull;
+	uint64_t s[4][4]; // [word][stream]
+	for(uint32_t i = 0; i < 4; ++i)
+		for(uint32_t lane = 0; lane < 4; ++lane)
+			s[i][lane] = splitmix64(state);
+
+	size_t i = 0;
+	#if defined(__AVX2__)
+	// the multiplies by 5 and 9 are shift adds, avx2 has no 64 bit multiply
+	__m256i s0 = _mm256_loadu_si256((const __m256i*)s[0]), s1 = _mm256_loadu_si256((const __m256i*)s[1]);
+	__m256i s2 = _mm256_loadu_si256((const __m256i*)s[2]), s3 = _mm256_loadu_si256((const __m256i*)s[3]);
+	__m256i vbound = _mm256_set1_epi64x(bound), high = _mm256_set1_epi64x((long long)0xffffffff00000000ull);
+	for(; i + 8 <= count; i += 8)
+	{
+		__m256i x = _mm256_add_epi64(s1, _mm256_slli_epi64(s1, 2));
+		x = _mm256_or_si256(_mm256_slli_epi64(x, 7), _mm256_srli_epi64(x, 57));
+		x = _mm256_add_epi64(x, _mm256_slli_epi64(x, 3));
+		if(bound)
+		{
+			// both 32 bit halves times bound, the high half of each product is the result
+			__m256i low_product = _mm256_mul_epu32(x, vbound);
+			__m256i high_product = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), vbound);
+			x = _mm256_or_si256(_mm256_srli_epi64(low_product, 32), _mm256_and_si256(high_product, high));
+		}
+		_mm256_storeu_si256((__m256i*)(out + i), x);
+		__m256i t = _mm256_slli_epi64(s1, 17);
+		s2 = _mm256_xor_si256(s2, s0);
+		s3 = _mm256_xor_si256(s3, s1);
+		s1 = _mm256_xor_si256(s1, s2);
+		s0 = _mm256_xor_si256(s0, s3);
+		s2 = _mm256_xor_si256(s2, t);
+		s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+	}
+	_mm256_storeu_si256((__m256i*)s[0], s0);
+	_mm256_storeu_si256((__m256i*)s[1], s1);
+	_mm256_storeu_si256((__m256i*)s[2], s2);
+	_mm256_storeu_si256((__m256i*)s[3], s3);
+	#endif
+	// same streams in the same order without avx2, and the tail of a block
+	for(; i < count; i += 8)
+	{
+		uint64_t words[4];
+		for(uint32_t lane = 0; lane < 4; ++lane)
+		{
+			uint64_t x = s[1][lane] * 5;
+			words[lane] = (x << 7 | x >> 57) * 9;
+			if(bound)
+				words[lane] = ((uint64_t)(uint32_t)words[lane] * bound) >> 32 | (((words[lane] >> 32) * bound) & 0xffffffff00000000ull);
+			uint64_t t = s[1][lane] << 17;
+			s[2][lane] ^= s[0][lane];
+			s[3][lane] ^= s[1][lane];
+			s[1][lane] ^= s[2][lane];
+			s[0][lane] ^= s[3][lane];
+			s[2][lane] ^= t;
+			s[3][lane] = s[3][lane] << 45 | s[3][lane] >> 19;
+		}
+		memcpy(out + i, words, (count - i < 8 ? count - i : 8) * sizeof(uint32_t));
+	}
+}
+
+// fill(out, first, size, block, rng) for every block, rng is a stream of the
+// block for draws past the raw words
+template<typename fill_t>
+static void workload_fill(uint32_t * out, size_t count, uint64_t seed, uint32_t threads, fill_t fill)
+{
+	size_t blocks = (count + workload_block_size - 1) / workload_block_size;
+	threads = containers_threads(threads);
+	threads = blocks < threads ? (blocks ? (uint32_t)blocks : 1) : threads;
+	containers_parallel(threads, [&](uint32_t t)
+	{
+		for(size_t block = t; block < blocks; block += threads)
+		{
+			size_t first = block * workload_block_size;
+			size_t size = count - first < workload_block_size ? count - first : workload_block_size;
+			xoshiro256_t rng(seed ^ ~block * 0x9e3779b97f4a7c15ull);
+			fill(out + first, first, size, block, rng);
+		}
+	});
+}
+
+void workload_uniform(uint32_t * out, size_t count, uint64_t seed, uint32_t bound, uint32_t threads)
+{
+	workload_fill(out, count, seed, threads, [=](uint32_t * items, size_t, size_t size, uint64_t block, xoshiro256_t &)
+	{
+		workload_words(items, size, seed, block, bound);
+	});
+}
+
+void workload_zipf(uint32_t * out, size_t count, uint64_t seed, uint32_t universe, double skew, uint32_t threads)
+{
+	workloadzipf_t zipf(universe, skew);
+	workload_fill(out, count, seed, threads, [&zipf](uint32_t * items, size_t, size_t size, uint64_t, xoshiro256_t & rng)
+	{
+		for(size_t i = 0; i < size; ++i)
+			items[i] = zipf(rng);
+	});
+}
+
+void workload_sorted(uint32_t * out, size_t count, uint64_t seed, double noise, uint32_t threads)
+{
+	double scale = 4294967296.0 / (double)(count ? count : 1);
+	uint32_t threshold = noise >= 1.0 ? UINT32_MAX : (uint32_t)(noise * 4294967296.0);
+	workload_fill(out, count, seed, threads, [=](uint32_t * items, size_t first, size_t size, uint64_t block, xoshiro256_t & rng)
+	{
+		if(!threshold)
+		{
+			for(size_t i = 0; i < size; ++i)
+				items[i] = (uint32_t)((double)(first + i) * scale);
+			return;
+		}
+		// the raw words pick the noisy items, the block stream their values
+		workload_words(items, size, seed, block);
+		for(size_t i = 0; i < size; ++i)
+			items[i] = items[i] < threshold ? rng.next32() : (uint32_t)((double)(first + i) * scale);
+	});
+}
+
+void workload_few_unique(uint32_t * out, size_t count, uint64_t seed, uint32_t unique, uint32_t threads)
+{
+	unique = unique ? unique : 1;
+	uint32_t * values = (uint32_t*)malloc(unique * sizeof(uint32_t));
+	xoshiro256_t rng(~seed);
+	for(uint32_t i = 0; i < unique; ++i)
+		values[i] = rng.next32();
+	workload_fill(out, count, seed, threads, [=](uint32_t * items, size_t, size_t size, uint64_t block, xoshiro256_t &)
+	{
+		workload_words(items, size, seed, block, unique);
+		for(size_t i = 0; i < size; ++i)
+			items[i] = values[items[i]];
+	});
+	free(values);
+}
+
+void workload_clustered(uint32_t * out, size_t count, uint64_t seed, uint32_t clusters, uint32_t spread, uint32_t threads)
+{
+	clusters = clusters ? clusters : 1;
+	uint32_t * centers = (uint32_t*)malloc(clusters * sizeof(uint32_t));
+	xoshiro256_t rng(~seed);
+	for(uint32_t i = 0; i < clusters; ++i)
+		centers[i] = rng.next32();
+	workload_fill(out, count, seed, threads, [=](uint32_t * items, size_t, size_t size, uint64_t block, xoshiro256_t &)
+	{
+		// high half of a word picks the cluster, low half the offset
+		workload_words(items, size, seed, block);
+		for(size_t i = 0; i < size; ++i)
+			items[i] = centers[((uint64_t)(items[i] >> 16) * clusters) >> 16] + (uint32_t)(((uint64_t)(items[i] & 0xffff) * spread) >> 16);
+	});
+	free(centers);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// random numbers and test / benchmark inputs, replaces rand()
+// every generator is seeded explicitly, the same seed gives the same input
+// whatever the thread count
+
+// seeds the other generators, one seed gives a whole state
+inline uint64_t splitmix64(uint64_t & state)
+{
+	uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+// xoshiro256**, 256 bits of state, the default generator
+struct xoshiro256_t
+{
+	uint64_t s[4];
+
+	xoshiro256_t(uint64_t seed = 0x6c6574736c6561ull) {this->seed(seed);}
+	void seed(uint64_t seed)
+	{
+		for(uint32_t i = 0; i < 4; ++i)
+			s[i] = splitmix64(seed);
+	}
+	uint64_t next()
+	{
+		uint64_t x = s[1] * 5;
+		uint64_t result = (x << 7 | x >> 57) * 9;
+		uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = s[3] << 45 | s[3] >> 19;
+		return result;
+	}
+	uint32_t next32() {return (uint32_t)(next() >> 32);}
+	// in [0, bound), multiply shift, the bias is below bound / 2^32
+	uint32_t below(uint32_t bound) {return (uint32_t)(((uint64_t)next32() * bound) >> 32);}
+	// in [0, 1) with 53 bits
+	double real() {return (double)(next() >> 11) * 0x1.0p-53;}
+};
+
+// pcg32 (xsh rr), 64 bits of state and a stream, for when state size matters
+struct pcg32_t
+{
+	uint64_t state = 0;
+	uint64_t increment = 1;
+
+	pcg32_t(uint64_t seed = 0x6c6574736c6561ull, uint64_t stream = 0) {this->seed(seed, stream);}
+	void seed(uint64_t seed, uint64_t stream = 0)
+	{
+		state = 0;
+		increment = stream << 1 | 1;
+		next();
+		state += seed;
+		next();
+	}
+	uint32_t next()
+	{
+		uint64_t old = state;
+		state = old * 6364136223846793005ull + increment;
+		uint32_t shifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+		uint32_t rotation = (uint32_t)(old >> 59);
+		return shifted >> rotation | shifted << ((32 - rotation) & 31);
+	}
+	uint32_t below(uint32_t bound) {return (uint32_t)(((uint64_t)next() * bound) >> 32);}
+};
+
+// one generator per thread, every thread starts from its own fixed seed
+xoshiro256_t & workload_local();
+void workload_seed(uint64_t seed); // reseeds the generator of the calling thread
+inline uint32_t workload_next() {return workload_local().next32();}
+inline uint32_t workload_below(uint32_t bound) {return workload_local().below(bound);}
+
+// zipf over [0, universe), rank 0 the most frequent, skew > 0
+// rejection inversion (hormann, derflinger), constant time per draw for any universe
+struct workloadzipf_t
+{
+	uint32_t universe;
+	double skew;
+	double h_x1;
+	double h_n;
+	double s;
+
+	workloadzipf_t(uint32_t universe, double skew);
+	uint32_t operator()(xoshiro256_t & rng) const;
+
+	// private
+	double h(double x) const;
+	double h_integral(double x) const;
+	double h_integral_inverse(double x) const;
+};
+
+// bulk fills, out[i] for count items, split in blocks over threads (0 for all cores)
+// raw words come from 4 interleaved xoshiro256** streams per block, 8 words a step with avx2
+
+// uniform in [0, bound), the whole 32 bit range for bound 0
+void workload_uniform(uint32_t * out, size_t count, uint64_t seed, uint32_t bound = 0, uint32_t threads = 0);
+// zipf ranks over [0, universe), see workloadzipf_t
+void workload_zipf(uint32_t * out, size_t count, uint64_t seed, uint32_t universe, double skew = 1.0, uint32_t threads = 0);
+// ascending over the whole range, then a noise fraction of the items replaced by uniform ones
+void workload_sorted(uint32_t * out, size_t count, uint64_t seed, double noise = 0.0, uint32_t threads = 0);
+// only unique different values (at most), drawn uniformly among them
+void workload_few_unique(uint32_t * out, size_t count, uint64_t seed, uint32_t unique, uint32_t threads = 0);
+// uniform around clusters random centers, at most spread away from them
+// clusters and spread are resolved to 16 bits each
+void workload_clustered(uint32_t * out, size_t count, uint64_t seed, uint32_t clusters, uint32_t spread, uint32_t threads = 0);